@@ -63,10 +63,7 @@ project "shado-opengl-api"
 		"GLFW",
 		"GLEW",
 		"ImGui",
-		"gdi32.lib",
-		"opengl32.lib",
-		"box2d",
-		"%{LibDirs.lua}"
+		"box2d"
 	}
 
 	filter "system:windows"
@@ -78,6 +75,31 @@ project "shado-opengl-api"
 		{
 			"SHADO_PLATFORM_WINDOWS", "GLEW_STATIC"
 		}
+
+		links
+		{
+			"gdi32.lib",
+			"opengl32.lib",
+			"winmm.lib",
+			"%{LibDirs.lua}"
+		}
+
+	filter "system:linux"
+		cppdialect "C++17"
+		pic "On"
+
+		defines
+		{
+			"SHADO_PLATFORM_LINUX", "GLEW_STATIC"
+		}
+
+		links
+		{
+			"GL",
+			"lua5.4",
+			"dl",
+			"pthread"
+		}
 	
 		--postbuildcommands
 		--{
@@ -139,6 +161,26 @@ project "sandbox"
 		"SHADO_PLATFORM_WINDOWS"
 	}
 
+	filter "system:linux"
+		cppdialect "C++17"
+
+		defines
+		{
+			"SHADO_PLATFORM_LINUX"
+		}
+
+		links
+		{
+			"GLFW",
+			"GLEW",
+			"ImGui",
+			"box2d",
+			"GL",
+			"lua5.4",
+			"dl",
+			"pthread"
+		}
+
 	filter "configurations:Debug"
 		defines "SHADO_DEBUG"
 		symbols "On"
@@ -4,7 +4,7 @@
 #version 430 core
 
 layout(location = 0) in vec3 a_WorldPosition;
-layout(location = 1) in vec3 a_LocalPosition;
+layout(location = 1) in vec2 a_LocalPosition;
 layout(location = 2) in vec4 a_Color;
 layout(location = 3) in float a_Thickness;
 layout(location = 4) in float a_Fade;
@@ -12,7 +12,7 @@ layout(location = 4) in float a_Fade;
 
 uniform mat4 u_ViewProjection;
 out vec4 v_Color;
-out vec3 v_LocalPosition;
+out vec2 v_LocalPosition;
 out float v_Thickness;
 out float v_Fade;
 
@@ -31,7 +31,7 @@ void main()
 layout(location = 0) out vec4 color;
 
 in vec4 v_Color;
-in vec3 v_LocalPosition;
+in vec2 v_LocalPosition;
 in float v_Thickness;
 in float v_Fade;
 
@@ -5,43 +5,58 @@
 Entity = class(function (this, options)
     options = options or {width = 1, height = 1}
 
-    this.entity = _CreateEntity(_scene, options["width"], options["height"]);
-    this.scene = _scene;
+    -- Wraps an existing entity when given one (see Scene:getEntityByName)
+    if options["entity"] ~= nil then
+        this.entity = options["entity"];
+        this.scene = options["scene"] or _scene;
+    else
+        this.entity = _CreateEntity(_scene, options["width"], options["height"]);
+        this.scene = _scene;
+    end
     this.is_alive = true;
 end)
 
+---Unique id of the entity, stays the same for its whole life
+---@return integer
+function Entity:getId()
+    if self.is_alive then
+        return _GetEntityId(self.scene, self.entity)
+    end
+    return nil
+end
+
 function Entity:setTexture(path)
     if self.is_alive then
-        _SetEntityTexture(self.entity, path)
+        _SetEntityTexture(self.scene, self.entity, path)
     end
 end
 
 function Entity:setTillingFactor(factor)
     if self.is_alive then
-        _SetEntityTillingFactor(self.entity, factor)
+        _SetEntityTillingFactor(self.scene, self.entity, factor)
     end
 end
 
 function Entity:setColor(r, g, b, a)
     if self.is_alive then
-        _SetEntityColor(self.entity, r, g, b, a)
+        _SetEntityColor(self.scene, self.entity, r, g, b, a)
     end   
 end
 
 function Entity:setPosition(x, y)
     if self.is_alive then
-        _SetEntityPosition(self.entity, x, y)
+        _SetEntityPosition(self.scene, self.entity, x, y)
     end
 end
 
 function Entity:setType(type)
     if self.is_alive then
-        _SetEntityType(self.entity, type)
+        _SetEntityType(self.scene, self.entity, type)
     end
 end
 
 function Entity:destroy()
-    if self.is_alive and _DestroyEntity(self.entity, self.scene) then
+    if self.is_alive and _DestroyEntity(self.scene, self.entity) then
         self.is_alive = false;
         self.entity = nil;
     end
@@ -40,3 +40,25 @@ end)
 function Scene:setActive()
     _SetActiveScene(self.scene);
 end
+
+---Finds an entity of the scene by name
+---@param name string
+---@return table Entity an entity object, or nil
+function Scene:getEntityByName(name)
+    local entity = _GetEntityByName(self.scene, name);
+    if entity == nil then
+        return nil;
+    end
+    return Entity({entity = entity, scene = self.scene});
+end
+
+---Finds an entity of the scene by id (see Entity:getId)
+---@param id integer
+---@return table Entity an entity object, or nil
+function Scene:getEntityById(id)
+    local entity = _GetEntityById(self.scene, id);
+    if entity == nil then
+        return nil;
+    end
+    return Entity({entity = entity, scene = self.scene});
+end
@@ -9,3 +9,4 @@ require "scriptcore/event"
 require "scriptcore/window"
 require "scriptcore/scene"
 require "scriptcore/entity"
+require "scriptcore/stats"
@@ -0,0 +1,13 @@
+--- Read the engine's stats (see Stats.h), as of the last frame
+
+Stats = {}
+
+--- e.g. Stats.get("Renderer2D.DrawCalls"), nil if there is no such stat
+Stats.get = function (name)
+    return _GetStat(name);
+end
+
+--- Values of the last frames, oldest first
+Stats.getHistory = function (name)
+    return _GetStatHistory(name);
+end
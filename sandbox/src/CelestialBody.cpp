@@ -96,31 +96,23 @@ void CelestialBody::InitRender(string texture_path)
     std::vector<float> texCoords;
     createSphere(50, 50, vertices, indices, texCoords);
 
-    // Set up the VAO and VBO
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    // Vertex texture coordinates
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-
+    // Interleave the texture coordinates with the positions and normals
+    std::vector<float> interleaved;
+    size_t vertexCount = texCoords.size() / 2;
+    interleaved.reserve(vertexCount * 8);
+    for (size_t i = 0; i < vertexCount; i++) {
+        interleaved.insert(interleaved.end(), vertices.begin() + i * 6, vertices.begin() + i * 6 + 6);
+        interleaved.push_back(texCoords[i * 2]);
+        interleaved.push_back(texCoords[i * 2 + 1]);
+    }
 
-    // Unbind the VAO
-    glBindVertexArray(0);
+    // Every body shares the same buffers, only the ranges differ
+    auto arena = GpuBufferArena::get({
+        { ShaderDataType::Float3, "aPos" },
+        { ShaderDataType::Float3, "aNormal" },
+        { ShaderDataType::Float2, "aTexCoord" }
+    });
+    Mesh = arena->allocate(interleaved.data(), (uint32_t)vertexCount, indices.data(), (uint32_t)indices.size());
 }
 
 void CelestialBody::UpdateForce(vector<CelestialBody>* solarSystem)
@@ -211,8 +203,10 @@ void CelestialBody::UpdateRender(vec3 camPos, Shader* shader)
     //shader->setFloat3("viewPos", camPos);
     shader->setInt("objectTexture", 0);
     // Bind the VAO and draw the sphere
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+    Mesh->getVertexArray()->bind();
+    const auto& indexBuffer = Mesh->getIndexBuffer();
+    glDrawElementsBaseVertex(GL_TRIANGLES, indexBuffer->getCount(), indexBuffer->getType(),
+        (void*)(uintptr_t)indexBuffer->getOffset(), Mesh->getBaseVertex());
 
     Texture->unbind();
 
@@ -43,7 +43,7 @@ public:
 	string name = "russel teapot";
 
 	// Render Section
-	unsigned int VAO, VBO, EBO;
+	Ref<GpuMesh> Mesh;
 	std::vector<unsigned int> indices;
 	Ref<Texture2D> Texture;
 
@@ -74,7 +74,7 @@ public:
 		glGenBuffers(1, &VBO);
 		glGenBuffers(1, &EBO);
 
-		glBindVertexArray(VAO);
+		RenderState::BindVertexArray(VAO);
 
 		glBindBuffer(GL_ARRAY_BUFFER, VBO);
 		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
@@ -93,7 +93,7 @@ public:
 
 
 		// Unbind the VAO
-		glBindVertexArray(0);
+		RenderState::BindVertexArray(0);
 
 
 	}
@@ -118,7 +118,7 @@ public:
 		//shader->setFloat3("viewPos", camPos);
 		shader->setInt("objectTexture", 0);
 		// Bind the VAO and draw the sphere
-		glBindVertexArray(VAO);
+		RenderState::BindVertexArray(VAO);
 		glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
 
 		Texture->unbind();
@@ -1,7 +1,14 @@
 ﻿#include "Shado.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
 #include <iostream>
+#include <random>
+#include <thread>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 #include "script/LuaScript.h"
@@ -236,10 +243,730 @@ private:
 
 
 
+// DynamicBVH with 10k, 100k and 1M unit boxes spread at the same density: inserting them all, moving them
+// all a little (only those leaving their fat AABB are reinserted), then 10k queries of a 10 x 10 region
+static void benchmarkBVH() {
+	auto elapsed = [](std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	};
+	auto box = [](const glm::vec2& min, const glm::vec2& max) {
+		return AABB({ min.x, min.y, 0.0f }, { max.x, max.y, 0.0f });
+	};
+
+	// Same boxes from run to run
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::uniform_real_distribution<float> step(-0.2f, 0.2f);
+
+	for (uint32_t count : { 10000u, 100000u, 1000000u }) {
+		const float worldSize = std::sqrt((float)count) * 4.0f;
+		std::vector<glm::vec2> positions(count);
+		for (glm::vec2& position : positions)
+			position = { unit(random) * worldSize, unit(random) * worldSize };
+
+		DynamicBVH bvh;
+		std::vector<int32_t> proxies(count);
+		auto start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < count; i++)
+			proxies[i] = bvh.createProxy(box(positions[i] - 0.5f, positions[i] + 0.5f), nullptr);
+		const double insertMs = elapsed(start);
+
+		uint32_t reinserted = 0;
+		start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < count; i++) {
+			const glm::vec2 displacement = { step(random), step(random) };
+			positions[i] += displacement;
+			reinserted += bvh.moveProxy(proxies[i], box(positions[i] - 0.5f, positions[i] + 0.5f), { displacement.x, displacement.y, 0.0f }) ? 1 : 0;
+		}
+		const double moveMs = elapsed(start);
+
+		const uint32_t queries = 10000;
+		uint64_t hits = 0;
+		start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < queries; i++) {
+			const glm::vec2 corner = { unit(random) * worldSize, unit(random) * worldSize };
+			bvh.queryRegion(box(corner, corner + 10.0f), [&hits](int32_t) { hits++; return true; });
+		}
+		const double queryMs = elapsed(start);
+
+		std::cout << count << " proxies, height " << bvh.getHeight() << (bvh.validate() ? "" : " (INVALID)") << std::endl;
+		std::cout << "  Insert: " << insertMs << " ms, " << insertMs * 1e6 / count << " ns each" << std::endl;
+		std::cout << "  Move: " << moveMs << " ms, " << moveMs * 1e6 / count << " ns each, " << reinserted << " reinserted" << std::endl;
+		std::cout << "  Query: " << queryMs << " ms for " << queries << ", " << queryMs * 1e3 / queries << " us each, " << (double)hits / queries << " hits each" << std::endl;
+	}
+}
+
+// An 8 x 4 wall 10 units in front of the camera, rasterized by OcclusionCuller, then quads around it
+// that must come out culled or visible. Once on the calling thread, once split over 4 JobSystem threads
+static bool testOcclusion() {
+	struct Case {
+		const char* name;
+		AABB bounds;
+		bool visible;
+	};
+	const Case cases[] = {
+		{ "Behind the wall",			AABB({ -1.0f, -1.0f, -5.0f }, {  1.0f,  1.0f, -5.0f }), false },
+		{ "Behind the wall's corner",	AABB({  2.0f,  0.5f, -5.0f }, {  4.0f,  2.0f, -5.0f }), false },
+		{ "In front of the wall",		AABB({ -1.0f, -1.0f,  2.0f }, {  1.0f,  1.0f,  2.0f }), true },
+		{ "Beside the wall",			AABB({  8.0f, -1.0f, -5.0f }, { 10.0f,  1.0f, -5.0f }), true },
+		{ "Above the wall",				AABB({ -1.0f,  4.0f, -5.0f }, {  1.0f,  6.0f, -5.0f }), true },
+		{ "Sticking out of the wall",	AABB({  2.0f, -1.0f, -5.0f }, {  8.0f,  1.0f, -5.0f }), true },
+		{ "Out of the frustum",			AABB({ 100.0f, -1.0f, -5.0f }, { 102.0f, 1.0f, -5.0f }), false },
+	};
+
+	const glm::fvec3 wall[] = { { -4.0f, -2.0f, 0.0f }, { 4.0f, -2.0f, 0.0f }, { 4.0f, 2.0f, 0.0f }, { -4.0f, 2.0f, 0.0f } };
+	const uint32_t indices[] = { 0, 1, 2, 2, 3, 0 };
+	const glm::mat4 viewProjection = glm::perspective(glm::radians(60.0f), 2.0f, 0.1f, 100.0f)
+		* glm::lookAt(glm::fvec3(0.0f, 0.0f, 10.0f), glm::fvec3(0.0f, 0.0f, 0.0f), glm::fvec3(0.0f, 1.0f, 0.0f));
+
+	bool passed = true;
+	auto check = [&passed](bool condition, const std::string& name) {
+		std::cout << (condition ? "ok      " : "FAILED  ") << name << std::endl;
+		passed &= condition;
+	};
+
+	// Workers even on a single core machine, so the tiles do get split
+	JobSystem::Init(3);
+	for (uint32_t threads : { 1u, 4u }) {
+		const std::string suffix = " (" + std::to_string(threads) + " thread(s))";
+		OcclusionCuller culler(256, 128, threads);
+
+		// Nothing rasterized, nothing is hidden
+		culler.beginFrame(viewProjection);
+		culler.rasterize();
+		check(culler.isVisible(cases[0].bounds), "No occluder" + suffix);
+
+		culler.beginFrame(viewProjection);
+		culler.addOccluder(wall, 4, indices, 6, glm::mat4(1.0f));
+		culler.rasterize();
+		check(culler.getDepth(128, 64) < 1.0f, "Wall rasterized at the center" + suffix);
+
+		uint32_t culled = 0;
+		for (const Case& test : cases) {
+			check(culler.isVisible(test.bounds) == test.visible, std::string(test.name) + (test.visible ? " is visible" : " is culled") + suffix);
+			culled += test.visible ? 0 : 1;
+		}
+		check(culler.getStats().CulledObjects == culled && culler.getStats().OccluderTriangles == 2, "Statistics" + suffix);
+	}
+	JobSystem::Shutdown();
+
+	return passed;
+}
+
+// Static, kinematic and dynamic entities stepped while their types change and some are destroyed. The
+// bodies the steps walk must be the non-static ones, those must move and the static ones stay put.
+// A static entity moved by setPosition must be found where it went, syncTransforms doesn't look at it
+static bool testMovingBodies() {
+	bool passed = true;
+	auto check = [&passed](bool condition, const std::string& name) {
+		std::cout << (condition ? "ok      " : "FAILED  ") << name << std::endl;
+		passed &= condition;
+	};
+
+	Scene scene("Moving bodies");
+	scene.setAsyncPhysics(false);
+
+	std::vector<Entity> statics, dynamics, kinematics;
+	for (uint32_t i = 0; i < 1000; i++) {
+		EntityDefinition def;
+		def.position = { (float)(i % 100) * 2.0f, (float)(i / 100) * 2.0f, 0.0f };
+		statics.push_back(scene.addEntityToWorld(def));
+	}
+	for (uint32_t i = 0; i < 100; i++) {
+		EntityDefinition def;
+		def.type = EntityType::DYNAMIC;
+		def.position = { (float)i * 2.0f, 100.0f, 0.0f };
+		dynamics.push_back(scene.addEntityToWorld(def));
+	}
+	for (uint32_t i = 0; i < 20; i++) {
+		EntityDefinition def;
+		def.type = EntityType::KINEMATIC;
+		def.position = { (float)i * 2.0f, 200.0f, 0.0f };
+		kinematics.push_back(scene.addEntityToWorld(def));
+	}
+
+	auto countNonStatic = [&scene]() {
+		uint32_t count = 0;
+		scene.getRegistry().each<RigidBody>([&count](EntityHandle, const RigidBody& rigidBody) {
+			count += rigidBody.body->GetType() != b2_staticBody ? 1 : 0;
+		});
+		return count;
+	};
+	auto getY = [](Entity entity) { return entity.getComponent<Transform>().position.y; };
+	// Every entity of `entities` moved down (or none did) over 30 steps
+	auto fell = [&scene, &getY](const std::vector<Entity>& entities, bool expected) {
+		std::vector<float> before;
+		for (Entity entity : entities)
+			before.push_back(getY(entity));
+		for (int step = 0; step < 30; step++)
+			scene.updatePhysics(1.0f / 60.0f);
+
+		for (size_t i = 0; i < entities.size(); i++) {
+			if ((getY(entities[i]) < before[i]) != expected)
+				return false;
+		}
+		return true;
+	};
+
+	check(scene.getMovingBodyCount() == 120 && countNonStatic() == 120, "Only the non-static bodies are walked");
+	check(fell(dynamics, true), "Dynamic bodies fall");
+	check(fell(statics, false), "Static bodies stay put");
+
+	// 10 statics turn dynamic, 10 dynamics turn static, a kinematic turns dynamic
+	std::vector<Entity> woken(statics.end() - 10, statics.end()), stopped(dynamics.end() - 10, dynamics.end());
+	statics.resize(statics.size() - 10);
+	dynamics.resize(dynamics.size() - 10);
+	for (Entity entity : woken)
+		entity.setType(EntityType::DYNAMIC);
+	for (Entity entity : stopped)
+		entity.setType(EntityType::STATIC);
+	kinematics[0].setType(EntityType::DYNAMIC);
+	statics[0].setType(EntityType::STATIC);
+	check(scene.getMovingBodyCount() == 120 && countNonStatic() == 120, "Type changes update the walked bodies");
+	check(fell(woken, true), "Bodies turned dynamic fall");
+	check(fell(stopped, false), "Bodies turned static stay put");
+
+	for (uint32_t i = 0; i < 5; i++) {
+		scene.destroyEntity(dynamics.back());
+		dynamics.pop_back();
+		scene.destroyEntity(statics.back());
+		statics.pop_back();
+	}
+	check(scene.getMovingBodyCount() == 115 && countNonStatic() == 115, "Destroyed bodies leave the walk");
+	check(fell(dynamics, true), "Remaining dynamic bodies fall");
+
+	// Teleporting a static entity refits its proxy on the spot
+	statics[0].setPosition({ 500.0f, 500.0f });
+	scene.updatePhysics(1.0f / 60.0f);
+	std::vector<Entity> found;
+	scene.queryRegion({ 499.0f, 499.0f }, { 501.0f, 501.0f }, found);
+	const bool there = found.size() == 1 && found[0] == statics[0];
+	found.clear();
+	scene.queryRegion({ -0.5f, -0.5f }, { 0.5f, 0.5f }, found);
+	const bool gone = std::find(found.begin(), found.end(), statics[0]) == found.end();
+	check(there && gone, "Teleported static body is found where it went");
+
+	return passed;
+}
+
+// CPU time of the process, in seconds. std::clock() is wall time with MSVC
+static double getProcessCpuTime() {
+#ifdef SHADO_PLATFORM_WINDOWS
+	FILETIME creation, exit, kernel, user;
+	GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+	auto seconds = [](const FILETIME& time) { return (((uint64_t)time.dwHighDateTime << 32) | time.dwLowDateTime) * 1e-7; };
+	return seconds(kernel) + seconds(user);
+#else
+	return (double)std::clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+// 2 s of frames doing 1 ms of work each, capped at 60, 120 and 240 fps. The percentiles should sit on
+// the target frame time, and the CPU use stay close to the work's share of the frame
+static void benchmarkFrameLimiter() {
+	using Clock = std::chrono::steady_clock;
+
+	for (float fps : { 60.0f, 120.0f, 240.0f }) {
+		FrameLimiter limiter(fps);
+		FrameTimeHistory history;
+		const uint32_t frames = (uint32_t)(fps * 2.0f);
+
+		const double cpuStart = getProcessCpuTime();
+		const Clock::time_point start = Clock::now();
+		Clock::time_point previous = start;
+		for (uint32_t frame = 0; frame < frames; frame++) {
+			const Clock::time_point workEnd = Clock::now() + std::chrono::milliseconds(1);
+			while (Clock::now() < workEnd) {}
+			limiter.wait();
+
+			const Clock::time_point now = Clock::now();
+			history.push(std::chrono::duration<float, std::milli>(now - previous).count());
+			previous = now;
+		}
+		const double wall = std::chrono::duration<double>(Clock::now() - start).count();
+		const double cpu = getProcessCpuTime() - cpuStart;
+
+		const FrameTimeHistory::Percentiles percentiles = history.getPercentiles();
+		std::cout << fps << " fps (" << 1000.0f / fps << " ms): p50 " << percentiles.P50 << " ms, p95 " << percentiles.P95
+			<< " ms, p99 " << percentiles.P99 << " ms, CPU " << cpu / wall * 100.0 << "% of a core" << std::endl;
+	}
+}
+
+// Timers due around every level boundary of the wheel and at random up to 2^25 ms, advanced by 60 fps
+// frames: each must fire exactly once, on its tick, cancelled ones never. Then 500k timers scheduled,
+// half cancelled and 60 s of frames run, timed
+static bool benchmarkTimers() {
+	auto elapsed = [](std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	};
+	const double frame = 1000.0 / 60.0;
+
+	bool passed = true;
+	auto check = [&passed](bool condition, const std::string& name) {
+		std::cout << (condition ? "ok      " : "FAILED  ") << name << std::endl;
+		passed &= condition;
+	};
+
+	{
+		TimerWheel wheel;
+		// Off the level boundaries
+		wheel.advance(12345.5);
+
+		std::vector<uint64_t> delays = { 0, 1, 2, 1ull << 25 };
+		for (uint32_t level = 1; level <= 3; level++) {
+			const uint64_t boundary = 1ull << (8 * level);
+			delays.insert(delays.end(), { boundary - 1, boundary, boundary + 1 });
+		}
+		std::mt19937 random(7);
+		std::uniform_int_distribution<uint64_t> delay(1, 1ull << 25);
+		for (uint32_t i = 0; i < 10000; i++)
+			delays.push_back(delay(random));
+
+		const uint64_t start = wheel.getTime();
+		std::vector<uint64_t> expected(delays.size());
+		std::vector<uint64_t> fired(delays.size(), 0);
+		std::vector<uint32_t> fireCount(delays.size(), 0);
+		std::vector<bool> cancelled(delays.size(), false);
+		uint64_t last = 0;
+		bool ordered = true;
+
+		for (uint32_t i = 0; i < delays.size(); i++) {
+			expected[i] = start + std::max<uint64_t>(delays[i], 1);
+			TimerHandle handle = wheel.schedule([&, i]() {
+				ordered &= wheel.getTime() >= last;
+				last = wheel.getTime();
+				fired[i] = wheel.getTime();
+				fireCount[i]++;
+			}, delays[i]);
+
+			// A tenth of the random ones
+			if (i >= 13 && i % 10 == 0)
+				cancelled[i] = wheel.cancel(handle);
+		}
+
+		uint64_t intervalFires = 0;
+		bool intervalOnTime = true;
+		wheel.schedule([&]() {
+			intervalFires++;
+			intervalOnTime &= wheel.getTime() == start + intervalFires * 1000;
+		}, 1000, 1000);
+
+		const uint64_t end = start + (1ull << 25);
+		while (wheel.getTime() < end)
+			wheel.advance(frame);
+
+		uint32_t onTime = 0, missed = 0, repeated = 0, cancelledFired = 0;
+		for (uint32_t i = 0; i < delays.size(); i++) {
+			if (cancelled[i]) {
+				cancelledFired += fireCount[i];
+				continue;
+			}
+			missed += fireCount[i] == 0 ? 1 : 0;
+			repeated += fireCount[i] > 1 ? 1 : 0;
+			onTime += fireCount[i] == 1 && fired[i] == expected[i] ? 1 : 0;
+		}
+		const uint32_t scheduled = (uint32_t)std::count(cancelled.begin(), cancelled.end(), false);
+
+		check(onTime == scheduled, std::to_string(onTime) + " of " + std::to_string(scheduled) + " timers fired on their tick");
+		check(missed == 0 && repeated == 0, std::to_string(missed) + " missed, " + std::to_string(repeated) + " fired more than once");
+		check(cancelledFired == 0, std::to_string(delays.size() - scheduled) + " cancelled timers never fired");
+		check(ordered, "Fired in order of expiry");
+		check(intervalOnTime && intervalFires == (end - start) / 1000, "Interval fired every 1000 ms, " + std::to_string(intervalFires) + " times");
+	}
+
+	{
+		const uint32_t count = 500000;
+		std::mt19937 random(11);
+		std::uniform_int_distribution<uint64_t> delay(1, 60000);
+		TimerWheel wheel;
+		uint32_t fires = 0;
+
+		auto start = std::chrono::steady_clock::now();
+		std::vector<TimerHandle> handles(count);
+		for (uint32_t i = 0; i < count; i++)
+			handles[i] = wheel.schedule([&fires]() { fires++; }, delay(random));
+		std::cout << "Schedule " << count << ": " << elapsed(start) << " ms" << std::endl;
+
+		start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < count; i += 2)
+			wheel.cancel(handles[i]);
+		std::cout << "Cancel " << count / 2 << ": " << elapsed(start) << " ms" << std::endl;
+
+		start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < 3600; i++)
+			wheel.advance(frame);
+		std::cout << "3600 frames (60 s): " << elapsed(start) << " ms" << std::endl;
+		check(fires == count / 2 && wheel.getTimerCount() == 0, std::to_string(fires) + " fired");
+	}
+
+	return passed;
+}
+
+// Times the same ParallelFor with 1 to N threads, the speedup shows how well the job system scales
+static void benchmarkJobSystem() {
+	const uint32_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+	const uint32_t count = 1 << 22;
+	std::vector<glm::vec4> positions(count, glm::vec4(1.0f));
+	std::vector<glm::vec4> velocities(count, glm::vec4(0.5f, -0.25f, 0.1f, 0.0f));
+
+	double baseline = 0.0;
+	for (uint32_t threads = 1; threads <= maxThreads; threads++) {
+		JobSystem::Init(threads - 1);
+
+		const uint32_t runs = 10;
+		auto start = std::chrono::steady_clock::now();
+		for (uint32_t run = 0; run < runs; run++) {
+			JobSystem::ParallelFor(count, 16384, [&](uint32_t begin, uint32_t end) {
+				for (uint32_t i = begin; i < end; i++) {
+					velocities[i] = glm::vec4(std::sin(positions[i].x), std::cos(positions[i].y), velocities[i].z, 0.0f);
+					positions[i] += velocities[i] * (1.0f / 60.0f);
+				}
+			});
+		}
+		const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / runs;
+
+		JobSystem::Shutdown();
+
+		if (threads == 1)
+			baseline = ms;
+		std::cout << threads << " thread(s): " << ms << " ms, x" << baseline / ms << std::endl;
+	}
+}
+
+// Entity as it was before the registry: one heap object per entity, the position read through its b2Body
+struct LegacyEntity {
+	uint64_t id;
+	std::string name;
+	glm::vec2 scale;
+	float z;
+	Ref<Texture2D> texture;
+	uint32_t tilingfactor;
+	Color color;
+	b2Body* body;
+	bool isAlive;
+};
+
+// 100k entities, the old Entity::draw() loop against the registry's arrays. Only the part before
+// Renderer2D is timed (reading what to draw), the batching after it costs the same for both
+static void benchmarkEntities() {
+	const uint32_t count = 100000;
+	const uint32_t runs = 100;
+	Scene scene("ECS benchmark");
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<Entity> entities;
+	for (uint32_t i = 0; i < count; i++) {
+		EntityDefinition def;
+		def.name = "Entity " + std::to_string(i);
+		def.position = { (float)(i % 1000), (float)(i / 1000), 0.0f };
+		entities.push_back(scene.addEntityToWorld(def));
+	}
+	std::cout << "Create " << count << ": " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+
+	std::vector<LegacyEntity*> legacy;
+	for (Entity entity : entities)
+		legacy.push_back(new LegacyEntity{ entity.getId(), entity.getName(), entity.getScale(), 0.0f, nullptr, 1, entity.getColor(), entity.getNativeBody(), true });
+
+	// Stands for the vertices handed to Renderer2D
+	std::vector<glm::vec4> quads(count);
+
+	start = std::chrono::steady_clock::now();
+	for (uint32_t run = 0; run < runs; run++) {
+		uint32_t quad = 0;
+		for (LegacyEntity* entity : legacy) {
+			if (!entity->isAlive)
+				continue;
+
+			const b2Vec2& position = entity->body->GetPosition();
+			quads[quad++] = { position.x * entity->scale.x, position.y * entity->scale.y, entity->z, entity->body->GetAngle() + entity->color.red() };
+		}
+	}
+	const double legacyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / runs;
+
+	start = std::chrono::steady_clock::now();
+	for (uint32_t run = 0; run < runs; run++) {
+		uint32_t quad = 0;
+		scene.getRegistry().each<Transform, Sprite>([&](EntityHandle, const Transform& transform, const Sprite& sprite) {
+			quads[quad++] = { transform.position.x * transform.scale.x, transform.position.y * transform.scale.y, transform.position.z, transform.rotation + sprite.color.red() };
+		});
+	}
+	const double ecsMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / runs;
+	std::cout << "Draw loop: Entity* " << legacyMs << " ms, registry " << ecsMs << " ms, x" << legacyMs / ecsMs << std::endl;
+
+	// The old find_if scans, on a thousandth of them or it takes forever
+	const uint32_t lookups = count / 1000;
+	uint64_t found = 0;
+	start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < lookups; i++) {
+		const std::string name = "Entity " + std::to_string(i * 997 % count);
+		auto it = std::find_if(legacy.begin(), legacy.end(), [&name](LegacyEntity* e) { return e->name == name; });
+		found += (*it)->id;
+	}
+	const double legacyLookupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / lookups;
+
+	start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < count; i++)
+		found += scene.getEntity("Entity " + std::to_string(i * 997 % count)).getId();
+	const double ecsLookupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / count;
+
+	start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < count; i++)
+		found += scene.getEntity(legacy[i * 997 % count]->id).getZ() == 0.0f;
+	const double ecsIdLookupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / count;
+	std::cout << "Lookup by name: Entity* " << legacyLookupMs * 1000.0 << " us, scene " << ecsLookupMs * 1000.0
+		<< " us. By id: scene " << ecsIdLookupMs * 1000.0 << " us (" << found << ")" << std::endl;
+
+	// A tenth of them, the old linear erase is quadratic
+	const uint32_t destroyed = count / 10;
+	start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < destroyed; i++) {
+		auto it = std::find(legacy.begin(), legacy.end(), legacy[legacy.size() / 2]);
+		delete *it;
+		legacy.erase(it);
+	}
+	const double legacyDestroyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < destroyed; i++)
+		scene.destroyEntity(entities[count / 2 - destroyed / 2 + i]);
+	const double ecsDestroyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "Destroy " << destroyed << ": Entity* " << legacyDestroyMs << " ms, registry " << ecsDestroyMs << " ms (with the b2Body)" << std::endl;
+
+	for (LegacyEntity* entity : legacy)
+		delete entity;
+}
+
+// 100k entities saved then loaded in both formats, against creating them in code
+static void benchmarkSceneSerialization() {
+	const uint32_t count = 100000;
+	auto elapsed = [](std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	};
+	auto fileSize = [](const std::string& path) {
+		MappedFile file(path);
+		return file.getSize() / 1024;
+	};
+
+	Scene scene("Serialization benchmark");
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < count; i++) {
+		EntityDefinition def;
+		def.name = "Entity " + std::to_string(i % 1000);
+		def.type = (EntityType)(i % 3);
+		def.position = { (float)(i % 1000), (float)(i / 1000), 0.0f };
+		def.rotation = (float)(i % 628) / 100.0f;
+		def.color = Color(0.2f, 0.4f, (float)(i % 256) / 255.0f, 1.0f);
+		scene.addEntityToWorld(def);
+	}
+	std::cout << "Create " << count << " in code: " << elapsed(start) << " ms" << std::endl;
+
+	SceneSerializer serializer(scene);
+	start = std::chrono::steady_clock::now();
+	serializer.saveBinary("bench.shscene");
+	std::cout << "Save binary: " << elapsed(start) << " ms, " << fileSize("bench.shscene") << " KB" << std::endl;
+
+	start = std::chrono::steady_clock::now();
+	serializer.saveText("bench.scene.txt");
+	std::cout << "Save text: " << elapsed(start) << " ms, " << fileSize("bench.scene.txt") << " KB" << std::endl;
+
+	{
+		Scene loaded("Binary");
+		start = std::chrono::steady_clock::now();
+		SceneSerializer(loaded).loadBinary("bench.shscene");
+		std::cout << "Load binary: " << elapsed(start) << " ms, " << loaded.getRegistry().getCount() << " entities" << std::endl;
+	}
+	{
+		Scene loaded("Text");
+		start = std::chrono::steady_clock::now();
+		SceneSerializer(loaded).loadText("bench.scene.txt");
+		std::cout << "Load text: " << elapsed(start) << " ms, " << loaded.getRegistry().getCount() << " entities" << std::endl;
+	}
+}
+
+// A 2000 x 2000 world of 100k entities saved in cells, then streamed around a focus crossing it.
+// The frame cost is what update() takes on the main thread, the latency is per cell (see WorldPartition)
+static void benchmarkWorldStreaming() {
+	const uint32_t count = 100000;
+	const float worldSize = 2000.0f;
+	const float cellSize = 100.0f;
+	auto elapsed = [](std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	JobSystem::Init();
+	{
+		Scene world("World");
+		for (uint32_t i = 0; i < count; i++) {
+			EntityDefinition def;
+			def.name = "Entity " + std::to_string(i % 1000);
+			def.type = i % 4 == 0 ? EntityType::DYNAMIC : EntityType::STATIC;
+			def.position = { Random::Float() * worldSize, Random::Float() * worldSize, 0.0f };
+			world.addEntityToWorld(def);
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		WorldPartition::SaveCells(world, "bench_world", cellSize);
+		std::cout << "Save " << count << " in cells of " << cellSize << ": " << elapsed(start) << " ms" << std::endl;
+	}
+
+	Scene scene("Streamed world");
+	WorldPartition& partition = scene.enableWorldPartition("bench_world", cellSize);
+	partition.setRadii(200.0f, 300.0f);
+	partition.setFrameBudget(2.0f);
+
+	auto start = std::chrono::steady_clock::now();
+	partition.setFocus({ 0.0f, worldSize / 2 });
+	partition.flush();
+	std::cout << "Flush: " << elapsed(start) << " ms, " << scene.getRegistry().getCount() << " entities" << std::endl;
+
+	// 10 units a frame, across the world
+	double total = 0.0, longest = 0.0;
+	uint32_t frames = 0, maxEntities = 0;
+	for (float x = 0.0f; x <= worldSize; x += 10.0f, frames++) {
+		partition.setFocus({ x, worldSize / 2 });
+		start = std::chrono::steady_clock::now();
+		partition.update();
+		const double ms = elapsed(start);
+		total += ms;
+		longest = std::max(longest, ms);
+		maxEntities = std::max(maxEntities, scene.getRegistry().getCount());
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	std::vector<float> latencies;
+	partition.getLoadLatencies(latencies);
+	float latencyTotal = 0.0f, latencyMax = 0.0f;
+	for (float latency : latencies) {
+		latencyTotal += latency;
+		latencyMax = std::max(latencyMax, latency);
+	}
+
+	std::cout << frames << " frames: update " << total / frames << " ms on average, " << longest << " ms at most" << std::endl;
+	std::cout << "At most " << maxEntities << " of " << count << " entities resident" << std::endl;
+	if (!latencies.empty())
+		std::cout << "Cell load latency: " << latencyTotal / latencies.size() << " ms on average, " << latencyMax << " ms at most" << std::endl;
+
+	scene.disableWorldPartition();
+	JobSystem::Shutdown();
+}
+
+// The cell edges of atlases whose grid doesn't divide their size, stored in tile vertices, must land within
+// a small fraction of a texel of the exact edge, and neighbouring cells must share theirs. The error of
+// half floats, what quad vertices hold, is printed next to it
+static bool testTilemapTexCoords() {
+	struct Atlas {
+		uint32_t width, height;
+		uint32_t columns, rows;
+	};
+	const Atlas atlases[] = { { 1000, 600, 7, 5 }, { 2048, 2048, 17, 13 }, { 4096, 4096, 3, 3 }, { 4000, 16, 100, 1 } };
+	const double tolerance = 1.0 / 64.0;
+
+	bool passed = true;
+	for (const Atlas& atlas : atlases) {
+		double worst = 0.0, worstHalf = 0.0;
+		bool shared = true;
+
+		for (uint32_t row = 0; row < atlas.rows; row++) {
+			for (uint32_t column = 0; column < atlas.columns; column++) {
+				const uint16_t tile = (uint16_t)(row * atlas.columns + column + 1);
+				glm::vec2 min, max;
+				Tilemap::GetCellTexCoords(tile, atlas.columns, atlas.rows, min, max);
+
+				// Through the vertex the chunk meshes are made of, and through the half floats of quad vertices
+				Renderer2D::TileVertex corners[2] = {};
+				corners[0].TexCoord = min;
+				corners[1].TexCoord = max;
+				const glm::vec2 halves[2] = { glm::unpackHalf2x16(glm::packHalf2x16(min)), glm::unpackHalf2x16(glm::packHalf2x16(max)) };
+
+				// v = 1 is the top row
+				const double exact[2][2] = {
+					{ (double)column * atlas.width / atlas.columns, (1.0 - (double)(row + 1) / atlas.rows) * atlas.height },
+					{ (double)(column + 1) * atlas.width / atlas.columns, (1.0 - (double)row / atlas.rows) * atlas.height }
+				};
+				for (int corner = 0; corner < 2; corner++) {
+					const glm::vec2& stored = corners[corner].TexCoord;
+					worst = std::max({ worst, std::abs(stored.x * atlas.width - exact[corner][0]), std::abs(stored.y * atlas.height - exact[corner][1]) });
+					worstHalf = std::max({ worstHalf, std::abs(halves[corner].x * atlas.width - exact[corner][0]), std::abs(halves[corner].y * atlas.height - exact[corner][1]) });
+				}
+
+				// The cell on the right starts where this one ends, the one below ends where this one starts
+				glm::vec2 nextMin, nextMax;
+				if (column + 1 < atlas.columns) {
+					Tilemap::GetCellTexCoords(tile + 1, atlas.columns, atlas.rows, nextMin, nextMax);
+					shared &= nextMin.x == max.x;
+				}
+				if (row + 1 < atlas.rows) {
+					Tilemap::GetCellTexCoords((uint16_t)(tile + atlas.columns), atlas.columns, atlas.rows, nextMin, nextMax);
+					shared &= nextMax.y == min.y;
+				}
+			}
+		}
+
+		const bool ok = worst <= tolerance && shared;
+		std::cout << (ok ? "ok      " : "FAILED  ") << atlas.columns << " x " << atlas.rows << " cells on " << atlas.width << " x " << atlas.height
+			<< ": edges off by " << worst << " texel at most (" << worstHalf << " as half floats)" << (shared ? "" : ", edges not shared") << std::endl;
+		passed &= ok;
+	}
+
+	return passed;
+}
+
 int main(int argc, const char** argv)
 {
-	auto& application = Application::get();
-	application.getWindow().resize(1920, 1080);
+	// --headless [--frames N] [--capture file.png]
+	// --bench-bvh
+	// --test-occlusion
+	// --bench-frame-limiter
+	// --bench-jobs
+	// --bench-timers
+	// --bench-ecs
+	// --bench-scene
+	// --bench-stream
+	// --test-tilemap-uvs
+	// --test-moving-bodies
+	ApplicationSpecification specification;
+	specification.Width = 1920;
+	specification.Height = 1080;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--headless") {
+			specification.Headless = true;
+			specification.Context = ContextAPI::EGL;
+			specification.FixedFrameTime = 1.0f / 60.0f;
+		} else if (arg == "--frames" && i + 1 < argc)
+			specification.FrameCount = std::stoi(argv[++i]);
+		else if (arg == "--capture" && i + 1 < argc)
+			specification.CapturePath = argv[++i];
+		else if (arg == "--bench-bvh") {
+			benchmarkBVH();
+			return 0;
+		} else if (arg == "--test-occlusion") {
+			return testOcclusion() ? 0 : 1;
+		} else if (arg == "--bench-frame-limiter") {
+			benchmarkFrameLimiter();
+			return 0;
+		} else if (arg == "--bench-jobs") {
+			benchmarkJobSystem();
+			return 0;
+		} else if (arg == "--bench-timers") {
+			return benchmarkTimers() ? 0 : 1;
+		} else if (arg == "--bench-ecs") {
+			benchmarkEntities();
+			return 0;
+		} else if (arg == "--bench-scene") {
+			benchmarkSceneSerialization();
+			return 0;
+		} else if (arg == "--bench-stream") {
+			benchmarkWorldStreaming();
+			return 0;
+		} else if (arg == "--test-tilemap-uvs") {
+			return testTilemapTexCoords() ? 0 : 1;
+		} else if (arg == "--test-moving-bodies") {
+			return testMovingBodies() ? 0 : 1;
+		}
+	}
+
+	auto& application = Application::create(specification);
 	application.submit(new TestScene);
 	application.run();
 
@@ -4,36 +4,79 @@
 #include "GL/glew.h"
 #include "Renderer2D.h"
 #include <algorithm>
+#include <cmath>
 #include "cameras/OrthoCamera.h"
 #include "Events/ApplicationEvent.h"
 #include "Events/KeyEvent.h"
 #include "Events/MouseEvent.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "Stats.h"
 #include "Renderer3D.h"
+#include "RenderCommandQueue.h"
+#include "WorldPartition.h"
+#include "util/ImageWriter.h"
 #include "util/Random.h"
 
 namespace Shado {
 
 	// =========================== APPLICATION CLASS ===========================
 
-	Application* Application::singleton = new Application();
+	// Named after the GpuTimers, as on the profiler's GPU track
+	struct ApplicationStats {
+		StatHandle GpuSceneTime = Stats::Register("GPU.PassTime.Scenes", StatKind::PerFrame, StatUnit::Microseconds);
+		StatHandle GpuUpscaleTime = Stats::Register("GPU.PassTime.Upscale", StatKind::PerFrame, StatUnit::Microseconds);
+		StatHandle GpuImGuiTime = Stats::Register("GPU.PassTime.ImGui", StatKind::PerFrame, StatUnit::Microseconds);
+	};
+	static ApplicationStats s_Stats;
 
-	Application::Application(unsigned width, unsigned height, const std::string& title)
-		: window(new Window(width, height, title)), uiScene(new ImguiLayer)
+	// Created on first use rather than at static init, so the specification can be chosen first
+	Application* Application::singleton = nullptr;
+
+	Application::Application(const ApplicationSpecification& specification)
+		: m_Specification(specification), uiScene(new ImguiLayer)
 	{
+		// The window's callbacks go through get()
+		singleton = this;
+
 		Log::init();
 		Random::init();
+		JobSystem::Init();
+
+		window.reset(new Window(specification.Width, specification.Height, specification.Name, WindowMode::WINDOWED,
+			!specification.Headless, specification.Context));
+
+		if (specification.Headless)
+			m_Framebuffer = Framebuffer::create(specification.Width, specification.Height);
 
-		/* Initialize the library */
-		// TODO: Might want to un comment this if application crashes
-		//window = std::make_unique<Window>(width, height, title);
+		SHADO_CORE_ASSERT(specification.CapturePath.empty() || specification.FrameCount > 0, "CapturePath needs a FrameCount");
+	}
+
+	Application::Application(unsigned width, unsigned height, const std::string& title)
+		: Application(ApplicationSpecification{ title, width, height })
+	{
 	}
 
 	Application::Application()
-		: Application(1280, 720, "Shado OpenGL simple Rendering engine")
+		: Application(ApplicationSpecification())
 	{
 	}
 
+	Application& Application::create(const ApplicationSpecification& specification) {
+		SHADO_CORE_ASSERT(singleton == nullptr, "Application already exists");
+		new Application(specification);
+		return *singleton;
+	}
+
+	Application& Application::get() {
+		if (singleton == nullptr)
+			new Application();
+		return *singleton;
+	}
+
 	Application::~Application() {
+		// What the callbacks captured may refer to the scenes
+		m_Timers.clear();
 
 		for (Scene* scene : allScenes) {
 			if (scene == nullptr)
@@ -51,6 +94,14 @@ namespace Shado {
 			delete scene;
 		}
 
+		JobSystem::Shutdown();
+
+		m_SceneTarget.reset();
+		m_FramebufferPool.clear();
+		m_Framebuffer.reset();
+		m_SceneTimer.release();
+		m_UpscaleTimer.release();
+		m_ImGuiTimer.release();
 		glfwTerminate();
 	}
 
@@ -72,14 +123,50 @@ namespace Shado {
 		}
 
 
+		// Platform windows can't be shown nor drawn offscreen
+		if (m_RenderThreadEnabled || m_Specification.Headless)
+			ImGui::GetIO().ConfigFlags &= ~ImGuiConfigFlags_ViewportsEnable;
+
+		if (m_RenderThreadEnabled) {
+			RenderCommandQueue::StartRenderThread(window->getNativeWindow(), window->getSharedContext());
+		}
+
+		SHADO_PROFILE_THREAD("Main");
+
 		/* Loop until the user closes the window */
 		while (m_Running) {
 
+			// Minimized: nothing to show, sleep until something happens. The time spent here isn't simulated
+			if (window->isMinimized()) {
+				window->waitEvents(0.1);
+				m_LastFrameTime = (float)glfwGetTime();
+				continue;
+			}
+
 			float time = (float)glfwGetTime();	// TODO: put it in platform specific
-			float timestep = time - m_LastFrameTime;
+			float timestep = m_Specification.FixedFrameTime > 0.0f ? m_Specification.FixedFrameTime : time - m_LastFrameTime;
 			m_LastFrameTime = time;
 
+			// Milliseconds since the last call
+			double mark = time;
+			auto lap = [&mark]() {
+				double now = glfwGetTime();
+				float elapsed = (float)((now - mark) * 1000.0);
+				mark = now;
+				return elapsed;
+			};
+
+			m_FrameStats.FrameTime = timestep * 1000.0f;
+			{
+				SHADO_PROFILE_SCOPE("TimerWheel::advance");
+				m_Timers.advance(timestep * 1000.0);
+			}
+			m_FrameTimes.push(m_FrameStats.FrameTime);
+
 			/* Render here */
+			if (m_SceneTarget || m_Framebuffer)
+				RenderCommandQueue::Submit([framebuffer = m_SceneTarget ? m_SceneTarget : m_Framebuffer]() { framebuffer->bind(); });
+			RenderCommandQueue::Submit([timer = &m_SceneTimer]() { timer->begin(); });
 			Renderer2D::Clear();
 
 			// Draw scenes here
@@ -93,29 +180,284 @@ namespace Shado {
 					layer->onDraw();
 				}*/
 
-				m_activeScene->onUpdate(timestep);
-				m_activeScene->updatePhysics(timestep);
+				// The steps handed to a worker last frame, before anything touches the bodies
+				lap();
+				m_activeScene->waitForPhysics();
+				m_FrameStats.PhysicsWaitTime = lap();
+
+				{
+					SHADO_PROFILE_SCOPE("Scene::onUpdate");
+					m_activeScene->onUpdate(timestep);
+				}
+				// Around the focus onUpdate just set
+				if (WorldPartition* partition = m_activeScene->getWorldPartition())
+					partition->update();
+				m_FrameStats.UpdateTime = lap();
+
+				// Catch up with the elapsed time in fixed steps
+				const bool asyncPhysics = m_activeScene->isAsyncPhysics();
+				m_FixedAccumulator += timestep;
+				uint32_t steps = 0;
+				while (m_FixedAccumulator >= m_FixedTimeStep && steps < m_MaxFixedSteps) {
+					SHADO_PROFILE_SCOPE("Scene::onFixedUpdate");
+					m_activeScene->onFixedUpdate(m_FixedTimeStep);
+					if (!asyncPhysics)
+						m_activeScene->updatePhysics(m_FixedTimeStep);
+					m_FixedAccumulator -= m_FixedTimeStep;
+					steps++;
+				}
+
+				// Stepped on a worker while this frame draws the state of the last steps
+				if (asyncPhysics && steps > 0)
+					m_activeScene->beginPhysics(steps, m_FixedTimeStep);
+
+				// Too far behind, forget the whole steps that are left and keep the remainder for the alpha
+				float dropped = 0.0f;
+				if (m_FixedAccumulator >= m_FixedTimeStep) {
+					dropped = (float)(std::floor(m_FixedAccumulator / m_FixedTimeStep) * m_FixedTimeStep);
+					m_FixedAccumulator -= dropped;
+				}
+
+				m_activeScene->interpolationAlpha = (float)(m_FixedAccumulator / m_FixedTimeStep);
+
+				m_FrameStats.FixedSteps = steps;
+				m_FrameStats.DroppedTime = dropped;
+				m_FrameStats.TotalFixedSteps += steps;
+				m_FrameStats.TotalDroppedTime += dropped;
+				m_FrameStats.PhysicsTime = lap();
+
+				SHADO_PROFILE_SCOPE("Scene::onDraw");
 				m_activeScene->onDraw();				
 			}
+
+			RenderCommandQueue::Submit([timer = &m_SceneTimer]() { timer->end(); });
+
+			// ImGui goes on top, at full resolution
+			if (m_SceneTarget) {
+				RenderCommandQueue::Submit([timer = &m_UpscaleTimer]() { timer->begin(); });
+				presentSceneTarget();
+				RenderCommandQueue::Submit([timer = &m_UpscaleTimer]() { timer->end(); });
+			}
+
 			uiScene->onUpdate(timestep);
 			uiScene->onDraw();
+			m_FrameStats.DrawTime = lap();
 
 			// Render UI
-			uiScene->begin();
-			if (m_activeScene != nullptr) {
-				/*for (Layer* layer : m_activeScene->getLayers()) {
-					if (layer != nullptr)
-						layer->onImGuiRender();
-				}*/
-				m_activeScene->onImGuiRender();
+			RenderCommandQueue::Submit([timer = &m_ImGuiTimer]() { timer->begin(); });
+			{
+				SHADO_PROFILE_SCOPE("ImGui");
+				uiScene->begin();
+				if (m_activeScene != nullptr) {
+					/*for (Layer* layer : m_activeScene->getLayers()) {
+						if (layer != nullptr)
+							layer->onImGuiRender();
+					}*/
+					m_activeScene->onImGuiRender();
+				}
+				uiScene->onImGuiRender();
+				uiScene->end();
+			}
+			RenderCommandQueue::Submit([timer = &m_ImGuiTimer]() { timer->end(); });
+			m_FrameStats.ImGuiTime = lap();
+
+			m_FrameCount++;
+			if (m_Specification.FrameCount > 0 && m_FrameCount >= m_Specification.FrameCount) {
+				if (!m_Specification.CapturePath.empty())
+					m_CapturePath = m_Specification.CapturePath;
+				m_Running = false;
+			}
+
+			// Read back before the swap, the back buffer is undefined after it
+			if (!m_CapturePath.empty()) {
+				capture(m_CapturePath);
+				m_CapturePath.clear();
+			}
+
+			if (RenderCommandQueue::IsThreaded()) {
+				// The render thread swaps once it has replayed the frame
+				{
+					SHADO_PROFILE_SCOPE("RenderCommandQueue::EndFrame");
+					RenderCommandQueue::EndFrame();
+				}
+				window->pollEvents();
+				float presentTime = lap();
+
+				auto renderStats = RenderCommandQueue::GetStats();
+				m_FrameStats.WaitTime = renderStats.WaitTime;
+				m_FrameStats.RenderTime = renderStats.ExecuteTime;
+				m_FrameStats.SwapTime = renderStats.SwapTime + (presentTime - renderStats.WaitTime);
+				m_FrameStats.CommandCount = renderStats.CommandCount;
+			} else {
+				/* Swap front and back buffers */
+				/* Poll for and process events */
+				SHADO_PROFILE_SCOPE("Window::onUpdate");
+				window->onUpdate();
+				m_FrameStats.SwapTime = lap();
 			}
-			uiScene->onImGuiRender();
-			uiScene->end();
 
-			/* Swap front and back buffers */
-			/* Poll for and process events */
-			window->onUpdate();
+			m_FrameStats.GpuSceneTime = m_SceneTimer.getTime();
+			m_FrameStats.GpuUpscaleTime = m_SceneTarget ? m_UpscaleTimer.getTime() : 0.0f;
+			m_FrameStats.GpuImGuiTime = m_ImGuiTimer.getTime();
+			Stats::Set(s_Stats.GpuSceneTime, (int64_t)(m_FrameStats.GpuSceneTime * 1000.0f));
+			Stats::Set(s_Stats.GpuUpscaleTime, (int64_t)(m_FrameStats.GpuUpscaleTime * 1000.0f));
+			Stats::Set(s_Stats.GpuImGuiTime, (int64_t)(m_FrameStats.GpuImGuiTime * 1000.0f));
+
+			if (m_DynamicResolution) {
+				float scale = m_ResolutionController.update(m_FrameStats.GpuSceneTime + m_FrameStats.GpuUpscaleTime + m_FrameStats.GpuImGuiTime);
+				if (scale != m_RenderScale)
+					setRenderScale(scale);
+			}
+			m_FrameStats.RenderScale = m_RenderScale;
+
+			// Frame pacing, the lowest applicable cap wins
+			float targetFrameRate = m_TargetFrameRate;
+			if (!window->isFocused() && m_BackgroundFrameRate > 0.0f && (targetFrameRate <= 0.0f || m_BackgroundFrameRate < targetFrameRate))
+				targetFrameRate = m_BackgroundFrameRate;
+
+			if (targetFrameRate != m_FrameLimiter.getTargetFPS())
+				m_FrameLimiter.setTargetFPS(targetFrameRate);
+			{
+				SHADO_PROFILE_SCOPE("FrameLimiter::wait");
+				m_FrameStats.LimiterTime = m_FrameLimiter.wait();
+			}
+
+			m_FramebufferPool.endFrame();
+			Stats::EndFrame();
+			SHADO_PROFILE_FRAME();
 		}
+
+		// Gives the context back to this thread before anything gets destroyed
+		RenderCommandQueue::StopRenderThread();
+	}
+
+	void Application::updateSceneTarget(uint32_t outputWidth, uint32_t outputHeight) {
+		if (m_RenderScale == 1.0f && m_Samples == 1) {
+			m_SceneTarget.reset();
+			return;
+		}
+
+		const uint32_t width = std::max(1u, (uint32_t)std::lround(outputWidth * m_RenderScale));
+		const uint32_t height = std::max(1u, (uint32_t)std::lround(outputHeight * m_RenderScale));
+
+		if (m_SceneTarget && m_SceneTarget->getSpecification().Samples == m_Samples) {
+			m_SceneTarget->resize(width, height);
+			return;
+		}
+
+		FramebufferSpecification specification;
+		specification.Width = width;
+		specification.Height = height;
+		specification.Samples = m_Samples;
+		m_SceneTarget = Framebuffer::create(specification);
+	}
+
+	void Application::presentSceneTarget() {
+		// Multisampled: resolve first, a multisampled blit can't stretch
+		Ref<Framebuffer> resolved;
+		if (m_Samples > 1) {
+			FramebufferSpecification specification;
+			specification.Width = m_SceneTarget->getWidth();
+			specification.Height = m_SceneTarget->getHeight();
+			specification.Attachments = { FramebufferTextureFormat::RGBA8 };
+			resolved = m_FramebufferPool.acquire(specification);
+		}
+
+		RenderCommandQueue::Submit([scene = m_SceneTarget, resolved, output = m_Framebuffer,
+			width = window->getWidth(), height = window->getHeight()]() {
+			const Framebuffer* source = scene.get();
+			if (resolved) {
+				scene->blit(*resolved, 0, false, false);
+				source = resolved.get();
+			}
+
+			if (output) {
+				source->blit(*output);
+				output->bind();
+			} else {
+				source->blitToScreen(width, height);
+				glBindFramebuffer(GL_FRAMEBUFFER, 0);
+				glViewport(0, 0, width, height);
+			}
+		});
+	}
+
+	void Application::setRenderScale(float scale) {
+		SHADO_CORE_ASSERT(scale > 0.0f, "Invalid render scale");
+		m_RenderScale = scale;
+
+		if (m_Framebuffer)
+			updateSceneTarget(m_Framebuffer->getWidth(), m_Framebuffer->getHeight());
+		else
+			updateSceneTarget(window->getWidth(), window->getHeight());
+	}
+
+	void Application::setDynamicResolution(bool enabled, float targetFrameTime) {
+		m_DynamicResolution = enabled;
+
+		if (!enabled) {
+			setRenderScale(1.0f);
+			return;
+		}
+
+		if (targetFrameTime <= 0.0f)
+			targetFrameTime = 1000.0f / (m_TargetFrameRate > 0.0f ? m_TargetFrameRate : 60.0f);
+
+		m_ResolutionController.setTargetFrameTime(targetFrameTime);
+		m_ResolutionController.reset();
+	}
+
+	void Application::setMultisampling(uint32_t samples) {
+		SHADO_CORE_ASSERT(samples > 0, "Invalid sample count");
+		m_Samples = samples;
+
+		if (m_Framebuffer)
+			updateSceneTarget(m_Framebuffer->getWidth(), m_Framebuffer->getHeight());
+		else
+			updateSceneTarget(window->getWidth(), window->getHeight());
+	}
+
+	void Application::capture(const std::string& path) {
+		int width = 0, height = 0;
+		if (!m_Framebuffer)
+			glfwGetFramebufferSize(window->getNativeWindow(), &width, &height);
+
+		RenderCommandQueue::Submit([path, framebuffer = m_Framebuffer, width, height]() {
+			std::vector<uint8_t> pixels;
+			uint32_t captureWidth = width, captureHeight = height;
+
+			if (framebuffer) {
+				framebuffer->readPixels(pixels);
+				captureWidth = framebuffer->getWidth();
+				captureHeight = framebuffer->getHeight();
+			} else {
+				pixels.resize((size_t)width * height * 4);
+				glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+				glReadBuffer(GL_BACK);
+				glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+			}
+
+			// Drop the alpha, what ends up in it depends on the blending and isn't what is seen on screen
+			for (size_t i = 0, count = (size_t)captureWidth * captureHeight; i < count; i++) {
+				pixels[i * 3 + 0] = pixels[i * 4 + 0];
+				pixels[i * 3 + 1] = pixels[i * 4 + 1];
+				pixels[i * 3 + 2] = pixels[i * 4 + 2];
+			}
+
+			if (writePNG(path, captureWidth, captureHeight, 3, pixels.data(), true))
+				SHADO_CORE_INFO("Frame captured to {0}", path);
+		});
+	}
+
+	void Application::setFixedUpdateRate(float hz, uint32_t maxStepsPerFrame) {
+		SHADO_CORE_ASSERT(hz > 0.0f && maxStepsPerFrame > 0, "Invalid fixed update rate");
+		m_FixedTimeStep = 1.0f / hz;
+		m_MaxFixedSteps = maxStepsPerFrame;
+	}
+
+	void Application::setRenderThreadEnabled(bool enabled) {
+		SHADO_CORE_ASSERT(!RenderCommandQueue::IsThreaded(), "The render thread must be chosen before Application::run");
+		m_RenderThreadEnabled = enabled;
 	}
 
 	void Application::submit(Scene* scene) {
@@ -149,6 +491,14 @@ namespace Shado {
 	}
 
 	void Application::onEvent(Event& e) {
+		// The headless framebuffer keeps its size
+		EventDispatcher dispatcher(e);
+		dispatcher.dispatch<WindowResizeEvent>([this](WindowResizeEvent& event) {
+			if (!m_Framebuffer && event.getWidth() > 0 && event.getHeight() > 0)
+				updateSceneTarget(event.getWidth(), event.getHeight());
+			return false;
+		});
+
 		if (m_activeScene == nullptr)
 			return;
 		
@@ -210,6 +560,7 @@ namespace Shado {
 		singleton->m_Running = false;
 
 		delete singleton;
+		singleton = nullptr;
 	}
 
 	void Application::close() {
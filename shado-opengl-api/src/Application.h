@@ -4,18 +4,41 @@
 #include <vector>
 #include "Renderer2D.h"
 #include "Events/Event.h"
+#include "Framebuffer.h"
+#include "GpuTimer.h"
 #include "Window.h"
 #include "ui/ImguiScene.h"
+#include "util/DynamicResolution.h"
+#include "util/FrameLimiter.h"
+#include "util/TimerWheel.h"
 
 namespace Shado {
 
+	struct ApplicationSpecification {
+		std::string Name = "Shado OpenGL simple Rendering engine";
+		uint32_t Width = 1280;
+		uint32_t Height = 720;
+
+		// No visible window, frames are drawn to an offscreen framebuffer (see Application::getFramebuffer).
+		// The window is only hidden, a server still needs a display for it (Xvfb for instance)
+		bool Headless = false;
+		ContextAPI Context = ContextAPI::NATIVE;
+
+		uint32_t FrameCount = 0;		// Stop after that many frames, 0 to run until closed
+		float FixedFrameTime = 0.0f;	// Seconds given to every frame instead of the elapsed time, for reproducible runs
+		std::string CapturePath;		// PNG of the last frame, needs FrameCount
+	};
+
 	class Application {
 	public:
+		Application(const ApplicationSpecification& specification);
 		Application(unsigned int width, unsigned int height, const std::string& title);
 		Application();
 		~Application();
 
-		static Application& get() { return *singleton; }
+		// Must be called before the first get(), which otherwise creates a default application
+		static Application& create(const ApplicationSpecification& specification);
+		static Application& get();
 		static void destroy();
 
 		static void close();
@@ -27,16 +50,122 @@ namespace Shado {
 		void setActiveScene(Scene* scene);
 		void setActiveScene(const std::string& name);
 
+		// Call before run(). Drawing is then recorded on the main thread and replayed by a thread
+		// owning the GL context, one frame behind (see RenderCommandQueue). ImGui viewports are disabled
+		void setRenderThreadEnabled(bool enabled);
+		bool isRenderThreadEnabled() const { return m_RenderThreadEnabled; }
+
+		// Scene::onFixedUpdate and the physics run at `hz`, as many steps as the elapsed time calls for but
+		// at most maxStepsPerFrame. Time past that is dropped rather than simulated in one big step
+		void setFixedUpdateRate(float hz, uint32_t maxStepsPerFrame = 5);
+		float getFixedTimeStep() const { return m_FixedTimeStep; }
+
+		// Frame rate caps, 0 for none. The background one applies while the window is unfocused.
+		// Nothing is updated nor drawn while the window is minimized
+		void setTargetFrameRate(float fps)		{ m_TargetFrameRate = fps; }
+		void setBackgroundFrameRate(float fps)	{ m_BackgroundFrameRate = fps; }
+		float getTargetFrameRate() const		{ return m_TargetFrameRate; }
+		float getBackgroundFrameRate() const	{ return m_BackgroundFrameRate; }
+
+		// Over the last 512 frames, in ms
+		FrameTimeHistory::Percentiles getFrameTimePercentiles() const { return m_FrameTimes.getPercentiles(); }
+
+		// Breakdown of the last frame, in ms. The render thread's part lags one frame behind
+		struct FrameStats {
+			float FrameTime = 0.0f;
+			float UpdateTime = 0.0f;
+			float PhysicsTime = 0.0f;		// Fixed updates, and the steps unless they are async
+			float PhysicsWaitTime = 0.0f;	// Main thread blocked on the previous frame's async steps
+			float DrawTime = 0.0f;		// Scene::onDraw, recording only with the render thread
+			float ImGuiTime = 0.0f;
+			float WaitTime = 0.0f;		// Main thread blocked on the render thread
+			float RenderTime = 0.0f;	// Render thread replaying the frame
+			float SwapTime = 0.0f;		// Buffer swap and event polling
+			float LimiterTime = 0.0f;	// Slept or spun by the frame limiter
+			uint32_t CommandCount = 0;
+
+			// GPU time of each pass, a few frames late
+			float GpuSceneTime = 0.0f;
+			float GpuUpscaleTime = 0.0f;	// Resolve and stretch of the scaled/multisampled scenes
+			float GpuImGuiTime = 0.0f;
+			float RenderScale = 1.0f;
+
+			uint32_t FixedSteps = 0;		// Fixed updates run this frame
+			float DroppedTime = 0.0f;		// Simulation time skipped this frame
+			uint64_t TotalFixedSteps = 0;
+			float TotalDroppedTime = 0.0f;
+		};
+		const FrameStats& getFrameStats() const { return m_FrameStats; }
+
+		// Saves the current frame as a PNG once it is drawn
+		void captureFrame(const std::string& path) { m_CapturePath = path; }
+		uint64_t getFrameCount() const { return m_FrameCount; }
+
+		const ApplicationSpecification& getSpecification() const { return m_Specification; }
+		// Where frames are drawn in headless mode, null otherwise
+		const Ref<Framebuffer>& getFramebuffer() const { return m_Framebuffer; }
+
+		// Scenes are drawn at `scale` times the output resolution then stretched to it, below 1 when GPU bound.
+		// ImGui is always drawn at full resolution
+		void setRenderScale(float scale);
+		float getRenderScale() const { return m_RenderScale; }
+		// MSAA of the scenes' drawing, 1 for none
+		void setMultisampling(uint32_t samples);
+		uint32_t getMultisampling() const { return m_Samples; }
+
+		// Adjusts the render scale to keep the GPU time of a frame under targetFrameTime (ms). 0 aims at the
+		// target frame rate, or 60 fps without one. Disabling goes back to full resolution
+		void setDynamicResolution(bool enabled, float targetFrameTime = 0.0f);
+		bool isDynamicResolutionEnabled() const { return m_DynamicResolution; }
+		DynamicResolutionController& getDynamicResolutionController() { return m_ResolutionController; }
+
+		// Transient render targets, reused from one frame to the next
+		FramebufferPool& getFramebufferPool() { return m_FramebufferPool; }
+
+		// Advanced by the frame time before the scenes update, the callbacks run on the main thread
+		TimerWheel& getTimers() { return m_Timers; }
+
 		Window& getWindow()								{ return *window; }
 		const std::vector<Scene*>& getScenes()	const	{ return allScenes; }
 		const Scene& getActiveScene()			const	{ return *m_activeScene; }
 
 	private:
+		void capture(const std::string& path);
+		void updateSceneTarget(uint32_t outputWidth, uint32_t outputHeight);
+		void presentSceneTarget();
+
+	private:
+		ApplicationSpecification m_Specification;
 		ScopedPtr<Window> window;		// TODO: This might be a bad idea, might want to revert to std::unique_ptr
 		ImguiLayer* uiScene;
 		float m_LastFrameTime = 0.0f;	// Time took to render last frame	
 		
 		bool m_Running = true;
+		bool m_RenderThreadEnabled = false;
+		FrameStats m_FrameStats;
+		uint64_t m_FrameCount = 0;
+
+		Ref<Framebuffer> m_Framebuffer;
+		std::string m_CapturePath;
+
+		float m_RenderScale = 1.0f;
+		uint32_t m_Samples = 1;
+		Ref<Framebuffer> m_SceneTarget;	// Only when scaled or multisampled
+		FramebufferPool m_FramebufferPool;
+		TimerWheel m_Timers;
+
+		bool m_DynamicResolution = false;
+		DynamicResolutionController m_ResolutionController;
+		GpuTimer m_SceneTimer{ "Scenes" }, m_UpscaleTimer{ "Upscale" }, m_ImGuiTimer{ "ImGui" };
+
+		float m_FixedTimeStep = 1.0f / 60.0f;
+		uint32_t m_MaxFixedSteps = 5;
+		double m_FixedAccumulator = 0.0;
+
+		float m_TargetFrameRate = 0.0f;
+		float m_BackgroundFrameRate = 30.0f;
+		FrameLimiter m_FrameLimiter;
+		FrameTimeHistory m_FrameTimes;
 
 		std::vector<Scene*> allScenes;
 		Scene* m_activeScene = nullptr;
@@ -1,24 +1,41 @@
 #include "Buffer.h"
 
 #include "GL/glew.h"
+#include "RenderCommandQueue.h"
+#include "Stats.h"
 
 namespace Shado {
 
-	VertexBuffer::VertexBuffer(uint32_t size) {
+	static const StatHandle s_BufferMemory = Stats::Register("GPU.BufferMemory", StatKind::Gauge, StatUnit::Bytes);
+	static const StatHandle s_BytesUploaded = Stats::Register("GPU.BytesUploaded", StatKind::PerFrame, StatUnit::Bytes);
+
+	VertexBuffer::VertexBuffer(uint32_t size)
+		: m_Size(size)
+	{
 		glCreateBuffers(1, &m_RendererID);
-		glBindBuffer(GL_ARRAY_BUFFER, m_RendererID);
-		glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+		glNamedBufferData(m_RendererID, size, nullptr, GL_DYNAMIC_DRAW);
+		Stats::Add(s_BufferMemory, size);
 	}
 
 	VertexBuffer::VertexBuffer(float* vertices, uint32_t size)
+		: m_Size(size)
 	{
 		glCreateBuffers(1, &m_RendererID);
-		glBindBuffer(GL_ARRAY_BUFFER, m_RendererID);
-		glBufferData(GL_ARRAY_BUFFER, size, vertices, GL_STATIC_DRAW);
+		glNamedBufferData(m_RendererID, size, vertices, GL_STATIC_DRAW);
+		Stats::Add(s_BufferMemory, size);
+		Stats::Add(s_BytesUploaded, size);
 	}
 
 	VertexBuffer::~VertexBuffer() {
-		glDeleteBuffers(1, &m_RendererID);
+		if (m_Parent)
+			return;
+
+		Stats::Add(s_BufferMemory, -(int64_t)m_Size);
+
+		// Frames already recorded may still use it
+		RenderCommandQueue::Submit([id = m_RendererID]() {
+			glDeleteBuffers(1, &id);
+		});
 	}
 
 	void VertexBuffer::bind() const {
@@ -33,33 +50,146 @@ namespace Shado {
 		return std::make_shared<VertexBuffer>(vertices, size);
 	}
 
-	void VertexBuffer::setData(const void* data, size_t size) {
-		glBindBuffer(GL_ARRAY_BUFFER, m_RendererID);
-		glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
+	void VertexBuffer::setData(const void* data, size_t size, size_t offset) {
+		SHADO_CORE_ASSERT(offset + size <= m_Size, "Vertex buffer overflow!");
+		glNamedBufferSubData(m_RendererID, m_Offset + offset, size, data);
+		Stats::Add(s_BytesUploaded, size);
 	}
 
 	std::shared_ptr<VertexBuffer> VertexBuffer::create(uint32_t size) {
 		return std::make_shared<VertexBuffer>(size);
 	}
 
+	std::shared_ptr<VertexBuffer> VertexBuffer::createView(const std::shared_ptr<VertexBuffer>& parent, uint32_t offset, uint32_t size) {
+		SHADO_CORE_ASSERT(offset + size <= parent->m_Size, "Vertex buffer view out of range!");
+
+		std::shared_ptr<VertexBuffer> view(new VertexBuffer());
+		view->m_RendererID = parent->m_RendererID;
+		view->m_Offset = parent->m_Offset + offset;
+		view->m_Size = size;
+		view->m_Layout = parent->m_Layout;
+		view->m_Parent = parent;
+		return view;
+	}
+
 	// ========================================
-	std::shared_ptr<IndexBuffer> IndexBuffer::create(uint32_t* indices, uint32_t count) {
+	std::shared_ptr<IndexBuffer> IndexBuffer::create(const uint32_t* indices, uint32_t count) {
 		return std::make_shared<IndexBuffer>(indices, count);
 	}
 
-	IndexBuffer::IndexBuffer(uint32_t* indices, uint32_t count)
+	std::shared_ptr<IndexBuffer> IndexBuffer::create(const uint16_t* indices, uint32_t count) {
+		return std::make_shared<IndexBuffer>(indices, count);
+	}
+
+	std::shared_ptr<IndexBuffer> IndexBuffer::getQuadIndexBuffer() {
+		// Only a weak reference is kept so the buffer dies with the last renderer using it
+		static std::weak_ptr<IndexBuffer> s_QuadIndexBuffer;
+
+		if (auto buffer = s_QuadIndexBuffer.lock())
+			return buffer;
+
+		std::vector<uint16_t> indices(MaxQuads16 * 6);
+
+		uint16_t offset = 0;
+		for (uint32_t i = 0; i < indices.size(); i += 6)
+		{
+			indices[i + 0] = offset + 0;
+			indices[i + 1] = offset + 1;
+			indices[i + 2] = offset + 2;
+
+			indices[i + 3] = offset + 2;
+			indices[i + 4] = offset + 3;
+			indices[i + 5] = offset + 0;
+
+			offset += 4;
+		}
+
+		auto buffer = create(indices.data(), (uint32_t)indices.size());
+		s_QuadIndexBuffer = buffer;
+		return buffer;
+	}
+
+	std::shared_ptr<IndexBuffer> IndexBuffer::createView(const std::shared_ptr<IndexBuffer>& parent, uint32_t offset, uint32_t count, uint32_t type) {
+		std::shared_ptr<IndexBuffer> view(new IndexBuffer());
+		view->m_RendererID = parent->m_RendererID;
+		view->m_Offset = parent->m_Offset + offset;
+		view->m_Count = count;
+		view->m_Type = type;
+		view->m_IndexSize = type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+		view->m_Parent = parent;
+
+		SHADO_CORE_ASSERT(offset + view->getSize() <= parent->getSize(), "Index buffer view out of range!");
+		return view;
+	}
+
+	std::vector<uint16_t> IndexBuffer::narrow(const uint32_t* indices, uint32_t count) {
+		std::vector<uint16_t> narrowed(count);
+		for (uint32_t i = 0; i < count; i++) {
+			if (indices[i] == RestartIndex)
+				narrowed[i] = RestartIndex16;
+			else if (indices[i] < RestartIndex16)
+				narrowed[i] = (uint16_t)indices[i];
+			else
+				return {};
+		}
+		return narrowed;
+	}
+
+	IndexBuffer::IndexBuffer(const uint32_t* indices, uint32_t count)
 		:m_Count(count)
+	{
+		// Narrow to 16 bits when possible, halves the memory and the bandwidth
+		std::vector<uint16_t> narrowed = narrow(indices, count);
+
+		if (!narrowed.empty() || count == 0) {
+			m_Type = GL_UNSIGNED_SHORT;
+			m_IndexSize = sizeof(uint16_t);
+			upload(narrowed.data(), count * sizeof(uint16_t));
+		} else {
+			m_Type = GL_UNSIGNED_INT;
+			m_IndexSize = sizeof(uint32_t);
+			upload(indices, count * sizeof(uint32_t));
+		}
+	}
+
+	IndexBuffer::IndexBuffer(const uint16_t* indices, uint32_t count)
+		:m_Count(count), m_Type(GL_UNSIGNED_SHORT), m_IndexSize(sizeof(uint16_t))
+	{
+		upload(indices, count * sizeof(uint16_t));
+	}
+
+	IndexBuffer::IndexBuffer(uint32_t size)
+		:m_Count(size / sizeof(uint32_t)), m_Type(GL_UNSIGNED_INT), m_IndexSize(sizeof(uint32_t))
 	{
 		glCreateBuffers(1, &m_RendererID);
+		glNamedBufferData(m_RendererID, size, nullptr, GL_DYNAMIC_DRAW);
+		Stats::Add(s_BufferMemory, getSize());
+	}
 
-		// GL_ELEMENT_ARRAY_BUFFER is not valid without an actively bound VAO
-		// Binding with GL_ARRAY_BUFFER allows the data to be loaded regardless of VAO state. 
-		glBindBuffer(GL_ARRAY_BUFFER, m_RendererID);
-		glBufferData(GL_ARRAY_BUFFER, count * sizeof(uint32_t), indices, GL_STATIC_DRAW);
+	void IndexBuffer::setData(const void* data, uint32_t size, uint32_t offset) {
+		SHADO_CORE_ASSERT(offset + size <= getSize(), "Index buffer overflow!");
+		glNamedBufferSubData(m_RendererID, m_Offset + offset, size, data);
+		Stats::Add(s_BytesUploaded, size);
+	}
+
+	void IndexBuffer::upload(const void* data, uint32_t size) {
+		// Named buffers don't care about the bound VAO, no need to go through GL_ELEMENT_ARRAY_BUFFER
+		glCreateBuffers(1, &m_RendererID);
+		glNamedBufferData(m_RendererID, size, data, GL_STATIC_DRAW);
+		Stats::Add(s_BufferMemory, size);
+		Stats::Add(s_BytesUploaded, size);
 	}
 
 	IndexBuffer::~IndexBuffer() {
-		glDeleteBuffers(1, &m_RendererID);
+		if (m_Parent)
+			return;
+
+		Stats::Add(s_BufferMemory, -(int64_t)getSize());
+
+		// Frames already recorded may still use it
+		RenderCommandQueue::Submit([id = m_RendererID]() {
+			glDeleteBuffers(1, &id);
+		});
 	}
 
 	void IndexBuffer::bind() const {
@@ -8,7 +8,13 @@ namespace Shado {
 	
 	enum class ShaderDataType
 	{
-		None = 0, Float, Float2, Float3, Float4, Mat3, Mat4, Int, Int2, Int3, Int4, Bool
+		None = 0, Float, Float2, Float3, Float4, Mat3, Mat4, Int, Int2, Int3, Int4, Bool,
+
+		// Packed formats
+		UByte4Norm,		// 4 x 8 bits unsigned, normalized to [0, 1] (e.g. colors from glm::packUnorm4x8)
+		Half, Half2, Half4,	// 16 bits floats (glm::packHalf1x16, glm::packHalf2x16)
+		Int10_10_10_2,	// 3 x 10 bits + 2 bits signed, normalized to [-1, 1] (e.g. normals from glm::packSnorm3x10_1x2)
+		UShort			// 16 bits unsigned integer, read as uint in the shader
 	};
 
 	static uint32_t ShaderDataTypeSize(ShaderDataType type)
@@ -26,6 +32,12 @@ namespace Shado {
 		case ShaderDataType::Int3:     return 4 * 3;
 		case ShaderDataType::Int4:     return 4 * 4;
 		case ShaderDataType::Bool:     return 1;
+		case ShaderDataType::UByte4Norm:    return 4;
+		case ShaderDataType::Half:          return 2;
+		case ShaderDataType::Half2:         return 2 * 2;
+		case ShaderDataType::Half4:         return 2 * 4;
+		case ShaderDataType::Int10_10_10_2: return 4;
+		case ShaderDataType::UShort:        return 2;
 		}
 
 		SHADO_CORE_ASSERT(false, "Unknown ShaderDataType!");
@@ -43,7 +55,8 @@ namespace Shado {
 		BufferElement() = default;
 
 		BufferElement(ShaderDataType type, const std::string& name, bool normalized = false)
-			: Name(name), Type(type), Size(ShaderDataTypeSize(type)), Offset(0), Normalized(normalized)
+			: Name(name), Type(type), Size(ShaderDataTypeSize(type)), Offset(0),
+			Normalized(normalized || type == ShaderDataType::UByte4Norm || type == ShaderDataType::Int10_10_10_2)
 		{
 		}
 
@@ -62,6 +75,12 @@ namespace Shado {
 			case ShaderDataType::Int3:    return 3;
 			case ShaderDataType::Int4:    return 4;
 			case ShaderDataType::Bool:    return 1;
+			case ShaderDataType::UByte4Norm:    return 4;
+			case ShaderDataType::Half:          return 1;
+			case ShaderDataType::Half2:         return 2;
+			case ShaderDataType::Half4:         return 4;
+			case ShaderDataType::Int10_10_10_2: return 4;
+			case ShaderDataType::UShort:        return 1;
 			}
 
 			SHADO_CORE_ASSERT(false, "Unknown ShaderDataType!");
@@ -116,19 +135,44 @@ namespace Shado {
 		virtual void setLayout(const BufferLayout& layout) { m_Layout = layout; };
 		virtual const BufferLayout& getLayout() const { return m_Layout; };
 
-		virtual void setData(const void* data, size_t size);
+		// offset is relative to the start of the buffer (or of the view)
+		virtual void setData(const void* data, size_t size, size_t offset = 0);
+
+		uint32_t getRendererID() const { return m_RendererID; }
+		uint32_t getSize() const { return m_Size; }
+		uint32_t getOffset() const { return m_Offset; }
 
 		static std::shared_ptr<VertexBuffer> create(uint32_t size);
 		static std::shared_ptr<VertexBuffer> create(float* vertices, uint32_t size);
 
+		// Range of `parent` starting at `offset` bytes. Views don't own any GL object, they keep their parent alive instead
+		static std::shared_ptr<VertexBuffer> createView(const std::shared_ptr<VertexBuffer>& parent, uint32_t offset, uint32_t size);
+
+	private:
+		VertexBuffer() = default;
+
 	private:
 		uint32_t m_RendererID;
+		uint32_t m_Size = 0;
+		uint32_t m_Offset = 0;
 		BufferLayout m_Layout;
+		std::shared_ptr<VertexBuffer> m_Parent;
 	};
 
+	// Indices are stored as 16 bits whenever the biggest index fits, 32 bits otherwise.
+	// RestartIndex marks a primitive restart in the source data and is narrowed along with the rest
+	// (GL_PRIMITIVE_RESTART_FIXED_INDEX is enabled by Renderer2D::Init)
 	class IndexBuffer {
 	public:
-		IndexBuffer(uint32_t* indices, uint32_t count);
+		static constexpr uint32_t RestartIndex = 0xFFFFFFFF;
+		static constexpr uint16_t RestartIndex16 = 0xFFFF;
+
+		// Quads that fit in a 16 bit index buffer without hitting the restart index
+		static constexpr uint32_t MaxQuads16 = RestartIndex16 / 4;
+
+		IndexBuffer(const uint32_t* indices, uint32_t count);
+		IndexBuffer(const uint16_t* indices, uint32_t count);
+		IndexBuffer(uint32_t size);		// Empty buffer of `size` bytes, filled with setData
 		virtual ~IndexBuffer();
 
 		virtual void bind() const;
@@ -138,10 +182,37 @@ namespace Shado {
 			return m_Count;
 		}
 
-		static std::shared_ptr<IndexBuffer> create(uint32_t* indices, uint32_t size);
+		// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, to pass to glDrawElements
+		uint32_t getType() const { return m_Type; }
+		uint32_t getIndexSize() const { return m_IndexSize; }
+		uint32_t getSize() const { return m_Count * m_IndexSize; }
+		uint32_t getOffset() const { return m_Offset; }		// In bytes, to pass as the indices pointer of glDrawElements
+		uint32_t getRendererID() const { return m_RendererID; }
+
+		void setData(const void* data, uint32_t size, uint32_t offset = 0);
+
+		static std::shared_ptr<IndexBuffer> create(const uint32_t* indices, uint32_t size);
+		static std::shared_ptr<IndexBuffer> create(const uint16_t* indices, uint32_t size);
+
+		// `count` indices of type `type` starting at `offset` bytes in `parent`
+		static std::shared_ptr<IndexBuffer> createView(const std::shared_ptr<IndexBuffer>& parent, uint32_t offset, uint32_t count, uint32_t type);
+
+		// Returns the indices as 16 bits, or nothing if one of them doesn't fit
+		static std::vector<uint16_t> narrow(const uint32_t* indices, uint32_t count);
+
+		// Canonical 0 1 2 2 3 0 pattern for MaxQuads16 quads, shared by every quad shaped batch
+		static std::shared_ptr<IndexBuffer> getQuadIndexBuffer();
+
+	private:
+		IndexBuffer() = default;
+		void upload(const void* data, uint32_t size);
 
 	private:
 		uint32_t m_RendererID;
 		uint32_t m_Count;
+		uint32_t m_Type;
+		uint32_t m_IndexSize;
+		uint32_t m_Offset = 0;
+		std::shared_ptr<IndexBuffer> m_Parent;
 	};
 }
@@ -5,7 +5,6 @@
 #include <iostream>
 #include <ctime>
 
-#include <Windows.h>
 #include "spdlog/sinks/stdout_color_sinks.h"
 #include "spdlog/sinks/basic_file_sink.h"
 #include <memory>
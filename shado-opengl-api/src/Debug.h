@@ -1,6 +1,13 @@
 ﻿#pragma once
 
-#define ASSERT(x) if (!(x))	__debugbreak();
+#ifdef SHADO_PLATFORM_WINDOWS
+#define SHADO_DEBUGBREAK() __debugbreak()
+#else
+#include <csignal>
+#define SHADO_DEBUGBREAK() raise(SIGTRAP)
+#endif
+
+#define ASSERT(x) if (!(x))	SHADO_DEBUGBREAK();
 #define glCall(x) GLClearError();\
 					x;\
 					ASSERT(GLCheckError(#x, __FILE__, __LINE__))
@@ -35,8 +42,8 @@ namespace Shado {
 
 
 #ifdef SHADO_ENABLE_ASSERTS
-#define SHADO_ASSERT(x, ...) { if(!(x)) { SHADO_ERROR("Assertion Failed: {0}", __VA_ARGS__); __debugbreak(); } }
-#define SHADO_CORE_ASSERT(x, ...) { if(!(x)) { SHADO_CORE_ERROR("Assertion Failed: {0}", __VA_ARGS__); __debugbreak(); } }
+#define SHADO_ASSERT(x, ...) { if(!(x)) { SHADO_ERROR("Assertion Failed: {0}", __VA_ARGS__); SHADO_DEBUGBREAK(); } }
+#define SHADO_CORE_ASSERT(x, ...) { if(!(x)) { SHADO_CORE_ERROR("Assertion Failed: {0}", __VA_ARGS__); SHADO_DEBUGBREAK(); } }
 #else
 #define SHADO_ASSERT(x, ...)
 #define SHADO_CORE_ASSERT(x, ...)
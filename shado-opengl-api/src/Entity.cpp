@@ -1,88 +1,152 @@
 ﻿#include "Entity.h"
+#include "Layer.h"
 #include "box2d/b2_world.h"
-#include "box2d/b2_fixture.h"
-#include "box2d/b2_polygon_shape.h"
 #include "Renderer2D.h"
+#include <glm/gtc/packing.hpp>
+#include <cmath>
 
 
 namespace Shado {
 
-	Entity::Entity(const EntityDefinition& definition, b2World& world)
-		: name(definition.name), scale(definition.scale), texture(definition.texture), tilingfactor(definition.tillingfactor), color(definition.color)
+	Entity::Entity(EntityHandle handle, Scene* scene)
+		: m_Handle(handle), m_Scene(scene)
 	{
-		id = rand();
-		z = definition.position.z;
-
-		// Create box2D body
-		b2BodyDef bodyDef;
-		bodyDef.type = (b2BodyType)definition.type;
-		bodyDef.position.Set(definition.position.x, definition.position.y);
-		
-		b2PolygonShape dynamicBox;
-		dynamicBox.SetAsBox(definition.scale.x / 2.0f, definition.scale.y / 2.0f);
-
-		b2FixtureDef fixtureDef;
-		fixtureDef.shape = &dynamicBox;
-		fixtureDef.density = definition.density;
-		fixtureDef.friction = definition.friction;
-
-		b2Body* body = world.CreateBody(&bodyDef);
-		body->CreateFixture(&fixtureDef);
-
-		this->body = body;
-		this->isAlive = true;
 	}
 
-	Entity::~Entity() {}
-
 	void Entity::draw() const {
-		if (!isAlive)
+		if (!isValid())
 			return;
-		
-		const b2Vec2& position = body->GetPosition();
-		float angle = body->GetAngle();
-		
-		if (texture) {
-			Renderer2D::DrawRotatedQuad({ position.x, position.y, z }, scale, angle, texture, tilingfactor);
-		} else
-		{
-			Renderer2D::DrawRotatedQuad({ position.x, position.y, z }, scale, angle, color);
-		}
+
+		const Transform& transform = getComponent<Transform>();
+		const Sprite& sprite = getComponent<Sprite>();
+
+		// A batch of one, Scene::drawEntities does the same for all the visible entities
+		const uint32_t color = sprite.texture ? 0xFFFFFFFF : glm::packUnorm4x8((glm::vec4)sprite.color);
+		const uint16_t textureId = 0;
+		const float tilingFactor = (float)sprite.tilingfactor;
+
+		Renderer2D::SpriteArrays sprites;
+		sprites.Count = 1;
+		sprites.X = &transform.position.x;
+		sprites.Y = &transform.position.y;
+		sprites.Z = &transform.position.z;
+		sprites.Width = &transform.scale.x;
+		sprites.Height = &transform.scale.y;
+		sprites.Angles = &transform.rotation;
+		sprites.Colors = &color;
+		sprites.TextureIds = sprite.texture ? &textureId : nullptr;
+		sprites.TilingFactors = &tilingFactor;
+		sprites.Textures = &sprite.texture;
+		sprites.TextureCount = 1;
+		Renderer2D::DrawSprites(sprites);
 	}
 
 	void Entity::destroy() {
-		body->GetWorld()->DestroyBody(body);
-		isAlive = false;
+		if (isValid())
+			m_Scene->destroyEntity(*this);
 	}
 
 	Entity& Entity::setName(const std::string& name) {
-		this->name = name;
+		m_Scene->setEntityName(m_Handle, name);
 		return *this;
 	}
 
 	Entity& Entity::setTexture(Ref<Texture2D> texture) {
-		this->texture = texture;
+		getComponent<Sprite>().texture = texture;
+		m_Scene->refreshQuad(m_Handle);
 		return *this;
 	}
 
 	Entity& Entity::setTexture(const std::string& path) {
-		texture = CreateRef<Texture2D>(path);
+		getComponent<Sprite>().texture = CreateRef<Texture2D>(path);
+		m_Scene->refreshQuad(m_Handle);
 		return *this;
 	}
 
 	Entity& Entity::setTillingFactor(uint32_t factor) {
-		this->tilingfactor = factor;
+		getComponent<Sprite>().tilingfactor = factor;
+		m_Scene->refreshQuad(m_Handle);
 		return *this;
 	}
 
 	Entity& Entity::setColor(const Color& color) {
-		this->color = color;
+		getComponent<Sprite>().color = color;
+		m_Scene->refreshQuad(m_Handle);
 		return *this;
 	}
 
 	Entity& Entity::setType(const EntityType& type) {
-		body->SetType((b2BodyType)type);
+		m_Scene->setBodyType(m_Handle, type);
+		return *this;
+	}
+
+	Entity& Entity::setPosition(const glm::vec2& position) {
+		m_Scene->waitForPhysics();
+
+		RigidBody& rigidBody = getComponent<RigidBody>();
+		rigidBody.body->SetTransform({ position.x, position.y }, rigidBody.body->GetAngle());
+
+		Transform& transform = getComponent<Transform>();
+		transform.position.x = position.x;
+		transform.position.y = position.y;
+		m_Scene->onTeleported(m_Handle);
 
 		return *this;
 	}
+
+	AABB Entity::getBounds() const {
+		return getComponent<Transform>().getBounds();
+	}
+
+	bool Entity::containsPoint(const glm::vec2& point) const {
+		const Transform& transform = getComponent<Transform>();
+
+		// Bring the point in the entity's local space
+		float dx = point.x - transform.position.x;
+		float dy = point.y - transform.position.y;
+		float c = std::cos(-transform.rotation);
+		float s = std::sin(-transform.rotation);
+		float lx = c * dx - s * dy;
+		float ly = s * dx + c * dy;
+
+		return std::abs(lx) <= transform.scale.x / 2.0f && std::abs(ly) <= transform.scale.y / 2.0f;
+	}
+
+	bool Entity::isValid() const {
+		return m_Scene != nullptr && m_Scene->getRegistry().isValid(m_Handle);
+	}
+
+	uint64_t Entity::getId() const {
+		return getComponent<EntityInfo>().id;
+	}
+
+	float Entity::getZ() const {
+		return getComponent<Transform>().position.z;
+	}
+
+	glm::vec2 Entity::getScale() const {
+		return getComponent<Transform>().scale;
+	}
+
+	const std::string& Entity::getName() const {
+		return m_Scene->getNames().get(getComponent<EntityInfo>().name);
+	}
+
+	Ref<Texture2D> Entity::getTexture() const {
+		return getComponent<Sprite>().texture;
+	}
+
+	uint32_t Entity::getTillingFactor() const {
+		return getComponent<Sprite>().tilingfactor;
+	}
+
+	Color Entity::getColor() const {
+		return getComponent<Sprite>().color;
+	}
+
+	b2Body* Entity::getNativeBody() const {
+		// The body may be in the middle of a step
+		m_Scene->waitForPhysics();
+		return getComponent<RigidBody>().body;
+	}
 }
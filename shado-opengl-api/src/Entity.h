@@ -4,8 +4,13 @@
 #include "box2d/b2_body.h"
 #include "Texture2D.h"
 #include "util/Util.h"
+#include "util/Bounds.h"
+#include "ecs/Registry.h"
+#include "ecs/Components.h"
 
 namespace Shado {
+	class Scene;
+
 	enum class EntityType {
 		STATIC = 0,
 		KINEMATIC,
@@ -17,6 +22,7 @@ namespace Shado {
 		EntityType type = EntityType::STATIC;
 
 		glm::vec3 position = {0, 0, 0};
+		float rotation = 0.0f;		// Radians
 		glm::vec2 scale = {1, 1};
 
 		Ref<Texture2D> texture = nullptr;
@@ -26,11 +32,16 @@ namespace Shado {
 		float density = 1.0f;
 		float friction = 0.3f;
 	};
-	
+
+	/**
+	 * Handle to an entity of a scene. The data lives in the scene's registry (see ecs/Components.h),
+	 * an Entity is only the handle and the scene, cheap to copy and pass by value.
+	 * Once the entity is destroyed every copy becomes invalid, isValid() tells.
+	 */
 	class Entity {
 	public:
-		Entity(const EntityDefinition& definition, b2World& world);
-		~Entity();
+		Entity() = default;
+		Entity(EntityHandle handle, Scene* scene);
 
 		void draw() const;
 		void destroy();
@@ -41,27 +52,36 @@ namespace Shado {
 		Entity& setTillingFactor(uint32_t tillingfactor);
 		Entity& setColor(const Color& color);
 		Entity& setType(const EntityType& type);
+		Entity& setPosition(const glm::vec2& position);
 
-		uint64_t getId()			const	{ return id; }
-		std::string getName()		const	{ return name; }
-		Ref<Texture2D> getTexture() const	{ return texture; }
-		uint32_t getTillingFactor() const	{ return tilingfactor; }
-		Color	getColor()			const	{ return color; }
-		b2Body* getNativeBody()				{ return body; }
-		
-	private:
-		uint64_t id;
-		std::string name;
+		// World space bounds of the (rotated) quad
+		AABB getBounds() const;
+		bool containsPoint(const glm::vec2& point) const;
 
-		glm::vec2 scale;
-		float z;
-		
-		Ref<Texture2D> texture;
-		uint32_t tilingfactor;
-		Color color;
+		bool isValid()				const;
+		explicit operator bool()	const	{ return isValid(); }
+		bool operator==(const Entity& other) const { return m_Handle == other.m_Handle && m_Scene == other.m_Scene; }
+		bool operator!=(const Entity& other) const { return !(*this == other); }
 
-		b2Body* body;
+		EntityHandle getHandle()	const	{ return m_Handle; }
+		Scene* getScene()			const	{ return m_Scene; }
 
-		bool isAlive;
+		uint64_t getId()			const;
+		float getZ()				const;
+		glm::vec2 getScale()		const;
+		const std::string& getName() const;
+		Ref<Texture2D> getTexture() const;
+		uint32_t getTillingFactor() const;
+		Color	getColor()			const;
+		b2Body* getNativeBody()		const;
+
+		template<typename T>
+		T& getComponent() const;
+		template<typename T>
+		bool hasComponent() const;
+
+	private:
+		EntityHandle m_Handle;
+		Scene* m_Scene = nullptr;
 	};
 }
@@ -0,0 +1,278 @@
+#include "Framebuffer.h"
+
+#include <algorithm>
+#include "GL/glew.h"
+#include "Debug.h"
+#include "RenderCommandQueue.h"
+#include "RenderState.h"
+#include "Stats.h"
+
+namespace Shado {
+
+	static const StatHandle s_FramebufferMemory = Stats::Register("GPU.FramebufferMemory", StatKind::Gauge, StatUnit::Bytes);
+
+	static bool isDepthFormat(FramebufferTextureFormat format) {
+		return format == FramebufferTextureFormat::DEPTH24STENCIL8;
+	}
+
+	static FramebufferTextureFormat getColorFormat(const FramebufferSpecification& specification, uint32_t colorIndex) {
+		for (FramebufferTextureFormat format : specification.Attachments) {
+			if (!isDepthFormat(format) && colorIndex-- == 0)
+				return format;
+		}
+		return FramebufferTextureFormat::None;
+	}
+
+	static GLenum toGLInternalFormat(FramebufferTextureFormat format) {
+		switch (format) {
+		case FramebufferTextureFormat::RGBA8:			return GL_RGBA8;
+		case FramebufferTextureFormat::RGBA16F:			return GL_RGBA16F;
+		case FramebufferTextureFormat::RED_INTEGER:		return GL_R32I;
+		case FramebufferTextureFormat::DEPTH24STENCIL8:	return GL_DEPTH24_STENCIL8;
+		default:
+			SHADO_CORE_ASSERT(false, "Unknown framebuffer texture format");
+			return 0;
+		}
+	}
+
+	static uint32_t bytesPerPixel(FramebufferTextureFormat format) {
+		return format == FramebufferTextureFormat::RGBA16F ? 8 : 4;
+	}
+
+	static uint32_t createAttachment(FramebufferTextureFormat format, uint32_t samples, uint32_t width, uint32_t height) {
+		uint32_t texture;
+
+		if (samples > 1) {
+			glCreateTextures(GL_TEXTURE_2D_MULTISAMPLE, 1, &texture);
+			glTextureStorage2DMultisample(texture, samples, toGLInternalFormat(format), width, height, GL_FALSE);
+			return texture;
+		}
+
+		glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+		glTextureStorage2D(texture, 1, toGLInternalFormat(format), width, height);
+
+		// Integer textures can't be filtered
+		const GLint filter = format == FramebufferTextureFormat::RED_INTEGER ? GL_NEAREST : GL_LINEAR;
+		glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, filter);
+		glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, filter);
+		glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		return texture;
+	}
+
+	// =========================== FRAMEBUFFER ===========================
+
+	Ref<Framebuffer> Framebuffer::create(const FramebufferSpecification& specification) {
+		return CreateRef<Framebuffer>(specification);
+	}
+
+	Ref<Framebuffer> Framebuffer::create(uint32_t width, uint32_t height) {
+		return CreateRef<Framebuffer>(width, height);
+	}
+
+	Framebuffer::Framebuffer(const FramebufferSpecification& specification)
+		: m_Specification(specification), m_Target(CreateRef<Target>())
+	{
+		SHADO_CORE_ASSERT(std::count_if(specification.Attachments.begin(), specification.Attachments.end(), isDepthFormat) <= 1,
+			"A framebuffer has at most one depth attachment");
+		SHADO_CORE_ASSERT(specification.Samples > 0, "A framebuffer needs at least one sample");
+
+		invalidate();
+	}
+
+	Framebuffer::Framebuffer(uint32_t width, uint32_t height)
+		: Framebuffer(FramebufferSpecification{ width, height })
+	{
+	}
+
+	Framebuffer::~Framebuffer() {
+		release();
+
+		RenderCommandQueue::Submit([target = m_Target]() {
+			if (target->RendererID)
+				glDeleteFramebuffers(1, &target->RendererID);
+		});
+	}
+
+	void Framebuffer::bind() const {
+		if (m_Target->AttachmentsChanged)
+			m_Target->attach();
+
+		glBindFramebuffer(GL_FRAMEBUFFER, m_Target->RendererID);
+		glViewport(0, 0, m_Target->Width, m_Target->Height);
+	}
+
+	void Framebuffer::unbind() const {
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	void Framebuffer::resize(uint32_t width, uint32_t height) {
+		if (width == 0 || height == 0 || (width == m_Specification.Width && height == m_Specification.Height))
+			return;
+
+		m_Specification.Width = width;
+		m_Specification.Height = height;
+		invalidate();
+	}
+
+	void Framebuffer::blit(const Framebuffer& target, uint32_t attachmentIndex, bool depth, bool linearFilter) const {
+		Target& source = *m_Target;
+		Target& destination = *target.m_Target;
+		SHADO_CORE_ASSERT(attachmentIndex < source.ColorAttachments.size(), "Invalid color attachment");
+		SHADO_CORE_ASSERT(m_Specification.Samples == 1 || (source.Width == destination.Width && source.Height == destination.Height),
+			"A multisampled framebuffer can only be resolved into one of the same size");
+
+		if (source.AttachmentsChanged)
+			source.attach();
+		if (destination.AttachmentsChanged)
+			destination.attach();
+
+		GLbitfield mask = GL_COLOR_BUFFER_BIT;
+		if (depth)
+			mask |= GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT;
+
+		// Depth, stencil and integer formats only blit with GL_NEAREST
+		const bool integer = getColorFormat(m_Specification, attachmentIndex) == FramebufferTextureFormat::RED_INTEGER;
+		const GLenum filter = linearFilter && !depth && !integer ? GL_LINEAR : GL_NEAREST;
+
+		glNamedFramebufferReadBuffer(source.RendererID, GL_COLOR_ATTACHMENT0 + attachmentIndex);
+		glBlitNamedFramebuffer(source.RendererID, destination.RendererID,
+			0, 0, source.Width, source.Height,
+			0, 0, destination.Width, destination.Height,
+			mask, filter);
+	}
+
+	void Framebuffer::blitToScreen(uint32_t width, uint32_t height, uint32_t attachmentIndex, bool linearFilter) const {
+		Target& source = *m_Target;
+		SHADO_CORE_ASSERT(attachmentIndex < source.ColorAttachments.size(), "Invalid color attachment");
+		SHADO_CORE_ASSERT(m_Specification.Samples == 1 || (source.Width == width && source.Height == height),
+			"A multisampled framebuffer can only be resolved into one of the same size");
+
+		if (source.AttachmentsChanged)
+			source.attach();
+
+		glNamedFramebufferReadBuffer(source.RendererID, GL_COLOR_ATTACHMENT0 + attachmentIndex);
+		glBlitNamedFramebuffer(source.RendererID, 0,
+			0, 0, source.Width, source.Height,
+			0, 0, width, height,
+			GL_COLOR_BUFFER_BIT, linearFilter ? GL_LINEAR : GL_NEAREST);
+	}
+
+	void Framebuffer::readPixels(std::vector<uint8_t>& pixels, uint32_t attachmentIndex) const {
+		const Target& target = *m_Target;
+		SHADO_CORE_ASSERT(m_Specification.Samples == 1, "Can't read a multisampled framebuffer, blit it first");
+		SHADO_CORE_ASSERT(attachmentIndex < target.ColorAttachments.size(), "Invalid color attachment");
+
+		pixels.resize((size_t)target.Width * target.Height * 4);
+		glGetTextureImage(target.ColorAttachments[attachmentIndex], 0, GL_RGBA, GL_UNSIGNED_BYTE, (GLsizei)pixels.size(), pixels.data());
+	}
+
+	int Framebuffer::readPixel(uint32_t attachmentIndex, int x, int y) const {
+		const Target& target = *m_Target;
+		SHADO_CORE_ASSERT(m_Specification.Samples == 1, "Can't read a multisampled framebuffer, blit it first");
+		SHADO_CORE_ASSERT(attachmentIndex < target.ColorAttachments.size(), "Invalid color attachment");
+
+		int value = 0;
+		glGetTextureSubImage(target.ColorAttachments[attachmentIndex], 0, x, y, 0, 1, 1, 1, GL_RED_INTEGER, GL_INT, sizeof(value), &value);
+		return value;
+	}
+
+	void Framebuffer::invalidate() {
+		release();
+
+		// Textures are shared between contexts, they can be made right away
+		for (FramebufferTextureFormat format : m_Specification.Attachments) {
+			uint32_t texture = createAttachment(format, m_Specification.Samples, m_Specification.Width, m_Specification.Height);
+			if (isDepthFormat(format))
+				m_DepthAttachment = texture;
+			else
+				m_ColorAttachments.push_back(texture);
+
+			m_MemorySize += (uint64_t)m_Specification.Width * m_Specification.Height * m_Specification.Samples * bytesPerPixel(format);
+		}
+		Stats::Add(s_FramebufferMemory, m_MemorySize);
+		SHADO_CORE_ASSERT(m_ColorAttachments.size() <= 8, "A framebuffer has at most 8 color attachments");
+
+		RenderCommandQueue::Submit([target = m_Target, colors = m_ColorAttachments, depth = m_DepthAttachment,
+			width = m_Specification.Width, height = m_Specification.Height]() {
+			target->ColorAttachments = colors;
+			target->DepthAttachment = depth;
+			target->Width = width;
+			target->Height = height;
+			target->AttachmentsChanged = true;
+		});
+	}
+
+	void Framebuffer::release() {
+		if (m_ColorAttachments.empty() && !m_DepthAttachment)
+			return;
+
+		// Frames already recorded may still render into them. The framebuffer object itself is
+		// kept for the new attachments
+		RenderCommandQueue::Submit([colors = m_ColorAttachments, depth = m_DepthAttachment]() {
+			for (uint32_t color : colors) {
+				RenderState::OnTextureDeleted(color);
+				glDeleteTextures(1, &color);
+			}
+
+			if (depth) {
+				RenderState::OnTextureDeleted(depth);
+				glDeleteTextures(1, &depth);
+			}
+		});
+
+		m_ColorAttachments.clear();
+		m_DepthAttachment = 0;
+
+		Stats::Add(s_FramebufferMemory, -(int64_t)m_MemorySize);
+		m_MemorySize = 0;
+	}
+
+	void Framebuffer::Target::attach() {
+		// Framebuffers aren't shared between contexts, the object is made by whoever draws
+		if (!RendererID)
+			glCreateFramebuffers(1, &RendererID);
+
+		// Attachments of the previous size stay attached otherwise
+		for (uint32_t i = 0; i < 8; i++)
+			glNamedFramebufferTexture(RendererID, GL_COLOR_ATTACHMENT0 + i, i < ColorAttachments.size() ? ColorAttachments[i] : 0, 0);
+		glNamedFramebufferTexture(RendererID, GL_DEPTH_STENCIL_ATTACHMENT, DepthAttachment, 0);
+
+		GLenum buffers[8];
+		for (uint32_t i = 0; i < ColorAttachments.size(); i++)
+			buffers[i] = GL_COLOR_ATTACHMENT0 + i;
+		if (ColorAttachments.empty())
+			glNamedFramebufferDrawBuffer(RendererID, GL_NONE);
+		else
+			glNamedFramebufferDrawBuffers(RendererID, (GLsizei)ColorAttachments.size(), buffers);
+
+		SHADO_CORE_ASSERT(glCheckNamedFramebufferStatus(RendererID, GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "Framebuffer is incomplete!");
+		AttachmentsChanged = false;
+	}
+
+	// =========================== FRAMEBUFFER POOL ===========================
+
+	Ref<Framebuffer> FramebufferPool::acquire(const FramebufferSpecification& specification) {
+		for (Entry& entry : m_Entries) {
+			if (entry.Target.use_count() == 1 && entry.Target->getSpecification() == specification) {
+				entry.LastAcquired = m_Frame;
+				return entry.Target;
+			}
+		}
+
+		m_Entries.push_back({ Framebuffer::create(specification), m_Frame });
+		return m_Entries.back().Target;
+	}
+
+	void FramebufferPool::endFrame(uint32_t maxIdleFrames) {
+		m_Frame++;
+
+		m_Entries.erase(std::remove_if(m_Entries.begin(), m_Entries.end(), [this, maxIdleFrames](const Entry& entry) {
+			return entry.Target.use_count() == 1 && m_Frame - entry.LastAcquired > maxIdleFrames;
+		}), m_Entries.end());
+	}
+
+	void FramebufferPool::clear() {
+		m_Entries.clear();
+	}
+}
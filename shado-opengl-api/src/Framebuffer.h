@@ -0,0 +1,133 @@
+#pragma once
+
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <cstdint>
+#include <vector>
+#include "util/Util.h"
+
+namespace Shado {
+
+	enum class FramebufferTextureFormat {
+		None = 0,
+
+		// Color
+		RGBA8,
+		RGBA16F,
+		RED_INTEGER,
+
+		// Depth/stencil
+		DEPTH24STENCIL8,
+
+		// Defaults
+		Depth = DEPTH24STENCIL8
+	};
+
+	struct FramebufferSpecification {
+		uint32_t Width = 0, Height = 0;
+		std::vector<FramebufferTextureFormat> Attachments = { FramebufferTextureFormat::RGBA8, FramebufferTextureFormat::Depth };
+		uint32_t Samples = 1;
+
+		bool operator==(const FramebufferSpecification& other) const {
+			return Width == other.Width && Height == other.Height && Attachments == other.Attachments && Samples == other.Samples;
+		}
+		bool operator!=(const FramebufferSpecification& other) const { return !(*this == other); }
+	};
+
+	/**
+	 * Offscreen render target. Color attachments are drawn in the order given by the specification,
+	 * at most one depth/stencil attachment.
+	 * With Samples > 1 the attachments are multisampled: they can't be sampled nor read back, blit them
+	 * into a single sampled framebuffer of the same size first.
+	 * A color attachment can be shown in ImGui as a texture:
+	 *     ImGui::Image((ImTextureID)(intptr_t)framebuffer->getColorAttachmentRendererID(), size, { 0, 1 }, { 1, 0 });
+	 */
+	class Framebuffer {
+	public:
+		Framebuffer(const FramebufferSpecification& specification);
+		Framebuffer(uint32_t width, uint32_t height);
+		~Framebuffer();
+
+		Framebuffer(const Framebuffer&) = delete;
+		Framebuffer& operator=(const Framebuffer&) = delete;
+
+		// Also sets the viewport to the framebuffer's size. Must be called from the thread drawing (see RenderCommandQueue)
+		void bind() const;
+		void unbind() const;
+
+		// Recreates the attachments, their content is lost
+		void resize(uint32_t width, uint32_t height);
+
+		// Copies the color attachment `attachmentIndex` (and depth/stencil if asked) into `target`, stretched to its size.
+		// Resolves multisampling, the sizes must then be the same. Thread: as bind()
+		void blit(const Framebuffer& target, uint32_t attachmentIndex = 0, bool depth = false, bool linearFilter = true) const;
+		// Same into the default framebuffer's back buffer
+		void blitToScreen(uint32_t width, uint32_t height, uint32_t attachmentIndex = 0, bool linearFilter = true) const;
+
+		// RGBA8 copy of an RGBA8 color attachment, rows bottom up. Not for multisampled framebuffers
+		void readPixels(std::vector<uint8_t>& pixels, uint32_t attachmentIndex = 0) const;
+		// Value of a RED_INTEGER attachment at (x, y), from the bottom left
+		int readPixel(uint32_t attachmentIndex, int x, int y) const;
+
+		const FramebufferSpecification& getSpecification() const { return m_Specification; }
+		uint32_t getWidth() const { return m_Specification.Width; }
+		uint32_t getHeight() const { return m_Specification.Height; }
+		uint32_t getRendererID() const { return m_Target->RendererID; }	// 0 until first bound
+		uint32_t getColorAttachmentRendererID(uint32_t index = 0) const { return m_ColorAttachments[index]; }
+		uint32_t getDepthAttachmentRendererID() const { return m_DepthAttachment; }
+
+		static Ref<Framebuffer> create(const FramebufferSpecification& specification);
+		static Ref<Framebuffer> create(uint32_t width, uint32_t height);
+
+	private:
+		// What the drawing thread sees. Resizing swaps the attachments in order with the recorded commands,
+		// the frames already recorded still draw into the old ones
+		struct Target {
+			uint32_t RendererID = 0;
+			uint32_t Width = 0, Height = 0;
+			std::vector<uint32_t> ColorAttachments;
+			uint32_t DepthAttachment = 0;
+			bool AttachmentsChanged = false;
+
+			void attach();
+		};
+
+		void invalidate();
+		void release();
+
+	private:
+		FramebufferSpecification m_Specification;
+		std::vector<uint32_t> m_ColorAttachments;
+		uint32_t m_DepthAttachment = 0;
+		uint64_t m_MemorySize = 0;		// Of the attachments, for Stats
+		Ref<Target> m_Target;
+	};
+
+	/**
+	 * Keeps framebuffers around to hand them out again instead of allocating transient render targets every frame.
+	 * A framebuffer is free again once the pool holds the only reference to it, commands recorded for the render
+	 * thread keep theirs until they ran
+	 */
+	class FramebufferPool {
+	public:
+		Ref<Framebuffer> acquire(const FramebufferSpecification& specification);
+
+		// Once per frame, frees the framebuffers that weren't acquired for maxIdleFrames frames
+		void endFrame(uint32_t maxIdleFrames = 60);
+		void clear();
+
+		size_t getSize() const { return m_Entries.size(); }
+
+	private:
+		struct Entry {
+			Ref<Framebuffer> Target;
+			uint64_t LastAcquired;
+		};
+
+		std::vector<Entry> m_Entries;
+		uint64_t m_Frame = 0;
+	};
+}
+
+#endif
@@ -0,0 +1,190 @@
+#include "GpuBufferArena.h"
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include "GL/glew.h"
+#include "Debug.h"
+
+namespace Shado {
+
+	// Index ranges are kept 4 bytes aligned so 16 and 32 bit meshes can share a page
+	static constexpr uint32_t INDEX_ALIGNMENT = 4;
+
+	GpuBufferArena::RangeAllocator::RangeAllocator(uint32_t capacity) {
+		m_FreeBlocks.push_back({ 0, capacity });
+	}
+
+	uint32_t GpuBufferArena::RangeAllocator::allocate(uint32_t size, uint32_t alignment) {
+		for (size_t i = 0; i < m_FreeBlocks.size(); i++) {
+			Block block = m_FreeBlocks[i];
+
+			uint32_t offset = (block.offset + alignment - 1) / alignment * alignment;
+			uint32_t padding = offset - block.offset;
+			if (block.size < padding + size)
+				continue;
+
+			// Give back what's left on both sides of the allocation
+			uint32_t remaining = block.size - padding - size;
+			if (padding > 0 && remaining > 0) {
+				m_FreeBlocks[i].size = padding;
+				m_FreeBlocks.insert(m_FreeBlocks.begin() + i + 1, { offset + size, remaining });
+			} else if (padding > 0) {
+				m_FreeBlocks[i].size = padding;
+			} else if (remaining > 0) {
+				m_FreeBlocks[i] = { offset + size, remaining };
+			} else {
+				m_FreeBlocks.erase(m_FreeBlocks.begin() + i);
+			}
+
+			return offset;
+		}
+
+		return Invalid;
+	}
+
+	void GpuBufferArena::RangeAllocator::free(uint32_t offset, uint32_t size) {
+		auto next = std::lower_bound(m_FreeBlocks.begin(), m_FreeBlocks.end(), offset,
+			[](const Block& block, uint32_t value) { return block.offset < value; });
+
+		bool mergeNext = next != m_FreeBlocks.end() && offset + size == next->offset;
+		bool mergePrevious = next != m_FreeBlocks.begin() && std::prev(next)->offset + std::prev(next)->size == offset;
+
+		if (mergePrevious && mergeNext) {
+			std::prev(next)->size += size + next->size;
+			m_FreeBlocks.erase(next);
+		} else if (mergePrevious) {
+			std::prev(next)->size += size;
+		} else if (mergeNext) {
+			next->offset = offset;
+			next->size += size;
+		} else {
+			m_FreeBlocks.insert(next, { offset, size });
+		}
+	}
+
+	// ========================================
+	GpuBufferArena::GpuBufferArena(const BufferLayout& layout, uint32_t pageVertexCount, uint32_t pageIndexCount)
+		: m_Layout(layout), m_PageVertexCount(pageVertexCount), m_PageIndexBytes(pageIndexCount * sizeof(uint32_t))
+	{
+		SHADO_CORE_ASSERT(layout.getStride() > 0, "Arena layout is empty!");
+	}
+
+	Ref<GpuMesh> GpuBufferArena::allocate(const void* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount) {
+		SHADO_CORE_ASSERT(vertexCount > 0 && indexCount > 0, "Can't allocate an empty mesh!");
+
+		// Store the indices as 16 bits when they fit
+		std::vector<uint16_t> narrowed = IndexBuffer::narrow(indices, indexCount);
+		bool is16Bits = !narrowed.empty();
+		uint32_t indexBytes = indexCount * (is16Bits ? sizeof(uint16_t) : sizeof(uint32_t));
+		uint32_t allocatedIndexBytes = (indexBytes + INDEX_ALIGNMENT - 1) / INDEX_ALIGNMENT * INDEX_ALIGNMENT;
+
+		Page* page = nullptr;
+		uint32_t pageIndex = 0;
+		uint32_t baseVertex = RangeAllocator::Invalid;
+		uint32_t indexOffset = RangeAllocator::Invalid;
+
+		for (; pageIndex < m_Pages.size(); pageIndex++) {
+			Page& candidate = *m_Pages[pageIndex];
+
+			baseVertex = candidate.vertices.allocate(vertexCount);
+			if (baseVertex == RangeAllocator::Invalid)
+				continue;
+
+			indexOffset = candidate.indices.allocate(allocatedIndexBytes, INDEX_ALIGNMENT);
+			if (indexOffset == RangeAllocator::Invalid) {
+				candidate.vertices.free(baseVertex, vertexCount);
+				continue;
+			}
+
+			page = &candidate;
+			break;
+		}
+
+		if (!page) {
+			// Meshes bigger than a page get a page of their own
+			page = &createPage(std::max(m_PageVertexCount, vertexCount), std::max(m_PageIndexBytes, allocatedIndexBytes));
+			pageIndex = (uint32_t)m_Pages.size() - 1;
+
+			baseVertex = page->vertices.allocate(vertexCount);
+			indexOffset = page->indices.allocate(allocatedIndexBytes, INDEX_ALIGNMENT);
+		}
+
+		const uint32_t stride = m_Layout.getStride();
+
+		Ref<GpuMesh> mesh(new GpuMesh());
+		mesh->m_Arena = shared_from_this();
+		mesh->m_Page = pageIndex;
+		mesh->m_VertexArray = page->vertexArray;
+		mesh->m_VertexBuffer = VertexBuffer::createView(page->vertexBuffer, baseVertex * stride, vertexCount * stride);
+		mesh->m_IndexBuffer = IndexBuffer::createView(page->indexBuffer, indexOffset, indexCount, is16Bits ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT);
+		mesh->m_BaseVertex = baseVertex;
+		mesh->m_VertexCount = vertexCount;
+		mesh->m_IndexOffset = indexOffset;
+		mesh->m_IndexBytes = allocatedIndexBytes;
+
+		mesh->m_VertexBuffer->setData(vertices, (size_t)vertexCount * stride);
+		mesh->m_IndexBuffer->setData(is16Bits ? (const void*)narrowed.data() : (const void*)indices, indexBytes);
+
+		m_Stats.MeshCount++;
+		m_Stats.UsedVertexBytes += (uint64_t)vertexCount * stride;
+		m_Stats.UsedIndexBytes += allocatedIndexBytes;
+
+		return mesh;
+	}
+
+	GpuBufferArena::Page& GpuBufferArena::createPage(uint32_t vertexCount, uint32_t indexBytes) {
+		const uint32_t vertexBytes = vertexCount * m_Layout.getStride();
+
+		auto vertexBuffer = VertexBuffer::create(vertexBytes);
+		vertexBuffer->setLayout(m_Layout);
+
+		auto indexBuffer = CreateRef<IndexBuffer>(indexBytes);
+
+		auto vertexArray = VertexArray::create();
+		vertexArray->addVertexBuffer(vertexBuffer);
+		vertexArray->setIndexBuffer(indexBuffer);
+
+		m_Pages.push_back(std::unique_ptr<Page>(new Page{
+			vertexArray, vertexBuffer, indexBuffer,
+			RangeAllocator(vertexCount), RangeAllocator(indexBytes)
+		}));
+
+		m_Stats.ReservedBytes += (uint64_t)vertexBytes + indexBytes;
+
+		SHADO_CORE_INFO("GPU arena page created ({0} KB)", (vertexBytes + indexBytes) / 1024);
+		return *m_Pages.back();
+	}
+
+	void GpuBufferArena::free(const GpuMesh& mesh) {
+		Page& page = *m_Pages[mesh.m_Page];
+		page.vertices.free(mesh.m_BaseVertex, mesh.m_VertexCount);
+		page.indices.free(mesh.m_IndexOffset, mesh.m_IndexBytes);
+
+		m_Stats.MeshCount--;
+		m_Stats.UsedVertexBytes -= (uint64_t)mesh.m_VertexCount * m_Layout.getStride();
+		m_Stats.UsedIndexBytes -= mesh.m_IndexBytes;
+	}
+
+	Ref<GpuBufferArena> GpuBufferArena::get(const BufferLayout& layout) {
+		static std::unordered_map<std::string, std::weak_ptr<GpuBufferArena>> s_Arenas;
+
+		// Attribute names don't matter to the VAO, only the types and the order do
+		std::string key;
+		for (const auto& element : layout)
+			key += std::to_string((int)element.Type) + (element.Normalized ? "n;" : ";");
+
+		if (auto arena = s_Arenas[key].lock())
+			return arena;
+
+		auto arena = CreateRef<GpuBufferArena>(layout);
+		s_Arenas[key] = arena;
+		return arena;
+	}
+
+	// ========================================
+	GpuMesh::~GpuMesh() {
+		if (m_Arena)
+			m_Arena->free(*this);
+	}
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#ifndef GPU_BUFFER_ARENA_H
+#define GPU_BUFFER_ARENA_H
+
+#include <memory>
+#include <vector>
+#include "VertexArray.h"
+#include "util/Util.h"
+
+namespace Shado {
+
+	class GpuMesh;
+
+	/**
+	 * Sub-allocates meshes sharing the same vertex layout from a few big vertex/index buffers ("pages")
+	 * instead of creating a VBO, an EBO and a VAO per mesh.
+	 *
+	 * Every page has a single VAO, meshes are drawn with glDrawElementsBaseVertex using the offsets
+	 * of their GpuMesh. Ranges are handed out by a first fit free list and given back when the
+	 * GpuMesh is destroyed.
+	 */
+	class GpuBufferArena : public std::enable_shared_from_this<GpuBufferArena> {
+	public:
+		GpuBufferArena(const BufferLayout& layout, uint32_t pageVertexCount = 1 << 18, uint32_t pageIndexCount = 1 << 20);
+		~GpuBufferArena() = default;
+
+		// `vertices` holds vertexCount vertices matching the arena's layout. Indices are relative to the mesh
+		Ref<GpuMesh> allocate(const void* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount);
+
+		const BufferLayout& getLayout() const { return m_Layout; }
+		uint32_t getPageCount() const { return (uint32_t)m_Pages.size(); }
+
+		struct Statistics {
+			uint32_t MeshCount = 0;
+			uint64_t UsedVertexBytes = 0;
+			uint64_t UsedIndexBytes = 0;
+			uint64_t ReservedBytes = 0;
+		};
+		const Statistics& getStats() const { return m_Stats; }
+
+		// Arena shared by every mesh using this layout. It lives as long as one of its meshes does
+		static Ref<GpuBufferArena> get(const BufferLayout& layout);
+
+	private:
+		// First fit allocator over [0, capacity), free blocks are merged with their neighbours
+		class RangeAllocator {
+		public:
+			static constexpr uint32_t Invalid = 0xFFFFFFFF;
+
+			RangeAllocator(uint32_t capacity);
+
+			uint32_t allocate(uint32_t size, uint32_t alignment = 1);
+			void free(uint32_t offset, uint32_t size);
+
+		private:
+			struct Block {
+				uint32_t offset, size;
+			};
+			std::vector<Block> m_FreeBlocks;		// Sorted by offset
+		};
+
+		struct Page {
+			Ref<VertexArray> vertexArray;
+			Ref<VertexBuffer> vertexBuffer;
+			Ref<IndexBuffer> indexBuffer;
+			RangeAllocator vertices;	// In vertices
+			RangeAllocator indices;		// In bytes
+		};
+
+		Page& createPage(uint32_t vertexCount, uint32_t indexBytes);
+		void free(const GpuMesh& mesh);
+
+		friend class GpuMesh;
+
+	private:
+		BufferLayout m_Layout;
+		uint32_t m_PageVertexCount;
+		uint32_t m_PageIndexBytes;
+
+		std::vector<std::unique_ptr<Page>> m_Pages;
+		Statistics m_Stats;
+	};
+
+	// Range of a GpuBufferArena page holding one mesh. The range is released on destruction
+	class GpuMesh {
+	public:
+		~GpuMesh();
+
+		GpuMesh(const GpuMesh&) = delete;
+		GpuMesh& operator=(const GpuMesh&) = delete;
+
+		// VAO of the page, shared with the other meshes of the page
+		const Ref<VertexArray>& getVertexArray()	const { return m_VertexArray; }
+		const Ref<VertexBuffer>& getVertexBuffer()	const { return m_VertexBuffer; }
+		const Ref<IndexBuffer>& getIndexBuffer()	const { return m_IndexBuffer; }
+
+		uint32_t getBaseVertex()	const { return m_BaseVertex; }
+		uint32_t getVertexCount()	const { return m_VertexCount; }
+		uint32_t getIndexCount()	const { return m_IndexBuffer->getCount(); }
+
+	private:
+		GpuMesh() = default;
+
+		friend class GpuBufferArena;
+
+	private:
+		Ref<GpuBufferArena> m_Arena;
+		uint32_t m_Page = 0;
+
+		Ref<VertexArray> m_VertexArray;
+		Ref<VertexBuffer> m_VertexBuffer;
+		Ref<IndexBuffer> m_IndexBuffer;
+
+		uint32_t m_BaseVertex = 0;
+		uint32_t m_VertexCount = 0;
+		uint32_t m_IndexOffset = 0;		// In bytes, within the page
+		uint32_t m_IndexBytes = 0;
+	};
+}
+
+#endif
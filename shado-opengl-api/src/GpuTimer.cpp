@@ -0,0 +1,86 @@
+#include "GpuTimer.h"
+
+#include "GL/glew.h"
+#include "Profiler.h"
+#include "RenderCommandQueue.h"
+
+namespace Shado {
+
+	GpuTimer::GpuTimer(const char* name)
+		: m_Name(name)
+	{
+	}
+
+	GpuTimer::~GpuTimer() {
+		release();
+	}
+
+	void GpuTimer::release() {
+		if (!m_Queries[0])
+			return;
+
+		RenderCommandQueue::Submit([queries = m_Queries]() {
+			glDeleteQueries(Latency, queries.data());
+		});
+
+		m_Queries = {};
+		for (bool& pending : m_Pending)
+			pending = false;
+		m_Next = 0;
+		m_Running = false;
+	}
+
+	void GpuTimer::begin() {
+		// Query objects aren't shared between contexts, made by whoever draws
+		if (!m_Queries[0])
+			glCreateQueries(GL_TIME_ELAPSED, Latency, m_Queries.data());
+
+		collect();
+
+#if SHADO_PROFILE
+		if (m_Name)
+			Profiler::BeginGpuScope(m_Name);
+#endif
+
+		// The GPU is too far behind, skip this measurement rather than wait
+		if (m_Pending[m_Next])
+			return;
+
+		glBeginQuery(GL_TIME_ELAPSED, m_Queries[m_Next]);
+		m_Running = true;
+	}
+
+	void GpuTimer::end() {
+#if SHADO_PROFILE
+		if (m_Name)
+			Profiler::EndGpuScope();
+#endif
+
+		if (!m_Running)
+			return;
+
+		glEndQuery(GL_TIME_ELAPSED);
+		m_Pending[m_Next] = true;
+		m_Next = (m_Next + 1) % Latency;
+		m_Running = false;
+	}
+
+	void GpuTimer::collect() {
+		// Oldest first, they complete in order
+		for (uint32_t i = 0; i < Latency; i++) {
+			const uint32_t index = (m_Next + i) % Latency;
+			if (!m_Pending[index])
+				continue;
+
+			GLint available = GL_FALSE;
+			glGetQueryObjectiv(m_Queries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+				break;
+
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(m_Queries[index], GL_QUERY_RESULT, &elapsed);
+			m_Time.store((float)(elapsed / 1e6), std::memory_order_relaxed);
+			m_Pending[index] = false;
+		}
+	}
+}
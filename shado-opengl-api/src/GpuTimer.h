@@ -0,0 +1,51 @@
+#pragma once
+
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace Shado {
+
+	/**
+	 * Measures the GPU time of the commands between begin() and end() with GL_TIME_ELAPSED queries.
+	 * Results come a few frames late: they are only read once available, the timer never waits on the GPU.
+	 * Queries can't nest, only one timer may be running at a time.
+	 * begin()/end() go on the thread drawing (see RenderCommandQueue), getTime() can be called from anywhere
+	 */
+	class GpuTimer {
+	public:
+		static constexpr uint32_t Latency = 4;	// Queries in flight
+
+		// With a name, the pass also shows on the profiler's GPU track (see SHADO_PROFILE_GPU_SCOPE)
+		GpuTimer(const char* name = nullptr);
+		~GpuTimer();
+
+		GpuTimer(const GpuTimer&) = delete;
+		GpuTimer& operator=(const GpuTimer&) = delete;
+
+		void begin();
+		void end();
+		// Deletes the queries now rather than at destruction, they are made again on the next begin()
+		void release();
+
+		// Last measurement, in ms
+		float getTime() const { return m_Time.load(std::memory_order_relaxed); }
+
+	private:
+		void collect();
+
+	private:
+		const char* m_Name;
+		std::array<uint32_t, Latency> m_Queries = {};
+		bool m_Pending[Latency] = {};
+		uint32_t m_Next = 0;
+		bool m_Running = false;
+
+		std::atomic<float> m_Time = 0.0f;
+	};
+}
+
+#endif
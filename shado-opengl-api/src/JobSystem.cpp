@@ -0,0 +1,227 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include "Debug.h"
+#include "Profiler.h"
+
+namespace Shado {
+
+	struct JobQueue {
+		std::mutex Mutex;
+		std::deque<std::pair<Job, JobCounter*>> Jobs;
+	};
+
+	struct JobSystemData {
+		// [0] is shared by the threads that aren't workers, [i + 1] belongs to worker i
+		std::vector<std::unique_ptr<JobQueue>> Queues;
+		std::vector<std::thread> Workers;
+		bool Initialized = false;
+
+		std::atomic<uint32_t> Queued = 0;		// In any deque
+		std::atomic<uint32_t> Sleeping = 0;
+		std::atomic<bool> Running = false;
+		std::mutex SleepMutex;
+		std::condition_variable Wake;
+	};
+
+	static JobSystemData s_Jobs;
+	static thread_local uint32_t s_QueueIndex = 0;
+
+	void JobSystem::Init(uint32_t workerCount) {
+		SHADO_CORE_ASSERT(!s_Jobs.Initialized, "Job system is already running!");
+
+		if (workerCount == 0)
+			workerCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+		for (uint32_t i = 0; i < workerCount + 1; i++)
+			s_Jobs.Queues.push_back(std::make_unique<JobQueue>());
+
+		s_Jobs.Running = true;
+		s_Jobs.Initialized = true;
+		for (uint32_t i = 0; i < workerCount; i++)
+			s_Jobs.Workers.emplace_back(WorkerMain, i);
+	}
+
+	void JobSystem::Shutdown() {
+		if (!s_Jobs.Initialized)
+			return;
+
+		while (RunOne()) {}
+
+		{
+			std::lock_guard<std::mutex> lock(s_Jobs.SleepMutex);
+			s_Jobs.Running = false;
+		}
+		s_Jobs.Wake.notify_all();
+		for (std::thread& worker : s_Jobs.Workers)
+			worker.join();
+
+		// A worker may have queued more before it stopped
+		while (RunOne()) {}
+
+		s_Jobs.Workers.clear();
+		s_Jobs.Queues.clear();
+		s_Jobs.Initialized = false;
+	}
+
+	bool JobSystem::IsInitialized() {
+		return s_Jobs.Initialized;
+	}
+
+	uint32_t JobSystem::GetThreadCount() {
+		return (uint32_t)s_Jobs.Workers.size() + 1;
+	}
+
+	void JobSystem::Run(Job job, JobCounter* counter) {
+		if (counter)
+			counter->m_Pending.fetch_add(1, std::memory_order_relaxed);
+
+		Submit(std::move(job), counter);
+	}
+
+	void JobSystem::Run(Job job, JobCounter* counter, JobCounter& dependency) {
+		SHADO_CORE_ASSERT(counter != &dependency, "A job can't wait on its own counter");
+
+		if (counter)
+			counter->m_Pending.fetch_add(1, std::memory_order_relaxed);
+
+		{
+			// Finish empties the list under the same lock once the count reaches 0
+			std::lock_guard<std::mutex> lock(dependency.m_Mutex);
+			if (dependency.m_Pending.load(std::memory_order_acquire) != 0) {
+				dependency.m_Waiting.emplace_back(std::move(job), counter);
+				return;
+			}
+		}
+
+		Submit(std::move(job), counter);
+	}
+
+	void JobSystem::Wait(JobCounter& counter) {
+		while (!counter.isDone()) {
+			if (!RunOne())
+				std::this_thread::yield();
+		}
+
+		// The last job may still be in Finish, holding the lock. The counter can't go away before it's out
+		std::lock_guard<std::mutex> lock(counter.m_Mutex);
+	}
+
+	void JobSystem::ParallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t, uint32_t)>& function) {
+		if (count == 0)
+			return;
+
+		batchSize = std::max(1u, batchSize);
+		const uint32_t batches = (count + batchSize - 1) / batchSize;
+		if (batches == 1 || s_Jobs.Workers.empty()) {
+			function(0, count);
+			return;
+		}
+
+		JobCounter counter;
+		for (uint32_t batch = 1; batch < batches; batch++) {
+			const uint32_t begin = batch * batchSize;
+			const uint32_t end = std::min(begin + batchSize, count);
+			Run([&function, begin, end]() { function(begin, end); }, &counter);
+		}
+
+		function(0, std::min(batchSize, count));
+		Wait(counter);
+	}
+
+	void JobSystem::Submit(Job job, JobCounter* counter) {
+		if (s_Jobs.Workers.empty()) {
+			job();
+			Finish(counter);
+			return;
+		}
+
+		JobQueue& queue = *s_Jobs.Queues[s_QueueIndex];
+		{
+			std::lock_guard<std::mutex> lock(queue.Mutex);
+			queue.Jobs.emplace_back(std::move(job), counter);
+		}
+
+		// Pairs with the worker raising Sleeping before it checks Queued, one of the two sees the other
+		s_Jobs.Queued.fetch_add(1);
+		if (s_Jobs.Sleeping.load() > 0) {
+			{ std::lock_guard<std::mutex> lock(s_Jobs.SleepMutex); }
+			s_Jobs.Wake.notify_one();
+		}
+	}
+
+	void JobSystem::Finish(JobCounter* counter) {
+		if (!counter)
+			return;
+
+		std::vector<std::pair<Job, JobCounter*>> ready;
+		{
+			std::lock_guard<std::mutex> lock(counter->m_Mutex);
+			if (counter->m_Pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				ready.swap(counter->m_Waiting);
+		}
+
+		for (auto& [job, jobCounter] : ready)
+			Submit(std::move(job), jobCounter);
+	}
+
+	bool JobSystem::RunOne() {
+		if (s_Jobs.Queues.empty())
+			return false;
+
+		std::pair<Job, JobCounter*> job;
+		bool found = false;
+
+		// Own deque from the back first, then steal from the front of the others
+		const uint32_t queueCount = (uint32_t)s_Jobs.Queues.size();
+		for (uint32_t i = 0; i < queueCount && !found; i++) {
+			JobQueue& queue = *s_Jobs.Queues[(s_QueueIndex + i) % queueCount];
+			std::lock_guard<std::mutex> lock(queue.Mutex);
+			if (queue.Jobs.empty())
+				continue;
+
+			if (i == 0) {
+				job = std::move(queue.Jobs.back());
+				queue.Jobs.pop_back();
+			} else {
+				job = std::move(queue.Jobs.front());
+				queue.Jobs.pop_front();
+			}
+			found = true;
+		}
+
+		if (!found)
+			return false;
+
+		s_Jobs.Queued.fetch_sub(1, std::memory_order_relaxed);
+		{
+			SHADO_PROFILE_SCOPE("Job");
+			job.first();
+		}
+		Finish(job.second);
+		return true;
+	}
+
+	void JobSystem::WorkerMain(uint32_t index) {
+		s_QueueIndex = index + 1;
+		SHADO_PROFILE_THREAD("Worker " + std::to_string(index));
+
+		while (true) {
+			if (RunOne())
+				continue;
+
+			std::unique_lock<std::mutex> lock(s_Jobs.SleepMutex);
+			s_Jobs.Sleeping.fetch_add(1);
+			s_Jobs.Wake.wait(lock, []() { return s_Jobs.Queued.load() > 0 || !s_Jobs.Running; });
+			s_Jobs.Sleeping.fetch_sub(1);
+
+			if (!s_Jobs.Running)
+				return;
+		}
+	}
+}
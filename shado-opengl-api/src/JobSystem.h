@@ -0,0 +1,80 @@
+#pragma once
+
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Shado {
+
+	using Job = std::function<void()>;
+
+	/**
+	 * Counts the jobs started with it that haven't finished. Jobs can be made to wait on a counter,
+	 * they are queued once it gets back to 0.
+	 * A counter must outlive its jobs, wait on it before it goes out of scope.
+	 */
+	class JobCounter {
+	public:
+		JobCounter() = default;
+		JobCounter(const JobCounter&) = delete;
+		JobCounter& operator=(const JobCounter&) = delete;
+
+		bool isDone() const { return m_Pending.load(std::memory_order_acquire) == 0; }
+
+	private:
+		std::atomic<uint32_t> m_Pending = 0;
+		std::mutex m_Mutex;					// Guards the decrement to 0 and m_Waiting
+		std::vector<std::pair<Job, JobCounter*>> m_Waiting;
+
+		friend class JobSystem;
+	};
+
+	/**
+	 * Worker threads, one per hardware thread minus the main one, each with its own deque of jobs.
+	 * A worker pushes and pops the back of its deque (the jobs it just made are warm in cache) and
+	 * steals from the front of the others' when it runs out. Threads that aren't workers push to a
+	 * shared deque.
+	 *
+	 * Waiting on a counter runs jobs meanwhile instead of blocking, so jobs can start and wait for
+	 * other jobs (nested ParallelFor) without starving the pool.
+	 *
+	 * Without Init, or with no worker, everything runs right away on the calling thread.
+	 */
+	class JobSystem {
+	public:
+		// 0 = one worker per hardware thread, minus the calling thread
+		static void Init(uint32_t workerCount = 0);
+		// Runs the jobs left before joining the workers
+		static void Shutdown();
+
+		static bool IsInitialized();
+		// Workers plus the calling thread, which helps while waiting
+		static uint32_t GetThreadCount();
+
+		static void Run(Job job, JobCounter* counter = nullptr);
+		// Queued once `dependency` is done
+		static void Run(Job job, JobCounter* counter, JobCounter& dependency);
+
+		static void Wait(JobCounter& counter);
+
+		/**
+		 * Calls function(begin, end) over [0, count) cut in batches of batchSize, returns once all are done.
+		 * The calling thread takes part. A single batch runs inline.
+		 */
+		static void ParallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t, uint32_t)>& function);
+
+	private:
+		static void Submit(Job job, JobCounter* counter);
+		static void Finish(JobCounter* counter);
+		static bool RunOne();
+		static void WorkerMain(uint32_t index);
+	};
+}
+
+#endif
@@ -1,7 +1,15 @@
 ﻿#include "Layer.h"
 
 #include "Debug.h"
+#include "Profiler.h"
+#include "Renderer2D.h"
+#include "WorldPartition.h"
+#include "box2d/b2_fixture.h"
+#include "box2d/b2_polygon_shape.h"
+#include <glm/gtc/packing.hpp>
 #include <algorithm>
+#include <atomic>
+#include <cmath>
 
 namespace Shado {
 
@@ -17,75 +25,541 @@ namespace Shado {
 	}
 
 	Scene::~Scene() {
+		// Its workers may still be loading cells
+		worldPartition = nullptr;
+
+		// The job steps this world
+		waitForPhysics();
+
 		/*for (Layer* layer : m_Layers) {
 			delete layer;
 		}*/
 	}
 
 	void Scene::updatePhysics(TimeStep dt) {
-		world.Step(dt, 6, 2);
+		SHADO_PROFILE_FUNCTION();
+		waitForPhysics();
+		stepWorld(1, dt);
+		publishSnapshots(1);
+		syncTransforms(dt);
+	}
+
+	void Scene::setAsyncPhysics(bool async) {
+		waitForPhysics();
+		asyncPhysics = async;
+	}
+
+	void Scene::setPhysicsIterations(uint32_t velocityIterations, uint32_t positionIterations) {
+		waitForPhysics();
+		this->velocityIterations = velocityIterations;
+		this->positionIterations = positionIterations;
+	}
+
+	void Scene::beginPhysics(uint32_t steps, TimeStep dt) {
+		SHADO_CORE_ASSERT(!physicsPending, "The previous steps weren't collected!");
+
+		physicsPending = true;
+		physicsStep = dt;
+		physicsSteps = steps;
+		JobSystem::Run([this, steps, dt]() {
+			SHADO_PROFILE_SCOPE("Scene::stepPhysics");
+			stepWorld(steps, dt);
+		}, &physicsJob);
+	}
+
+	void Scene::stepWorld(uint32_t steps, TimeStep dt) {
+		for (uint32_t step = 0; step < steps; step++) {
+			world.Step(dt, velocityIterations, positionIterations);
+
+			// Only the two last steps are kept
+			if (step + 2 < steps)
+				continue;
+
+			// Static bodies only move when teleported, which resets every snapshot
+			std::vector<BodyPose>& poses = snapshots[step + 1 == steps ? nextCurrentSnapshot : nextPreviousSnapshot];
+			for (const MovingBody& moving : movingBodies) {
+				const b2Vec2& position = moving.body->GetPosition();
+				poses[moving.entity] = { position.x, position.y, moving.body->GetAngle() };
+			}
+		}
+	}
+
+	void Scene::publishSnapshots(uint32_t steps) {
+		// With a single step, the current snapshot becomes the previous one
+		const uint32_t previous = steps >= 2 ? nextPreviousSnapshot : currentSnapshot;
+		const uint32_t current = nextCurrentSnapshot;
+
+		uint32_t spare[2], count = 0;
+		for (uint32_t i = 0; i < 4; i++) {
+			if (i != previous && i != current)
+				spare[count++] = i;
+		}
+
+		previousSnapshot = previous;
+		currentSnapshot = current;
+		nextPreviousSnapshot = spare[0];
+		nextCurrentSnapshot = spare[1];
+	}
+
+	void Scene::resetSnapshots(EntityHandle entity) {
+		const Transform& transform = registry.get<Transform>(entity);
+		for (std::vector<BodyPose>& poses : snapshots) {
+			if (entity.Index >= poses.size())
+				poses.resize((size_t)entity.Index + 1);
+			poses[entity.Index] = { transform.position.x, transform.position.y, transform.rotation };
+		}
+	}
+
+	void Scene::waitForPhysics() {
+		if (!physicsPending)
+			return;
+
+		SHADO_PROFILE_FUNCTION();
+		JobSystem::Wait(physicsJob);
+		physicsPending = false;
+		publishSnapshots(physicsSteps);
+		syncTransforms(physicsStep);
+	}
+
+	// The scene's BVH is 2D, every proxy lives on the z = 0 plane
+	static AABB toSpatialBounds(const Transform& transform) {
+		AABB bounds = transform.getBounds();
+		bounds.min.z = 0.0f;
+		bounds.max.z = 0.0f;
+		return bounds;
+	}
+
+	// Proxies keep the index of their entity, the handle is rebuilt from the registry
+	static void* toUserData(EntityHandle handle) {
+		return (void*)(uintptr_t)handle.Index;
+	}
+
+	static uint32_t toEntityIndex(void* userData) {
+		return (uint32_t)(uintptr_t)userData;
 	}
 
+	void Scene::syncTransforms(TimeStep dt) {
+		// Static bodies aren't in the list, they only move when teleported (see onTeleported)
+		for (const MovingBody& moving : movingBodies) {
+			// Sleeping bodies don't move either
+			b2Body* body = moving.body;
+			const bool resting = !body->IsAwake();
+			const EntityHandle entity = registry.getHandle(moving.entity);
+			RigidBody& rigidBody = registry.get<RigidBody>(entity);
+			if (resting && rigidBody.resting)
+				continue;
+
+			Transform& transform = registry.get<Transform>(entity);
+			const b2Vec2& position = body->GetPosition();
+			transform.position.x = position.x;
+			transform.position.y = position.y;
+			transform.rotation = body->GetAngle();
+
+			if (resting != rigidBody.resting) {
+				setResting(entity, resting);
+			} else {
+				const b2Vec2& velocity = body->GetLinearVelocity();
+				spatialIndex.moveProxy(rigidBody.proxyId, toSpatialBounds(transform), { velocity.x * dt, velocity.y * dt, 0.0f });
+			}
+		}
+	}
+
+	void Scene::addMovingBody(EntityHandle entity) {
+		RigidBody& rigidBody = registry.get<RigidBody>(entity);
+		rigidBody.movingSlot = (uint32_t)movingBodies.size();
+		movingBodies.push_back({ entity.Index, rigidBody.body });
+	}
+
+	void Scene::removeMovingBody(EntityHandle entity) {
+		RigidBody& rigidBody = registry.get<RigidBody>(entity);
+		if (rigidBody.movingSlot == RigidBody::NotMoving)
+			return;
+
+		// Swap with the last one and pop
+		const MovingBody last = movingBodies.back();
+		movingBodies[rigidBody.movingSlot] = last;
+		registry.get<RigidBody>(registry.getHandle(last.entity)).movingSlot = rigidBody.movingSlot;
+		movingBodies.pop_back();
+		rigidBody.movingSlot = RigidBody::NotMoving;
+	}
+
+	void Scene::setBodyType(EntityHandle entity, EntityType type) {
+		waitForPhysics();
+
+		RigidBody& rigidBody = registry.get<RigidBody>(entity);
+		rigidBody.body->SetType((b2BodyType)type);
+
+		// Box2D wakes a body leaving static, syncTransforms takes it out of the resting index then
+		if (type != EntityType::STATIC) {
+			if (rigidBody.movingSlot == RigidBody::NotMoving)
+				addMovingBody(entity);
+		} else {
+			removeMovingBody(entity);
+			if (!rigidBody.resting)
+				setResting(entity, true);
+		}
+
+		resetSnapshots(entity);
+	}
+
+	void Scene::onTeleported(EntityHandle entity) {
+		const RigidBody& rigidBody = registry.get<RigidBody>(entity);
+		const Transform& transform = registry.get<Transform>(entity);
+		(rigidBody.resting ? restingIndex : spatialIndex).moveProxy(rigidBody.proxyId, toSpatialBounds(transform));
+
+		resetSnapshots(entity);
+		refreshQuad(entity);
+	}
+
+	void Scene::setResting(EntityHandle entity, bool resting) {
+		RigidBody& rigidBody = registry.get<RigidBody>(entity);
+		const Transform& transform = registry.get<Transform>(entity);
+		Sprite& sprite = registry.get<Sprite>(entity);
+
+		DynamicBVH& from = rigidBody.resting ? restingIndex : spatialIndex;
+		DynamicBVH& to = resting ? restingIndex : spatialIndex;
+		if (rigidBody.proxyId != DynamicBVH::NullNode)
+			from.destroyProxy(rigidBody.proxyId);
+		rigidBody.proxyId = to.createProxy(toSpatialBounds(transform), toUserData(entity));
+		rigidBody.resting = resting;
+
+		if (resting) {
+			refreshQuad(entity);
+		} else if (sprite.cachedQuad != QuadCache::None) {
+			restingQuads.remove(sprite.cachedQuad);
+			sprite.cachedQuad = QuadCache::None;
+		}
+	}
+
+	void Scene::refreshQuad(EntityHandle entity) {
+		if (!registry.get<RigidBody>(entity).resting)
+			return;
+
+		const Transform& transform = registry.get<Transform>(entity);
+		Sprite& sprite = registry.get<Sprite>(entity);
+
+		// Same as drawEntities, a texture isn't tinted
+		const glm::vec4 color = sprite.texture ? glm::vec4(1.0f) : (glm::vec4)sprite.color;
+		const float tilingFactor = sprite.texture ? (float)sprite.tilingfactor : 1.0f;
+
+		if (sprite.cachedQuad == QuadCache::None)
+			sprite.cachedQuad = restingQuads.add(transform.position, transform.scale, transform.rotation, sprite.texture, tilingFactor, color);
+		else
+			sprite.cachedQuad = restingQuads.update(sprite.cachedQuad, transform.position, transform.scale, transform.rotation, sprite.texture, tilingFactor, color);
+	}
+
+	// Shared by all the scenes, an id is never given twice
+	static std::atomic<uint64_t> s_NextEntityId = 1;
+
 	/*void Scene::pushLayer(Layer* layer) {
 		layer->m_Scene = this;
 		m_Layers.push_back(layer);
 	}*/
 
-	Entity* Scene::addEntityToWorld(Entity* entity) {
-		entities.push_back(entity);
-		return entity;
+	Entity Scene::addEntityToWorld(const EntityDefinition& def) {
+		waitForPhysics();
+
+		EntityHandle entity = registry.create();
+		EntityInfo& info = registry.emplace<EntityInfo>(entity);
+		info.id = s_NextEntityId++;
+		entitiesById[info.id] = entity.Index;
+		setEntityName(entity, def.name);
+		const Transform& transform = registry.emplace<Transform>(entity, def.position, def.rotation, def.scale);
+		registry.emplace<Sprite>(entity, def.texture, def.tillingfactor, def.color);
+
+		// Create box2D body
+		b2BodyDef bodyDef;
+		bodyDef.type = (b2BodyType)def.type;
+		bodyDef.position.Set(def.position.x, def.position.y);
+		bodyDef.angle = def.rotation;
+
+		b2PolygonShape dynamicBox;
+		dynamicBox.SetAsBox(def.scale.x / 2.0f, def.scale.y / 2.0f);
+
+		b2FixtureDef fixtureDef;
+		fixtureDef.shape = &dynamicBox;
+		fixtureDef.density = def.density;
+		fixtureDef.friction = def.friction;
+
+		b2Body* body = world.CreateBody(&bodyDef);
+		body->CreateFixture(&fixtureDef);
+
+		RigidBody& rigidBody = registry.emplace<RigidBody>(entity, body);
+		if (bodyDef.type == b2_staticBody) {
+			setResting(entity, true);
+		} else {
+			rigidBody.proxyId = spatialIndex.createProxy(toSpatialBounds(transform), toUserData(entity));
+			addMovingBody(entity);
+		}
+		resetSnapshots(entity);
+
+		return { entity, this };
+	}
+
+	WorldPartition& Scene::enableWorldPartition(const std::string& directory, float cellSize) {
+		worldPartition = nullptr;
+		worldPartition = std::make_unique<WorldPartition>(*this, directory, cellSize);
+		return *worldPartition;
 	}
 
-	Entity* Scene::addEntityToWorld(const EntityDefinition& def) {
-		auto* temp = new Entity(def, world);
-		entities.push_back(temp);
-		return temp;
+	void Scene::disableWorldPartition() {
+		worldPartition = nullptr;
 	}
 
 	void Scene::setWorldGravity(const glm::vec2& gravity) {
+		waitForPhysics();
 		world.SetGravity({ gravity.x, gravity.y });
 	}
 
-	void Scene::destroyEntity(Entity* entity) {
-		if (entity != nullptr) {
-			entity->destroy();
+	void Scene::destroyEntity(Entity entity) {
+		if (entity.getScene() != this || !entity.isValid())
+			return;
+
+		waitForPhysics();
+
+		removeMovingBody(entity.getHandle());
+		RigidBody& rigidBody = registry.get<RigidBody>(entity.getHandle());
+		if (rigidBody.proxyId != DynamicBVH::NullNode)
+			(rigidBody.resting ? restingIndex : spatialIndex).destroyProxy(rigidBody.proxyId);
+		world.DestroyBody(rigidBody.body);
+
+		const Sprite& sprite = registry.get<Sprite>(entity.getHandle());
+		if (sprite.cachedQuad != QuadCache::None)
+			restingQuads.remove(sprite.cachedQuad);
+
+		entitiesById.erase(registry.get<EntityInfo>(entity.getHandle()).id);
+		removeEntityName(entity.getHandle());
+		registry.destroy(entity.getHandle());
+	}
+
+	Entity Scene::getEntity(const std::string& name) {
+		InternedString interned = names.find(name);
+		if (interned == StringInterner::None)
+			return {};
+
+		auto it = entitiesByName.find(interned);
+		if (it == entitiesByName.end() || it->second.empty())
+			return {};
+
+		return { registry.getHandle(it->second.front()), this };
+	}
+
+	Entity Scene::getEntity(uint64_t id) {
+		auto it = entitiesById.find(id);
+		if (it == entitiesById.end())
+			return {};
+
+		return { registry.getHandle(it->second), this };
+	}
+
+	bool Scene::setEntityId(EntityHandle entity, uint64_t id) {
+		EntityInfo& info = registry.get<EntityInfo>(entity);
+		if (info.id == id)
+			return true;
+		if (entitiesById.count(id))
+			return false;
+
+		entitiesById.erase(info.id);
+		entitiesById[id] = entity.Index;
+		info.id = id;
+
+		uint64_t next = s_NextEntityId.load();
+		while (next <= id && !s_NextEntityId.compare_exchange_weak(next, id + 1));
+		return true;
+	}
+
+	void Scene::setEntityName(EntityHandle entity, const std::string& name) {
+		// Before the old name goes, `name` may be it
+		const InternedString interned = names.intern(name);
+		EntityInfo& info = registry.get<EntityInfo>(entity);
+		if (info.name == interned)
+			return;
+
+		removeEntityName(entity);
+		info.name = interned;
+
+		std::vector<uint32_t>& named = entitiesByName[info.name];
+		info.nameSlot = (uint32_t)named.size();
+		named.push_back(entity.Index);
+	}
+
+	void Scene::removeEntityName(EntityHandle entity) {
+		EntityInfo& info = registry.get<EntityInfo>(entity);
+		if (info.name == StringInterner::None)
+			return;
+
+		// Swap with the last one of that name and pop
+		auto it = entitiesByName.find(info.name);
+		std::vector<uint32_t>& named = it->second;
+		const uint32_t last = named.back();
+		named[info.nameSlot] = last;
+		registry.get<EntityInfo>(registry.getHandle(last)).nameSlot = info.nameSlot;
+		named.pop_back();
 
-			int i = 0;
-			for (Entity* e : entities) {
-				if (entity == e) {
-					entities.erase(entities.begin() + i);
-					delete entity;
-					break;
-				}
-				i++;
-			}			
+		// Streamed cells bring new names all the time, those no entity has anymore are forgotten
+		if (named.empty()) {
+			entitiesByName.erase(it);
+			names.release(info.name);
+		}
+
+		info.name = StringInterner::None;
+	}
+
+	void Scene::queryRegion(const glm::vec2& min, const glm::vec2& max, std::vector<Entity>& result) const {
+		AABB region = { { min.x, min.y, 0.0f }, { max.x, max.y, 0.0f } };
+
+		for (const DynamicBVH* index : { &spatialIndex, &restingIndex }) {
+			index->queryRegion(region, [&](int32_t proxy) {
+				EntityHandle entity = registry.getHandle(toEntityIndex(index->getUserData(proxy)));
+				if (toSpatialBounds(registry.get<Transform>(entity)).overlaps(region))
+					result.emplace_back(entity, const_cast<Scene*>(this));
+				return true;
+			});
 		}
 	}
 
-	Entity& Scene::getEntity(const std::string& name) {
-		auto it = std::find_if(entities.begin(), entities.end(), [&name](Entity* e) {return e->getName() == name; });
+	void Scene::queryVisible(const Camera& camera, std::vector<Entity>& result) const {
+		Frustum frustum(camera.getViewProjectionMatrix());
+
+		for (const DynamicBVH* index : { &spatialIndex, &restingIndex }) {
+			index->queryFrustum(frustum, [&](int32_t proxy) {
+				result.emplace_back(registry.getHandle(toEntityIndex(index->getUserData(proxy))), const_cast<Scene*>(this));
+				return true;
+			});
+		}
+	}
+
+	Entity Scene::pick(const glm::vec2& point) const {
+		Entity found;
+
+		for (const DynamicBVH* index : { &spatialIndex, &restingIndex }) {
+			index->queryPoint({ point.x, point.y, 0.0f }, [&](int32_t proxy) {
+				Entity entity(registry.getHandle(toEntityIndex(index->getUserData(proxy))), const_cast<Scene*>(this));
+				if (entity.containsPoint(point) && (!found || entity.getZ() > found.getZ()))
+					found = entity;
+				return true;
+			});
+		}
+
+		return found;
+	}
+
+	Entity Scene::raycast(const glm::vec2& origin, const glm::vec2& direction, float maxDistance, float* hitDistance) const {
+		Ray ray;
+		ray.origin = { origin.x, origin.y, 0.0f };
+		ray.direction = { direction.x, direction.y, 0.0f };
+		ray.maxDistance = maxDistance;
+
+		EntityHandle found;
+		float closest = maxDistance;
 
-		if (it != entities.end())
-		{
-			// found element. it is an iterator to the first matching element.
-			// if you really need the index, you can also get it:
-			auto index = std::distance(entities.begin(), it);
-			return *entities[index];
+		// The second tree only looks closer than what the first one hit
+		for (const DynamicBVH* index : { &spatialIndex, &restingIndex }) {
+			ray.maxDistance = closest;
+			index->raycast(ray, [&](int32_t proxy, const Ray& clipped) {
+				EntityHandle entity = registry.getHandle(toEntityIndex(index->getUserData(proxy)));
+				const Transform& transform = registry.get<Transform>(entity);
+
+				// Exact test against the oriented box, done in the entity's local space
+				float c = std::cos(-transform.rotation);
+				float s = std::sin(-transform.rotation);
+
+				glm::vec2 localOrigin = { origin.x - transform.position.x, origin.y - transform.position.y };
+				localOrigin = { c * localOrigin.x - s * localOrigin.y, s * localOrigin.x + c * localOrigin.y };
+				glm::vec2 localDirection = { c * direction.x - s * direction.y, s * direction.x + c * direction.y };
+
+				Ray local;
+				local.origin = { localOrigin.x, localOrigin.y, 0.0f };
+				local.direction = { localDirection.x, localDirection.y, 0.0f };
+
+				glm::vec3 halfSize = { transform.scale.x / 2.0f, transform.scale.y / 2.0f, 0.0f };
+				float distance = local.intersect({ -halfSize, halfSize }, clipped.maxDistance);
+				if (distance < 0.0f)
+					return clipped.maxDistance;
+
+				found = entity;
+				closest = distance;
+				return distance;
+			});
 		}
 
-		SHADO_CORE_ASSERT(false, "Invalid entity name");
+		if (!registry.isValid(found))
+			return {};
+
+		if (hitDistance != nullptr)
+			*hitDistance = closest;
+
+		return { found, const_cast<Scene*>(this) };
 	}
 
-	Entity& Scene::getEntity(uint64_t id) {
-		auto it = std::find_if(entities.begin(), entities.end(), [&id](Entity* e) {return e->getId() == id; });
+	void Scene::drawEntities(const Camera& camera) const {
+		SHADO_PROFILE_FUNCTION();
+
+		// Resting entities aren't in the spatial index, drawn as they are on the GPU
+		Renderer2D::DrawQuadCache(restingQuads);
+
+		Frustum frustum(camera.getViewProjectionMatrix());
+
+		std::vector<uint32_t> visible;
+		spatialIndex.queryFrustum(frustum, [&](int32_t proxy) {
+			visible.push_back(toEntityIndex(spatialIndex.getUserData(proxy)));
+			return true;
+		});
+
+		// The BVH hands them out in tree order. By index, the lookups walk the component arrays mostly forward
+		std::sort(visible.begin(), visible.end());
+
+		// Blended between the two last snapshots of the bodies, never read from Box2D
+		const std::vector<BodyPose>& previousPoses = snapshots[previousSnapshot];
+		const std::vector<BodyPose>& currentPoses = snapshots[currentSnapshot];
+		SpriteBatch& batch = spriteBatch;
+		batch.resize((uint32_t)visible.size());
+		batch.textures.clear();
+		batch.textureIds.clear();
+
+		for (uint32_t i = 0; i < (uint32_t)visible.size(); i++) {
+			EntityHandle entity = registry.getHandle(visible[i]);
+			const Transform& transform = registry.get<Transform>(entity);
+			const Sprite& sprite = registry.get<Sprite>(entity);
+
+			const BodyPose& previous = previousPoses[visible[i]];
+			const BodyPose& current = currentPoses[visible[i]];
+			batch.x[i] = previous.x + (current.x - previous.x) * interpolationAlpha;
+			batch.y[i] = previous.y + (current.y - previous.y) * interpolationAlpha;
+			batch.z[i] = transform.position.z;
+			batch.width[i] = transform.scale.x;
+			batch.height[i] = transform.scale.y;
+			batch.angles[i] = previous.angle + (current.angle - previous.angle) * interpolationAlpha;
+
+			if (sprite.texture) {
+				auto [it, inserted] = batch.textureIds.try_emplace(sprite.texture.get(), (uint16_t)batch.textures.size());
+				if (inserted)
+					batch.textures.push_back(sprite.texture);
 
-		if (it != entities.end())
-		{
-			auto index = std::distance(entities.begin(), it);
-			return *entities[index];
+				batch.ids[i] = it->second;
+				batch.colors[i] = 0xFFFFFFFF;
+				batch.tilingFactors[i] = (float)sprite.tilingfactor;
+			} else {
+				batch.ids[i] = 0xFFFF;
+				batch.colors[i] = glm::packUnorm4x8((glm::vec4)sprite.color);
+				batch.tilingFactors[i] = 1.0f;
+			}
 		}
 
-		SHADO_CORE_ASSERT(false, "Invalid entity ID");
+		Renderer2D::SpriteArrays sprites;
+		sprites.Count = (uint32_t)visible.size();
+		sprites.X = batch.x.data();
+		sprites.Y = batch.y.data();
+		sprites.Z = batch.z.data();
+		sprites.Width = batch.width.data();
+		sprites.Height = batch.height.data();
+		sprites.Angles = batch.angles.data();
+		sprites.Colors = batch.colors.data();
+		sprites.TextureIds = batch.ids.data();
+		sprites.TilingFactors = batch.tilingFactors.data();
+		sprites.Textures = batch.textures.data();
+		sprites.TextureCount = (uint32_t)batch.textures.size();
+		Renderer2D::DrawSprites(sprites);
 	}
 
 	/*const std::vector<Layer*>& Scene::getLayers() const {
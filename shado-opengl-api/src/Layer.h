@@ -4,9 +4,18 @@
 #include "box2d/b2_world.h"
 #include "Events/Event.h"
 #include "util/Util.h"
+#include "util/DynamicBVH.h"
+#include "cameras/Camera.h"
 #include "Entity.h"
+#include "ecs/Registry.h"
+#include "JobSystem.h"
+#include "Renderer2D.h"
+#include "util/StringInterner.h"
+#include <unordered_map>
 
 namespace Shado {
+
+	class WorldPartition;
 	class Scene;
 	
 	/*class Layer {
@@ -50,8 +59,30 @@ namespace Shado {
 		 */
 		virtual void onUnMount()	{}
 
+		/**
+		 * Steps the world right away on the calling thread. With async physics the Application
+		 * doesn't use it, it hands the frame's steps to a worker instead (see setAsyncPhysics)
+		 */
 		virtual void updatePhysics(TimeStep dt) final;
 
+		/**
+		 * With async physics (the default), the frame's fixed steps run on a job system worker while the
+		 * frame is drawn from the state of the previous steps. Their result is collected at the start of the
+		 * next frame, or as soon as anything needs the bodies: the Entity setters that move bodies, creating
+		 * or destroying entities and getWorld() wait for the step first.
+		 * The frame's onFixedUpdate calls run back to back before the steps are handed over.
+		 */
+		void setAsyncPhysics(bool async);
+		bool isAsyncPhysics()							const { return asyncPhysics; }
+
+		// Box2D solver iterations of every step, 6 and 2 by default. More is stiffer and slower
+		void setPhysicsIterations(uint32_t velocityIterations, uint32_t positionIterations);
+		uint32_t getVelocityIterations()				const { return velocityIterations; }
+		uint32_t getPositionIterations()				const { return positionIterations; }
+
+		// Blocks until the steps running on a worker are done and copied to the entities
+		void waitForPhysics();
+
 		/**
 		 * This function is called on all scenes when the application runs
 		 */
@@ -64,6 +95,18 @@ namespace Shado {
 		 */
 		virtual void onUpdate(TimeStep dt)	{}
 
+		/**
+		 * This function is called at the fixed update rate (see Application::setFixedUpdateRate).
+		 * It may run several times in a frame, or not at all.
+		 *
+		 * With async physics (the default, see setAsyncPhysics), the frame's calls all run back to back
+		 * before any of its steps: they all see the bodies as the previous frame's steps left them, and the
+		 * steps then run together on a worker. Otherwise each call is followed right away by its step
+		 *
+		 * @param dt the fixed time step
+		 */
+		virtual void onFixedUpdate(TimeStep dt)	{}
+
 		/**
 		 * This function is called every frame and draw everything to the screen
 		 */
@@ -87,26 +130,166 @@ namespace Shado {
 		//void pushLayer(Layer* layer);
 
 		// Physics related functions
-		Entity* addEntityToWorld(Entity* entity);
-		Entity* addEntityToWorld(const EntityDefinition& def);
+		Entity addEntityToWorld(const EntityDefinition& def);
 		void setWorldGravity(const glm::vec2& gravity);
 
-		void destroyEntity(Entity* entity);
+		void destroyEntity(Entity entity);
+
+		// Hashed, O(1). An invalid Entity when there is none. With several of that name, any of them
+		Entity getEntity(const std::string& name);
+		Entity getEntity(uint64_t id);
 
-		Entity& getEntity(const std::string& name);
-		Entity& getEntity(uint64_t id);
+		// Spatial queries. Entities are 2D so the scene's BVH works in the XY plane
+		void queryRegion(const glm::vec2& min, const glm::vec2& max, std::vector<Entity>& result) const;
+		void queryVisible(const Camera& camera, std::vector<Entity>& result) const;
+
+		/**
+		 * Returns the front most entity (highest z) under the point, or an invalid Entity
+		 */
+		Entity pick(const glm::vec2& point) const;
+
+		/**
+		 * Returns the first entity hit by the ray, or an invalid Entity. hitDistance is in units of direction
+		 */
+		Entity raycast(const glm::vec2& origin, const glm::vec2& direction, float maxDistance = 1e30f, float* hitDistance = nullptr) const;
+
+		/**
+		 * Draws the entities visible by the camera. Must be called between Renderer2D::BeginScene and EndScene.
+		 * Resting entities (static bodies and sleeping ones) are kept in a QuadCache and drawn from there,
+		 * they cost nothing on the CPU until they change or wake up
+		 */
+		void drawEntities(const Camera& camera) const;
 		
 		// const std::vector<Layer*>& getLayers()	const;
 		const std::string& getName()			const { return name; }
-		b2World& getWorld()								{ return world; }
-		const std::vector<Entity*>& getAllEntities()	const { return entities; }	// TODO: remove
+		b2World& getWorld()								{ waitForPhysics(); return world; }
+		Registry& getRegistry()							{ return registry; }
+		const Registry& getRegistry()					const { return registry; }
+		const StringInterner& getNames()				const { return names; }
+		// The moving entities. The resting ones are in their own tree, the queries above look in both
+		const DynamicBVH& getSpatialIndex()				const { return spatialIndex; }
+		const DynamicBVH& getRestingIndex()				const { return restingIndex; }
+		// Bodies the steps and syncTransforms walk, the non-static ones
+		uint32_t getMovingBodyCount()					const { return (uint32_t)movingBodies.size(); }
+
+		/**
+		 * Streams the world saved in `directory` by WorldPartition::SaveCells into this scene, cell by cell
+		 * around the partition's focus. The Application updates it every frame right after onUpdate, set
+		 * the focus there. Replaces the previous partition, its entities stay in the scene
+		 */
+		WorldPartition& enableWorldPartition(const std::string& directory, float cellSize);
+		void disableWorldPartition();
+		WorldPartition* getWorldPartition()				{ return worldPartition.get(); }
+		const WorldPartition* getWorldPartition()		const { return worldPartition.get(); }
+
+		// Fraction of a fixed step elapsed since the last one, in [0, 1[. Drawing the previous simulation
+		// state blended toward the current one by this amount hides the steps. drawEntities does it with
+		// the two last body snapshots
+		float getInterpolationAlpha()					const { return interpolationAlpha; }
 		
 	protected:
 		// std::vector<Layer*> m_Layers;
 		std::string name;
 
 
-		std::vector<Entity*> entities;
+		Registry registry;
 		b2World world;
+
+	private:
+		// Copies the bodies that moved into their Transform and refits their BVH proxy
+		void syncTransforms(TimeStep dt);
+		// Static bodies aren't walked by the steps nor syncTransforms, the others are kept in movingBodies
+		void addMovingBody(EntityHandle entity);
+		void removeMovingBody(EntityHandle entity);
+		void setBodyType(EntityHandle entity, EntityType type);
+		// Refits the proxy and cached quad of an entity moved outside of the steps, and resets its snapshots
+		void onTeleported(EntityHandle entity);
+		// Starts `steps` steps on a worker, collected by waitForPhysics
+		void beginPhysics(uint32_t steps, TimeStep dt);
+		// The steps themselves, on whichever thread. Writes the snapshots of the last two
+		void stepWorld(uint32_t steps, TimeStep dt);
+		// Makes the snapshots written by the last steps the ones drawn
+		void publishSnapshots(uint32_t steps);
+		// Every snapshot takes the entity's current pose, it doesn't blend in from where it was
+		void resetSnapshots(EntityHandle entity);
+		// Moves the entity's proxy to the resting index and its quad to the cache, or back
+		void setResting(EntityHandle entity, bool resting);
+		// Rewrites the cached quad of a resting entity after its transform or sprite changed
+		void refreshQuad(EntityHandle entity);
+
+		void setEntityName(EntityHandle entity, const std::string& name);
+		// Gives the entity a saved id, unless another entity of the scene has it. Ids given later start after it
+		bool setEntityId(EntityHandle entity, uint64_t id);
+		void removeEntityName(EntityHandle entity);
+
+		DynamicBVH spatialIndex;
+		DynamicBVH restingIndex;
+		mutable QuadCache restingQuads;
+		float interpolationAlpha = 0.0f;
+
+		uint32_t velocityIterations = 6;
+		uint32_t positionIterations = 2;
+		bool asyncPhysics = true;
+		JobCounter physicsJob;
+		bool physicsPending = false;
+		TimeStep physicsStep = 0.0f;
+		uint32_t physicsSteps = 0;
+
+		/**
+		 * Poses of the bodies after a step, by entity index so they line up from one step to the next.
+		 * Four buffers: the previous and current snapshots are drawn while the steps write the other two
+		 * (the two last steps, when there are several). Only the main thread swaps them, once the steps
+		 * are done, so drawing never waits on physics nor locks.
+		 */
+		struct BodyPose {
+			float x, y, angle;
+		};
+		std::vector<BodyPose> snapshots[4];
+		uint32_t previousSnapshot = 0, currentSnapshot = 1;
+		uint32_t nextPreviousSnapshot = 2, nextCurrentSnapshot = 3;
+
+		// Every non-static body, packed. Read by the steps, only changed once they are collected
+		struct MovingBody {
+			uint32_t entity;
+			b2Body* body;
+		};
+		std::vector<MovingBody> movingBodies;
+
+		// drawEntities' arrays for Renderer2D::DrawSprites, kept to not reallocate them every frame
+		struct SpriteBatch {
+			std::vector<float> x, y, z, width, height, angles, tilingFactors;
+			std::vector<uint32_t> colors;
+			std::vector<uint16_t> ids;
+			std::vector<Ref<Texture2D>> textures;
+			std::unordered_map<const Texture2D*, uint16_t> textureIds;
+
+			void resize(uint32_t count) {
+				for (std::vector<float>* array : { &x, &y, &z, &width, &height, &angles, &tilingFactors })
+					array->resize(count);
+				colors.resize(count);
+				ids.resize(count);
+			}
+		};
+		mutable SpriteBatch spriteBatch;
+
+		ScopedPtr<WorldPartition> worldPartition;
+
+		StringInterner names;
+		std::unordered_map<uint64_t, uint32_t> entitiesById;							// Id -> entity index
+		std::unordered_map<InternedString, std::vector<uint32_t>> entitiesByName;		// Entity indices
+
+		friend class Application;
+		friend class Entity;
+		friend class SceneSerializer;
 	};
+
+	template<typename T>
+	T& Entity::getComponent() const {
+		return m_Scene->getRegistry().get<T>(m_Handle);
+	}
+
+	template<typename T>
+	bool Entity::hasComponent() const {
+		return m_Scene != nullptr && m_Scene->getRegistry().has<T>(m_Handle);
+	}
 }
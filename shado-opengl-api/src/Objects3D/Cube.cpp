@@ -38,16 +38,15 @@ namespace Shado {
 			6, 7, 3
 		};
 
-		vertexBuffer = VertexBuffer::create(cube_vertices, sizeof(cube_vertices));
-		vertexBuffer->setLayout({
+		auto arena = GpuBufferArena::get({
 			{ShaderDataType::Float3, "a_Position"}
 		});
-		
-		indexBuffer = IndexBuffer::create(cube_elements, sizeof(cube_elements) / sizeof(uint32_t));
+		gpuMesh = arena->allocate(cube_vertices, 8, cube_elements, sizeof(cube_elements) / sizeof(uint32_t));
 
-		vao = VertexArray::create();
-		vao->addVertexBuffer(vertexBuffer);
-		vao->setIndexBuffer(indexBuffer);		
+		std::vector<glm::vec3> positions;
+		for (uint32_t i = 0; i < sizeof(cube_vertices) / sizeof(float); i += 3)
+			positions.emplace_back(cube_vertices[i], cube_vertices[i + 1], cube_vertices[i + 2]);
+		setGeometry(std::move(positions), std::vector<uint32_t>(std::begin(cube_elements), std::end(cube_elements)));
 	}
 	
 }
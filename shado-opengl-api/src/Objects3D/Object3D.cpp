@@ -3,9 +3,15 @@
 #include "../Application.h"
 #include "glm/vec3.hpp"
 #include "glm/vec4.hpp"
+#include "glm/gtc/packing.hpp"
 
 namespace Shado {
 
+	struct MeshVertex {
+		glm::vec3 Position;
+		uint32_t Normal;	// Int10_10_10_2
+	};
+
 	Object3D::Object3D(const std::string& filename) {
 
 		using namespace std;
@@ -57,36 +63,46 @@ namespace Shado {
 		}
 
 
-		// Merge vertecies and Normals to 1 Vector to upload it to GPU
-		vector<float> vecticesNormals;
+		// Merge vertecies and Normals to 1 Vector to upload it to GPU (w is always 1 so it's left to the shader)
+		vector<MeshVertex> vecticesNormals;
+		vecticesNormals.reserve(vertices.size());
 
 		for (int i = 0; i < vertices.size(); i++) {
 
 			const auto& vertex = vertices[i];
 			const auto& normal = normals[i];
 
-			vecticesNormals.push_back(vertex.x);
-			vecticesNormals.push_back(vertex.y);
-			vecticesNormals.push_back(vertex.z);
-			vecticesNormals.push_back(vertex.w);
-
-			vecticesNormals.push_back(normal.x);
-			vecticesNormals.push_back(normal.y);
-			vecticesNormals.push_back(normal.z);
+			vecticesNormals.push_back({ glm::vec3(vertex), glm::packSnorm3x10_1x2(glm::vec4(normal, 0.0f)) });
 		}
 
-		vertexBuffer = VertexBuffer::create(&vecticesNormals[0], sizeof(float) * vecticesNormals.size());
-		indexBuffer = IndexBuffer::create(&elements[0], elements.size());
-
-		vertexBuffer->setLayout({
-			{ShaderDataType::Float4, "a_Position"},
-			{ShaderDataType::Float3, "a_Normal"  }
+		auto arena = GpuBufferArena::get({
+			{ShaderDataType::Float3, "a_Position"},
+			{ShaderDataType::Int10_10_10_2, "a_Normal"  }
 			});
+		gpuMesh = arena->allocate(vecticesNormals.data(), (uint32_t)vertices.size(), elements.data(), (uint32_t)elements.size());
 
-		vao = VertexArray::create();
-		vao->setIndexBuffer(indexBuffer);
-		vao->addVertexBuffer(vertexBuffer);
+		std::vector<glm::vec3> positions;
+		positions.reserve(vertices.size());
+		for (const auto& vertex : vertices)
+			positions.emplace_back(vertex);
+		setGeometry(std::move(positions), std::move(elements));
 
 		SHADO_CORE_INFO("Vertecies {0}", vertices.size());
 	}
+
+	void Object3D::setGeometry(std::vector<glm::vec3> positions, std::vector<uint32_t> indices) {
+		this->positions = std::move(positions);
+		this->indices = std::move(indices);
+
+		if (this->positions.empty()) {
+			localBounds = AABB();
+			return;
+		}
+
+		localBounds = { this->positions[0], this->positions[0] };
+		for (const auto& position : this->positions) {
+			localBounds.min = { std::min(localBounds.min.x, position.x), std::min(localBounds.min.y, position.y), std::min(localBounds.min.z, position.z) };
+			localBounds.max = { std::max(localBounds.max.x, position.x), std::max(localBounds.max.y, position.y), std::max(localBounds.max.z, position.z) };
+		}
+	}
 }
@@ -1,6 +1,7 @@
 ﻿#pragma once
-#include "../VertexArray.h"
+#include "../GpuBufferArena.h"
 #include "../cameras/Camera.h"
+#include "../util/Bounds.h"
 
 namespace Shado {
 
@@ -10,15 +11,26 @@ namespace Shado {
 		virtual ~Object3D() = default;
 
 
-		Ref<VertexArray> getVertexArray() const { return  vao; }
+		Ref<VertexArray> getVertexArray() const { return  gpuMesh->getVertexArray(); }
+		const Ref<GpuMesh>& getGpuMesh() const { return gpuMesh; }
+
+		// CPU copy of the geometry, used as occluder data by the occlusion culler
+		const std::vector<glm::vec3>& getPositions()	const { return positions; }
+		const std::vector<uint32_t>& getIndices()		const { return indices; }
+		const AABB& getLocalBounds()					const { return localBounds; }
 
 	protected:
 		Object3D() = default;
 
+		void setGeometry(std::vector<glm::vec3> positions, std::vector<uint32_t> indices);
+
 	protected:
-		Ref<VertexArray> vao;
-		Ref<IndexBuffer> indexBuffer;
-		Ref<VertexBuffer> vertexBuffer;
+		// Sub-allocated from the shared arena of the mesh's layout
+		Ref<GpuMesh> gpuMesh;
+
+		std::vector<glm::vec3> positions;
+		std::vector<uint32_t> indices;
+		AABB localBounds;
 	};
 
 }
@@ -70,15 +70,15 @@ namespace Shado {
             }
         }
 
-		vertexBuffer = VertexBuffer::create(&vertices[0], sizeof(float) * vertices.size());
-		indexBuffer = IndexBuffer::create(&indices[0], indices.size());
-
-		vertexBuffer->setLayout({
+		auto arena = GpuBufferArena::get({
 			{ShaderDataType::Float3, "a_Position"},
 		});
+		gpuMesh = arena->allocate(vertices.data(), (uint32_t)(vertices.size() / 3), indices.data(), (uint32_t)indices.size());
 
-		vao = VertexArray::create();
-		vao->addVertexBuffer(vertexBuffer);
-		vao->setIndexBuffer(indexBuffer);			
+		std::vector<glm::vec3> positions;
+		positions.reserve(vertices.size() / 3);
+		for (size_t i = 0; i < vertices.size(); i += 3)
+			positions.emplace_back(vertices[i], vertices[i + 1], vertices[i + 2]);
+		setGeometry(std::move(positions), std::move(indices));
 	}
 }
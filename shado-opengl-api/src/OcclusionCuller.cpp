@@ -0,0 +1,361 @@
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <cmath>
+#include "Debug.h"
+#include "JobSystem.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define SHADO_OCCLUSION_SSE 1
+	#include <emmintrin.h>
+#else
+	#define SHADO_OCCLUSION_SSE 0
+#endif
+
+namespace Shado {
+
+	// Rows rasterized together by one thread
+	static constexpr uint32_t TILE_HEIGHT = 8;
+
+	// Per triangle edge equations and depth plane, in screen space
+	struct EdgeSetup {
+		float A[3], B[3], C[3];
+		float zA, zB, zC;
+		int32_t minX, maxX;
+	};
+
+	static EdgeSetup computeSetup(const glm::vec3 v[3]) {
+		EdgeSetup setup;
+
+		// Edge i goes from v[i] to v[(i + 1) % 3]
+		for (int i = 0; i < 3; i++) {
+			const glm::vec3& a = v[i];
+			const glm::vec3& b = v[(i + 1) % 3];
+			setup.A[i] = a.y - b.y;
+			setup.B[i] = b.x - a.x;
+			setup.C[i] = -(setup.A[i] * a.x + setup.B[i] * a.y);
+		}
+
+		// The edge opposite to a vertex gives its barycentric weight
+		float area = setup.A[0] * v[2].x + setup.B[0] * v[2].y + setup.C[0];
+		float invArea = 1.0f / area;
+
+		setup.zA = (setup.A[1] * v[0].z + setup.A[2] * v[1].z + setup.A[0] * v[2].z) * invArea;
+		setup.zB = (setup.B[1] * v[0].z + setup.B[2] * v[1].z + setup.B[0] * v[2].z) * invArea;
+		setup.zC = (setup.C[1] * v[0].z + setup.C[2] * v[1].z + setup.C[0] * v[2].z) * invArea;
+
+		float minX = std::min({ v[0].x, v[1].x, v[2].x });
+		float maxX = std::max({ v[0].x, v[1].x, v[2].x });
+		setup.minX = (int32_t)std::floor(minX);
+		setup.maxX = (int32_t)std::ceil(maxX);
+
+		return setup;
+	}
+
+	OcclusionCuller::OcclusionCuller(uint32_t width, uint32_t height, uint32_t threadCount) {
+		resize(width, height);
+		setThreadCount(threadCount);
+	}
+
+	void OcclusionCuller::resize(uint32_t width, uint32_t height) {
+		SHADO_CORE_ASSERT(width > 0 && height > 0, "Occlusion buffer can't be empty!");
+
+		m_Width = width;
+		m_Height = height;
+		m_Stride = (width + 3) & ~3u;
+
+		m_DepthBuffer.assign((size_t)m_Stride * m_Height, 1.0f);
+
+		// Mip chain down to 1x1
+		m_Levels.clear();
+		uint32_t w = width, h = height;
+		while (true) {
+			m_Levels.push_back({ w, h, std::vector<float>((size_t)w * h, 1.0f) });
+			if (w == 1 && h == 1)
+				break;
+			w = std::max(1u, (w + 1) / 2);
+			h = std::max(1u, (h + 1) / 2);
+		}
+
+		m_Rasterized = false;
+	}
+
+	void OcclusionCuller::setThreadCount(uint32_t threadCount) {
+		m_ThreadCount = threadCount;
+	}
+
+	void OcclusionCuller::beginFrame(const glm::mat4& viewProjection) {
+		m_ViewProjection = viewProjection;
+		m_Triangles.clear();
+		m_Rasterized = false;
+		m_Stats = Statistics();
+	}
+
+	void OcclusionCuller::addOccluder(const glm::vec3* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, const glm::mat4& transform) {
+		glm::mat4 mvp = m_ViewProjection * transform;
+
+		std::vector<glm::vec4> clip(vertexCount);
+		for (uint32_t i = 0; i < vertexCount; i++)
+			clip[i] = mvp * glm::vec4(vertices[i], 1.0f);
+
+		for (uint32_t i = 0; i + 2 < indexCount; i += 3) {
+			const glm::vec4 triangle[3] = { clip[indices[i]], clip[indices[i + 1]], clip[indices[i + 2]] };
+			clipAndSetup(triangle);
+		}
+
+		m_Stats.OccluderTriangles += indexCount / 3;
+		m_Rasterized = false;
+	}
+
+	void OcclusionCuller::clipAndSetup(const glm::vec4 clip[3]) {
+		// Trivial reject when all vertices are outside the same plane
+		auto outside = [&clip](auto test) {
+			return test(clip[0]) && test(clip[1]) && test(clip[2]);
+		};
+		if (outside([](const glm::vec4& v) { return v.x > v.w; })	|| outside([](const glm::vec4& v) { return v.x < -v.w; }) ||
+			outside([](const glm::vec4& v) { return v.y > v.w; })	|| outside([](const glm::vec4& v) { return v.y < -v.w; }) ||
+			outside([](const glm::vec4& v) { return v.z > v.w; })	|| outside([](const glm::vec4& v) { return v.z < -v.w; }))
+			return;
+
+		// Only the near plane needs real clipping, the rest is handled by the screen bounds
+		auto distance = [](const glm::vec4& v) { return v.z + v.w; };
+
+		glm::vec4 polygon[4];
+		int count = 0;
+		for (int i = 0; i < 3; i++) {
+			const glm::vec4& a = clip[i];
+			const glm::vec4& b = clip[(i + 1) % 3];
+			float da = distance(a);
+			float db = distance(b);
+
+			if (da >= 0.0f)
+				polygon[count++] = a;
+
+			if ((da >= 0.0f) != (db >= 0.0f)) {
+				float t = da / (da - db);
+				polygon[count++] = a + (b - a) * t;
+			}
+		}
+
+		for (int i = 1; i + 1 < count; i++)
+			setupTriangle(polygon[0], polygon[i], polygon[i + 1]);
+	}
+
+	void OcclusionCuller::setupTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c) {
+		const glm::vec4* clip[3] = { &a, &b, &c };
+
+		Triangle triangle;
+		for (int i = 0; i < 3; i++) {
+			const glm::vec4& v = *clip[i];
+			if (v.w <= 1e-6f)
+				return;
+
+			float invW = 1.0f / v.w;
+			triangle.v[i] = {
+				(v.x * invW * 0.5f + 0.5f) * m_Width,
+				(v.y * invW * 0.5f + 0.5f) * m_Height,
+				v.z * invW * 0.5f + 0.5f
+			};
+		}
+
+		// Make every triangle counter clockwise so the edge functions are positive inside
+		float area = (triangle.v[1].x - triangle.v[0].x) * (triangle.v[2].y - triangle.v[0].y)
+			- (triangle.v[1].y - triangle.v[0].y) * (triangle.v[2].x - triangle.v[0].x);
+		if (std::abs(area) < 1e-8f)
+			return;
+		if (area < 0.0f)
+			std::swap(triangle.v[1], triangle.v[2]);
+
+		float minY = std::min({ triangle.v[0].y, triangle.v[1].y, triangle.v[2].y });
+		float maxY = std::max({ triangle.v[0].y, triangle.v[1].y, triangle.v[2].y });
+		triangle.minY = std::max(0, (int32_t)std::floor(minY));
+		triangle.maxY = std::min((int32_t)m_Height - 1, (int32_t)std::ceil(maxY));
+
+		if (triangle.minY > triangle.maxY)
+			return;
+
+		m_Triangles.push_back(triangle);
+	}
+
+	void OcclusionCuller::rasterize() {
+		std::fill(m_DepthBuffer.begin(), m_DepthBuffer.end(), 1.0f);
+
+		const uint32_t tileCount = (m_Height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+		const uint32_t threads = m_ThreadCount ? m_ThreadCount : JobSystem::GetThreadCount();
+
+		if (m_Triangles.empty() || threads <= 1) {
+			rasterizeRows(0, m_Height);
+		} else {
+			// A few batches per thread, whoever is done first steals what's left of the dense areas
+			const uint32_t batchSize = std::max(1u, tileCount / (threads * 4));
+			JobSystem::ParallelFor(tileCount, batchSize, [this](uint32_t begin, uint32_t end) {
+				rasterizeRows(begin * TILE_HEIGHT, std::min(end * TILE_HEIGHT, m_Height));
+			});
+		}
+
+		buildPyramid();
+		m_Rasterized = true;
+	}
+
+	void OcclusionCuller::rasterizeRows(uint32_t beginRow, uint32_t endRow) {
+		for (const Triangle& triangle : m_Triangles) {
+			if (triangle.maxY < (int32_t)beginRow || triangle.minY >= (int32_t)endRow)
+				continue;
+
+			rasterizeTriangle(triangle, (int32_t)beginRow, (int32_t)endRow);
+		}
+	}
+
+	void OcclusionCuller::rasterizeTriangle(const Triangle& triangle, int32_t beginRow, int32_t endRow) {
+		EdgeSetup s = computeSetup(triangle.v);
+
+		int32_t minX = std::max(0, s.minX) & ~3;
+		int32_t maxX = std::min((int32_t)m_Width - 1, s.maxX);
+		int32_t minY = std::max(beginRow, triangle.minY);
+		int32_t maxY = std::min(endRow - 1, triangle.maxY);
+
+		if (minX > maxX)
+			return;
+
+		for (int32_t y = minY; y <= maxY; y++) {
+			float* row = &m_DepthBuffer[(size_t)y * m_Stride];
+			const float py = (float)y + 0.5f;
+
+			float rowE[3];
+			for (int i = 0; i < 3; i++)
+				rowE[i] = s.B[i] * py + s.C[i];
+			const float rowZ = s.zB * py + s.zC;
+
+#if SHADO_OCCLUSION_SSE
+			const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 A0 = _mm_set1_ps(s.A[0]), A1 = _mm_set1_ps(s.A[1]), A2 = _mm_set1_ps(s.A[2]);
+			const __m128 E0 = _mm_set1_ps(rowE[0]), E1 = _mm_set1_ps(rowE[1]), E2 = _mm_set1_ps(rowE[2]);
+			const __m128 ZA = _mm_set1_ps(s.zA), Z0 = _mm_set1_ps(rowZ);
+
+			for (int32_t x = minX; x <= maxX; x += 4) {
+				__m128 px = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+
+				__m128 e0 = _mm_add_ps(_mm_mul_ps(A0, px), E0);
+				__m128 e1 = _mm_add_ps(_mm_mul_ps(A1, px), E1);
+				__m128 e2 = _mm_add_ps(_mm_mul_ps(A2, px), E2);
+				__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+				if (_mm_movemask_ps(inside) == 0)
+					continue;
+
+				__m128 z = _mm_add_ps(_mm_mul_ps(ZA, px), Z0);
+				// The depth buffer is a std::vector<float>, its rows are only sure to be float aligned
+				__m128 current = _mm_loadu_ps(row + x);
+				__m128 nearest = _mm_min_ps(current, z);
+				_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+			}
+#else
+			for (int32_t x = minX; x <= maxX; x++) {
+				const float px = (float)x + 0.5f;
+				if (s.A[0] * px + rowE[0] < 0.0f || s.A[1] * px + rowE[1] < 0.0f || s.A[2] * px + rowE[2] < 0.0f)
+					continue;
+
+				float z = s.zA * px + rowZ;
+				row[x] = std::min(row[x], z);
+			}
+#endif
+		}
+	}
+
+	void OcclusionCuller::buildPyramid() {
+		// Level 0 drops the SIMD padding
+		Level& base = m_Levels[0];
+		for (uint32_t y = 0; y < m_Height; y++)
+			std::copy_n(&m_DepthBuffer[(size_t)y * m_Stride], m_Width, &base.depth[(size_t)y * m_Width]);
+
+		// Each texel keeps the farthest depth of its children so tests stay conservative
+		for (size_t i = 1; i < m_Levels.size(); i++) {
+			const Level& src = m_Levels[i - 1];
+			Level& dst = m_Levels[i];
+
+			for (uint32_t y = 0; y < dst.height; y++) {
+				uint32_t y0 = y * 2;
+				uint32_t y1 = std::min(y0 + 1, src.height - 1);
+
+				for (uint32_t x = 0; x < dst.width; x++) {
+					uint32_t x0 = x * 2;
+					uint32_t x1 = std::min(x0 + 1, src.width - 1);
+
+					float depth = std::max(
+						std::max(src.depth[y0 * src.width + x0], src.depth[y0 * src.width + x1]),
+						std::max(src.depth[y1 * src.width + x0], src.depth[y1 * src.width + x1]));
+					dst.depth[y * dst.width + x] = depth;
+				}
+			}
+		}
+	}
+
+	bool OcclusionCuller::isVisible(const AABB& bounds) {
+		m_Stats.TestedObjects++;
+
+		if (!m_Rasterized)
+			return true;
+
+		float minX = 1e30f, minY = 1e30f, minZ = 1e30f;
+		float maxX = -1e30f, maxY = -1e30f;
+
+		for (int i = 0; i < 8; i++) {
+			glm::vec3 corner = {
+				(i & 1) ? bounds.max.x : bounds.min.x,
+				(i & 2) ? bounds.max.y : bounds.min.y,
+				(i & 4) ? bounds.max.z : bounds.min.z
+			};
+
+			glm::vec4 clip = m_ViewProjection * glm::vec4(corner, 1.0f);
+
+			// Crosses the camera plane, can't say anything about it
+			if (clip.w <= 1e-6f)
+				return true;
+
+			float invW = 1.0f / clip.w;
+			minX = std::min(minX, clip.x * invW);
+			maxX = std::max(maxX, clip.x * invW);
+			minY = std::min(minY, clip.y * invW);
+			maxY = std::max(maxY, clip.y * invW);
+			minZ = std::min(minZ, clip.z * invW);
+		}
+
+		// Outside of the frustum
+		if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f || minZ > 1.0f) {
+			m_Stats.CulledObjects++;
+			return false;
+		}
+
+		float depth = std::max(0.0f, minZ * 0.5f + 0.5f);
+
+		auto toPixel = [](float ndc, uint32_t size) {
+			int32_t pixel = (int32_t)std::floor((ndc * 0.5f + 0.5f) * size);
+			return std::clamp(pixel, 0, (int32_t)size - 1);
+		};
+
+		int32_t x0 = toPixel(minX, m_Width), x1 = toPixel(maxX, m_Width);
+		int32_t y0 = toPixel(minY, m_Height), y1 = toPixel(maxY, m_Height);
+
+		// Pick the level where the rectangle covers at most 2x2 texels
+		uint32_t size = (uint32_t)std::max(x1 - x0 + 1, y1 - y0 + 1);
+		uint32_t level = 0;
+		while ((1u << level) < size && level + 1 < m_Levels.size())
+			level++;
+
+		const Level& mip = m_Levels[level];
+		for (int32_t y = y0 >> level; y <= (y1 >> level); y++) {
+			for (int32_t x = x0 >> level; x <= (x1 >> level); x++) {
+				if (depth <= mip.depth[(size_t)y * mip.width + x])
+					return true;
+			}
+		}
+
+		m_Stats.CulledObjects++;
+		return false;
+	}
+
+	float OcclusionCuller::getDepth(uint32_t x, uint32_t y, uint32_t level) const {
+		const Level& mip = m_Levels[level];
+		return mip.depth[(size_t)y * mip.width + x];
+	}
+}
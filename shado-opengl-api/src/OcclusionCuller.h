@@ -0,0 +1,89 @@
+#pragma once
+
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include <cstdint>
+#include <vector>
+#include "glm/mat4x4.hpp"
+#include "util/Bounds.h"
+
+namespace Shado {
+
+	/**
+	 * Hierarchical-Z occlusion culling on the CPU.
+	 *
+	 * Designated occluders are rasterized into a small depth buffer (SIMD, split in horizontal tiles
+	 * rasterized in parallel on the JobSystem), then a max-depth pyramid is built from it. Bounds are tested against
+	 * the pyramid level where they cover at most a couple of texels.
+	 *
+	 * Nothing here touches OpenGL so it can run (and be tested) without a GPU.
+	 *
+	 * Usage per frame: beginFrame -> addOccluder (n times) -> rasterize -> isVisible (n times)
+	 */
+	class OcclusionCuller {
+	public:
+		OcclusionCuller(uint32_t width = 256, uint32_t height = 128, uint32_t threadCount = 0);
+		~OcclusionCuller() = default;
+
+		void resize(uint32_t width, uint32_t height);
+		void setThreadCount(uint32_t threadCount);	// 0 = every thread of the JobSystem, 1 = only the calling thread
+
+		void beginFrame(const glm::mat4& viewProjection);
+
+		void addOccluder(const glm::vec3* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, const glm::mat4& transform);
+
+		// Rasterizes the occluders submitted since beginFrame and builds the depth pyramid
+		void rasterize();
+
+		bool isVisible(const AABB& worldBounds);
+
+		bool hasRasterized()	const { return m_Rasterized; }
+		uint32_t getWidth()		const { return m_Width; }
+		uint32_t getHeight()	const { return m_Height; }
+		uint32_t getLevelCount() const { return (uint32_t)m_Levels.size(); }
+
+		// Depth in [0, 1] (1 = far plane). Mostly useful for debugging and tests
+		float getDepth(uint32_t x, uint32_t y, uint32_t level = 0) const;
+
+		struct Statistics {
+			uint32_t OccluderTriangles = 0;
+			uint32_t TestedObjects = 0;
+			uint32_t CulledObjects = 0;
+		};
+		const Statistics& getStats() const { return m_Stats; }
+
+	private:
+		struct Triangle {
+			glm::vec3 v[3];		// Screen space x, y and depth
+			int32_t minY, maxY;
+		};
+
+		struct Level {
+			uint32_t width, height;
+			std::vector<float> depth;
+		};
+
+		void clipAndSetup(const glm::vec4 clip[3]);
+		void setupTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+		void rasterizeRows(uint32_t beginRow, uint32_t endRow);
+		void rasterizeTriangle(const Triangle& triangle, int32_t beginRow, int32_t endRow);
+		void buildPyramid();
+
+	private:
+		uint32_t m_Width = 0, m_Height = 0;
+		uint32_t m_Stride = 0;		// Row pitch of level 0, padded to a multiple of 4 for SIMD
+		uint32_t m_ThreadCount = 0;
+
+		glm::mat4 m_ViewProjection = glm::mat4(1.0f);
+
+		std::vector<Triangle> m_Triangles;
+		std::vector<float> m_DepthBuffer;
+		std::vector<Level> m_Levels;	// [0] is a copy of the depth buffer without padding
+
+		bool m_Rasterized = false;
+		Statistics m_Stats;
+	};
+}
+
+#endif
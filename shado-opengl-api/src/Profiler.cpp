@@ -0,0 +1,398 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "GL/glew.h"
+#include "Debug.h"
+#include "RenderCommandQueue.h"
+
+namespace Shado {
+
+	// Single producer (its thread), single consumer (EndFrame)
+	struct ProfileThreadBuffer {
+		static constexpr uint32_t Capacity = 1 << 14;
+
+		ProfileEvent Events[Capacity];
+		std::atomic<uint32_t> Head = 0;
+		std::atomic<uint32_t> Tail = 0;
+		std::atomic<uint64_t> Dropped = 0;
+
+		uint16_t Index = 0;
+		uint16_t Depth = 0;
+
+		void push(const ProfileEvent& event) {
+			const uint32_t head = Head.load(std::memory_order_relaxed);
+			if (head - Tail.load(std::memory_order_acquire) == Capacity) {
+				Dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+
+			Events[head % Capacity] = event;
+			Head.store(head + 1, std::memory_order_release);
+		}
+
+		void drain(std::vector<ProfileEvent>& out) {
+			const uint32_t tail = Tail.load(std::memory_order_relaxed);
+			const uint32_t head = Head.load(std::memory_order_acquire);
+			for (uint32_t i = tail; i != head; i++)
+				out.push_back(Events[i % Capacity]);
+			Tail.store(head, std::memory_order_release);
+		}
+	};
+
+	struct ProfilerData {
+		std::mutex Mutex;	// Registration and names, never taken while recording
+		std::vector<std::unique_ptr<ProfileThreadBuffer>> Buffers;
+		std::vector<std::string> Names;
+		bool NamesChanged = false;
+
+		// Main thread only
+		std::vector<std::string> ThreadNames;
+		std::vector<ProfileFrame> Frames;
+		ProfileFrame Discarded;
+		uint32_t HistorySize = 120;
+		uint64_t LastFrameEnd = 0;
+		uint64_t Dropped = 0;
+		bool Paused = false;
+
+		ProfileThreadBuffer* Gpu = nullptr;
+	};
+
+	// Never freed, threads finishing at exit may still record
+	static ProfilerData& getData() {
+		static ProfilerData* data = new ProfilerData;
+		return *data;
+	}
+
+	static ProfileThreadBuffer* registerThread(const std::string& name) {
+		ProfilerData& data = getData();
+		std::lock_guard<std::mutex> lock(data.Mutex);
+
+		auto buffer = std::make_unique<ProfileThreadBuffer>();
+		buffer->Index = (uint16_t)data.Buffers.size();
+		data.Names.push_back(name.empty() ? "Thread " + std::to_string(buffer->Index) : name);
+		data.NamesChanged = true;
+		data.Buffers.push_back(std::move(buffer));
+		return data.Buffers.back().get();
+	}
+
+	static ProfileThreadBuffer& getThreadBuffer() {
+		thread_local ProfileThreadBuffer* buffer = registerThread("");
+		return *buffer;
+	}
+
+	// =========================== PROFILER ===========================
+
+	uint64_t Profiler::Now() {
+		static const auto epoch = std::chrono::steady_clock::now();
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+	}
+
+	void Profiler::SetThreadName(const std::string& name) {
+		ProfilerData& data = getData();
+		ProfileThreadBuffer& buffer = getThreadBuffer();
+
+		std::lock_guard<std::mutex> lock(data.Mutex);
+		data.Names[buffer.Index] = name;
+		data.NamesChanged = true;
+	}
+
+	void Profiler::BeginScope() {
+		getThreadBuffer().Depth++;
+	}
+
+	void Profiler::EndScope(const char* name, uint64_t start) {
+		ProfileThreadBuffer& buffer = getThreadBuffer();
+		buffer.Depth--;
+		buffer.push({ name, start, Now() - start, buffer.Depth, buffer.Index });
+	}
+
+	void Profiler::EndFrame() {
+		ProfilerData& data = getData();
+		const uint64_t now = Now();
+
+		// GPU results of earlier frames that are ready by now
+		RenderCommandQueue::Submit([]() { CollectGpu(); });
+
+		ProfileFrame* frame = &data.Discarded;
+		if (!data.Paused) {
+			if (data.Frames.size() < data.HistorySize) {
+				data.Frames.emplace_back();
+			} else {
+				// Reuses the oldest frame's memory
+				std::rotate(data.Frames.begin(), data.Frames.begin() + 1, data.Frames.end());
+			}
+			frame = &data.Frames.back();
+		}
+
+		frame->Start = data.LastFrameEnd;
+		frame->End = now;
+		frame->Events.clear();
+		data.LastFrameEnd = now;
+
+		std::lock_guard<std::mutex> lock(data.Mutex);
+		if (data.NamesChanged) {
+			data.ThreadNames = data.Names;
+			data.NamesChanged = false;
+		}
+		data.Dropped = 0;
+		for (auto& buffer : data.Buffers) {
+			buffer->drain(frame->Events);
+			data.Dropped += buffer->Dropped.load(std::memory_order_relaxed);
+		}
+	}
+
+	void Profiler::SetPaused(bool paused) {
+		getData().Paused = paused;
+	}
+
+	bool Profiler::IsPaused() {
+		return getData().Paused;
+	}
+
+	void Profiler::SetHistorySize(uint32_t frames) {
+		ProfilerData& data = getData();
+		data.HistorySize = std::max(frames, 1u);
+		if (data.Frames.size() > data.HistorySize)
+			data.Frames.erase(data.Frames.begin(), data.Frames.end() - data.HistorySize);
+	}
+
+	const std::vector<ProfileFrame>& Profiler::GetFrames() {
+		return getData().Frames;
+	}
+
+	const std::vector<std::string>& Profiler::GetThreadNames() {
+		return getData().ThreadNames;
+	}
+
+	uint64_t Profiler::GetDroppedEventCount() {
+		return getData().Dropped;
+	}
+
+	// =========================== GPU ===========================
+
+	struct GpuScope {
+		const char* Name;
+		uint32_t Begin, End;	// Timestamp queries, 0 when skipped
+		uint16_t Depth;
+	};
+
+	// Per thread, query objects belong to the context of whoever draws
+	struct GpuProfilerState {
+		static constexpr size_t MaxPending = 1024;
+
+		std::vector<uint32_t> FreeQueries;
+		std::vector<GpuScope> Open;
+		std::deque<GpuScope> Pending;
+
+		uint32_t getQuery() {
+			if (FreeQueries.empty()) {
+				FreeQueries.resize(64);
+				glGenQueries((GLsizei)FreeQueries.size(), FreeQueries.data());
+			}
+
+			uint32_t query = FreeQueries.back();
+			FreeQueries.pop_back();
+			return query;
+		}
+	};
+
+	static thread_local GpuProfilerState t_Gpu;
+
+	void Profiler::BeginGpuScope(const char* name) {
+		GpuScope scope = { name, 0, 0, (uint16_t)t_Gpu.Open.size() };
+
+		// Results not read back for a long time (no EndFrame), stop measuring
+		if (t_Gpu.Pending.size() < GpuProfilerState::MaxPending) {
+			scope.Begin = t_Gpu.getQuery();
+			glQueryCounter(scope.Begin, GL_TIMESTAMP);
+		}
+
+		t_Gpu.Open.push_back(scope);
+	}
+
+	void Profiler::EndGpuScope() {
+		SHADO_CORE_ASSERT(!t_Gpu.Open.empty(), "EndGpuScope without BeginGpuScope");
+
+		GpuScope scope = t_Gpu.Open.back();
+		t_Gpu.Open.pop_back();
+		if (!scope.Begin)
+			return;
+
+		scope.End = t_Gpu.getQuery();
+		glQueryCounter(scope.End, GL_TIMESTAMP);
+		t_Gpu.Pending.push_back(scope);
+	}
+
+	void Profiler::CollectGpu() {
+		if (t_Gpu.Pending.empty())
+			return;
+
+		ProfilerData& data = getData();
+		if (!data.Gpu)
+			data.Gpu = registerThread("GPU");
+
+		// GPU timestamps to the CPU clock
+		GLint64 gpuNow = 0;
+		glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+		const int64_t offset = (int64_t)Now() - gpuNow;
+
+		while (!t_Gpu.Pending.empty()) {
+			GpuScope& scope = t_Gpu.Pending.front();
+
+			GLint available = GL_FALSE;
+			glGetQueryObjectiv(scope.End, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+				break;
+
+			GLuint64 begin = 0, end = 0;
+			glGetQueryObjectui64v(scope.Begin, GL_QUERY_RESULT, &begin);
+			glGetQueryObjectui64v(scope.End, GL_QUERY_RESULT, &end);
+
+			const int64_t start = (int64_t)begin + offset;
+			data.Gpu->push({ scope.Name, (uint64_t)std::max<int64_t>(start, 0), end > begin ? end - begin : 0, scope.Depth, data.Gpu->Index });
+
+			t_Gpu.FreeQueries.push_back(scope.Begin);
+			t_Gpu.FreeQueries.push_back(scope.End);
+			t_Gpu.Pending.pop_front();
+		}
+	}
+
+	GpuProfileScope::GpuProfileScope(const char* name) {
+		RenderCommandQueue::Submit([name]() { Profiler::BeginGpuScope(name); });
+	}
+
+	GpuProfileScope::~GpuProfileScope() {
+		RenderCommandQueue::Submit([]() { Profiler::EndGpuScope(); });
+	}
+
+	// =========================== EXPORT ===========================
+
+	static void writeJsonString(std::ofstream& file, const char* text) {
+		file << '"';
+		for (const char* c = text; *c; c++) {
+			switch (*c) {
+			case '"':	file << "\\\""; break;
+			case '\\':	file << "\\\\"; break;
+			case '\n':	file << "\\n"; break;
+			case '\t':	file << "\\t"; break;
+			default:
+				if ((unsigned char)*c >= 0x20)
+					file << *c;
+			}
+		}
+		file << '"';
+	}
+
+	bool Profiler::SaveChromeTrace(const std::string& path) {
+		ProfilerData& data = getData();
+
+		std::ofstream file(path);
+		if (!file) {
+			SHADO_CORE_ERROR("Could not open {0} for writing", path);
+			return false;
+		}
+
+		// Timestamps in microseconds
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+		bool first = true;
+		auto separator = [&]() {
+			if (!first)
+				file << ",\n";
+			first = false;
+		};
+
+		for (size_t i = 0; i < data.ThreadNames.size(); i++) {
+			separator();
+			file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << i << ",\"args\":{\"name\":";
+			writeJsonString(file, data.ThreadNames[i].c_str());
+			file << "}}";
+		}
+
+		file.precision(3);
+		file << std::fixed;
+		for (const ProfileFrame& frame : data.Frames) {
+			separator();
+			file << "{\"name\":\"Frame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"ts\":" << frame.End / 1000.0 << "}";
+
+			for (const ProfileEvent& event : frame.Events) {
+				separator();
+				file << "{\"name\":";
+				writeJsonString(file, event.Name);
+				file << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.Thread
+					<< ",\"ts\":" << event.Start / 1000.0 << ",\"dur\":" << event.Duration / 1000.0 << "}";
+			}
+		}
+
+		file << "\n]}\n";
+		return (bool)file;
+	}
+
+	template<typename T>
+	static void writeBinary(std::ofstream& file, T value) {
+		// Little endian hosts only, which is all the engine runs on
+		file.write((const char*)&value, sizeof(T));
+	}
+
+	static void writeBinaryString(std::ofstream& file, const char* text) {
+		const uint16_t length = (uint16_t)std::min<size_t>(std::strlen(text), UINT16_MAX);
+		writeBinary(file, length);
+		file.write(text, length);
+	}
+
+	bool Profiler::SaveBinary(const std::string& path) {
+		ProfilerData& data = getData();
+
+		std::ofstream file(path, std::ios::binary);
+		if (!file) {
+			SHADO_CORE_ERROR("Could not open {0} for writing", path);
+			return false;
+		}
+
+		file.write("SHPF", 4);
+		writeBinary<uint32_t>(file, 1);
+
+		writeBinary<uint32_t>(file, (uint32_t)data.ThreadNames.size());
+		for (const std::string& name : data.ThreadNames)
+			writeBinaryString(file, name.c_str());
+
+		// Names are literals, the same pointer means the same name
+		std::unordered_map<const char*, uint32_t> nameIndices;
+		std::vector<const char*> names;
+		for (const ProfileFrame& frame : data.Frames) {
+			for (const ProfileEvent& event : frame.Events) {
+				if (nameIndices.emplace(event.Name, (uint32_t)names.size()).second)
+					names.push_back(event.Name);
+			}
+		}
+
+		writeBinary<uint32_t>(file, (uint32_t)names.size());
+		for (const char* name : names)
+			writeBinaryString(file, name);
+
+		writeBinary<uint32_t>(file, (uint32_t)data.Frames.size());
+		for (const ProfileFrame& frame : data.Frames) {
+			writeBinary<uint64_t>(file, frame.Start);
+			writeBinary<uint64_t>(file, frame.End);
+			writeBinary<uint32_t>(file, (uint32_t)frame.Events.size());
+
+			for (const ProfileEvent& event : frame.Events) {
+				writeBinary<uint32_t>(file, nameIndices[event.Name]);
+				writeBinary<uint16_t>(file, event.Thread);
+				writeBinary<uint16_t>(file, event.Depth);
+				writeBinary<uint64_t>(file, event.Start);
+				writeBinary<uint64_t>(file, event.Duration);
+			}
+		}
+
+		return (bool)file;
+	}
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Profiling is compiled out of Dist builds, the macros then expand to nothing
+#ifndef SHADO_DIST
+#define SHADO_PROFILE 1
+#else
+#define SHADO_PROFILE 0
+#endif
+
+#define SHADO_PROFILE_CONCAT_IMPL(a, b) a##b
+#define SHADO_PROFILE_CONCAT(a, b) SHADO_PROFILE_CONCAT_IMPL(a, b)
+
+#if SHADO_PROFILE
+// `name` must outlive the profiler: a string literal or __FUNCTION__
+#define SHADO_PROFILE_SCOPE(name)		::Shado::ProfileScope SHADO_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define SHADO_PROFILE_FUNCTION()		SHADO_PROFILE_SCOPE(__FUNCTION__)
+// Times the GPU commands submitted in the scope, on the "GPU" thread of the trace. Can nest
+#define SHADO_PROFILE_GPU_SCOPE(name)	::Shado::GpuProfileScope SHADO_PROFILE_CONCAT(gpuProfileScope, __LINE__)(name)
+#define SHADO_PROFILE_THREAD(name)		::Shado::Profiler::SetThreadName(name)
+#define SHADO_PROFILE_FRAME()			::Shado::Profiler::EndFrame()
+#else
+#define SHADO_PROFILE_SCOPE(name)
+#define SHADO_PROFILE_FUNCTION()
+#define SHADO_PROFILE_GPU_SCOPE(name)
+#define SHADO_PROFILE_THREAD(name)
+#define SHADO_PROFILE_FRAME()
+#endif
+
+namespace Shado {
+
+	struct ProfileEvent {
+		const char* Name;
+		uint64_t Start;			// ns since the profiler started
+		uint64_t Duration;		// ns
+		uint16_t Depth;			// Nesting level in its thread
+		uint16_t Thread;		// Index in Profiler::GetThreadNames()
+	};
+
+	struct ProfileFrame {
+		uint64_t Start = 0, End = 0;
+		std::vector<ProfileEvent> Events;	// Those that ended during the frame, in any thread
+	};
+
+	/**
+	 * Records scopes in a buffer per thread: a single producer/single consumer ring, the thread writes and
+	 * EndFrame reads, neither locks. A full ring drops events rather than wait.
+	 * EndFrame gathers them once per frame (from the main thread) into a history of the last frames,
+	 * which the ImGui panel shows and which can be saved as a Chrome trace (chrome://tracing, Perfetto)
+	 * or in a compact binary form.
+	 *
+	 * GPU scopes use GL_TIMESTAMP queries, read back a few frames later without waiting on the GPU and
+	 * shifted to the CPU clock.
+	 */
+	class Profiler {
+	public:
+		static uint64_t Now();
+
+		static void SetThreadName(const std::string& name);
+
+		// Main thread, once per frame
+		static void EndFrame();
+
+		// While paused the history doesn't move, events are still gathered and thrown away
+		static void SetPaused(bool paused);
+		static bool IsPaused();
+
+		static void SetHistorySize(uint32_t frames);
+		// Oldest first
+		static const std::vector<ProfileFrame>& GetFrames();
+		static const std::vector<std::string>& GetThreadNames();
+		static uint64_t GetDroppedEventCount();
+
+		// Save the frames of the history
+		static bool SaveChromeTrace(const std::string& path);
+		/**
+		 * Little endian:
+		 *   "SHPF", u32 version
+		 *   u32 thread count, then per thread: u16 length, name
+		 *   u32 name count, then per name: u16 length, name
+		 *   u32 frame count, then per frame: u64 start, u64 end, u32 event count, then per event:
+		 *     u32 name index, u16 thread, u16 depth, u64 start, u64 duration
+		 */
+		static bool SaveBinary(const std::string& path);
+
+		// Called by the scopes
+		static void BeginScope();
+		static void EndScope(const char* name, uint64_t start);
+		static void BeginGpuScope(const char* name);
+		static void EndGpuScope();
+
+	private:
+		static void CollectGpu();
+	};
+
+	class ProfileScope {
+	public:
+		ProfileScope(const char* name)
+			: m_Name(name), m_Start(Profiler::Now())
+		{
+			Profiler::BeginScope();
+		}
+
+		~ProfileScope() {
+			Profiler::EndScope(m_Name, m_Start);
+		}
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+
+	private:
+		const char* m_Name;
+		uint64_t m_Start;
+	};
+
+	// The queries go through RenderCommandQueue, in order with what the scope draws
+	class GpuProfileScope {
+	public:
+		GpuProfileScope(const char* name);
+		~GpuProfileScope();
+
+		GpuProfileScope(const GpuProfileScope&) = delete;
+		GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+	};
+}
+
+#endif
@@ -0,0 +1,278 @@
+#include "RenderCommandQueue.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include "GL/glew.h"
+#include <GLFW/glfw3.h>
+#include "Debug.h"
+#include "Profiler.h"
+#include "RenderState.h"
+
+namespace Shado {
+
+	// =========================== COMMAND LIST ===========================
+
+	RenderCommandList::~RenderCommandList() {
+		reset();
+	}
+
+	void* RenderCommandList::allocate(size_t size, size_t alignment) {
+		auto alignUp = [](uintptr_t value, size_t alignment) {
+			return (value + alignment - 1) & ~(uintptr_t)(alignment - 1);
+		};
+
+		if (!m_Chunks.empty()) {
+			Chunk& chunk = m_Chunks.back();
+			uintptr_t base = (uintptr_t)chunk.data.get();
+			uintptr_t offset = alignUp(base + chunk.used, alignment) - base;
+
+			if (offset + size <= chunk.size) {
+				chunk.used = offset + size;
+				return chunk.data.get() + offset;
+			}
+		}
+
+		// Start a new chunk, reusing a previous frame's one if it is big enough
+		const size_t needed = size + alignment;
+		Chunk chunk;
+		for (size_t i = 0; i < m_FreeChunks.size(); i++) {
+			if (m_FreeChunks[i].size >= needed) {
+				chunk = std::move(m_FreeChunks[i]);
+				m_FreeChunks.erase(m_FreeChunks.begin() + i);
+				break;
+			}
+		}
+
+		if (!chunk.data) {
+			chunk.size = needed > ChunkSize ? needed : ChunkSize;
+			chunk.data.reset(new uint8_t[chunk.size]);
+		}
+
+		uintptr_t base = (uintptr_t)chunk.data.get();
+		uintptr_t offset = alignUp(base, alignment) - base;
+		chunk.used = offset + size;
+
+		m_Chunks.push_back(std::move(chunk));
+		return m_Chunks.back().data.get() + offset;
+	}
+
+	const void* RenderCommandList::copy(const void* data, size_t size) {
+		void* storage = allocate(size);
+		memcpy(storage, data, size);
+		return storage;
+	}
+
+	void RenderCommandList::execute() {
+		for (const Command& command : m_Commands)
+			command.execute(command.fn);
+	}
+
+	void RenderCommandList::reset() {
+		// Destructors of captured resources may submit their deletion, which lands in this list
+		// again. Detach everything first so these new commands survive
+		std::vector<Command> commands;
+		std::vector<Chunk> chunks;
+		commands.swap(m_Commands);
+		chunks.swap(m_Chunks);
+
+		for (const Command& command : commands)
+			command.destroy(command.fn);
+
+		for (Chunk& chunk : chunks) {
+			chunk.used = 0;
+			m_FreeChunks.push_back(std::move(chunk));
+		}
+
+		// Keep the capacity around if nothing was recorded meanwhile
+		if (m_Commands.empty()) {
+			commands.clear();
+			m_Commands.swap(commands);
+		}
+	}
+
+	size_t RenderCommandList::getUsedBytes() const {
+		size_t used = 0;
+		for (const Chunk& chunk : m_Chunks)
+			used += chunk.used;
+		return used;
+	}
+
+	// =========================== COMMAND QUEUE ===========================
+
+	struct RenderQueueData {
+		RenderCommandList Lists[2];
+		uint32_t Recording = 0;
+
+		std::thread Thread;
+		std::mutex Mutex;
+		std::condition_variable Condition;
+
+		RenderCommandList* Pending = nullptr;	// Published, not picked up yet
+		GLsync PendingFence = nullptr;
+		bool Busy = false;
+		bool Stop = false;
+
+		GLFWwindow* Window = nullptr;
+		GLFWwindow* SharedContext = nullptr;
+		std::atomic<bool> Threaded = { false };
+
+		RenderCommandQueue::Statistics Stats;
+	};
+
+	static RenderQueueData s_Queue;
+	static thread_local bool s_IsRenderThread = false;
+
+	using Clock = std::chrono::steady_clock;
+
+	static float millisecondsSince(Clock::time_point start) {
+		return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+	}
+
+	static void renderThreadMain() {
+		s_IsRenderThread = true;
+		glfwMakeContextCurrent(s_Queue.Window);
+		SHADO_PROFILE_THREAD("Render");
+
+		while (true) {
+			RenderCommandList* list;
+			GLsync fence;
+			{
+				std::unique_lock<std::mutex> lock(s_Queue.Mutex);
+				s_Queue.Condition.wait(lock, [] { return s_Queue.Pending || s_Queue.Stop; });
+
+				if (!s_Queue.Pending)
+					break;
+
+				list = s_Queue.Pending;
+				fence = s_Queue.PendingFence;
+				s_Queue.Pending = nullptr;
+				s_Queue.Busy = true;
+			}
+
+			// Objects created or uploaded by the main thread's context must be complete first
+			if (fence) {
+				glWaitSync(fence, 0, GL_TIMEOUT_IGNORED);
+				glDeleteSync(fence);
+			}
+
+			auto start = Clock::now();
+			{
+				SHADO_PROFILE_SCOPE("RenderCommandList::execute");
+				list->execute();
+			}
+			float executeTime = millisecondsSince(start);
+
+			start = Clock::now();
+			{
+				SHADO_PROFILE_SCOPE("glfwSwapBuffers");
+				glfwSwapBuffers(s_Queue.Window);
+			}
+			float swapTime = millisecondsSince(start);
+
+			{
+				std::lock_guard<std::mutex> lock(s_Queue.Mutex);
+				s_Queue.Stats.CommandCount = list->getCommandCount();
+				s_Queue.Stats.CommandBytes = list->getUsedBytes();
+				s_Queue.Stats.ExecuteTime = executeTime;
+				s_Queue.Stats.SwapTime = swapTime;
+				s_Queue.Busy = false;
+			}
+			s_Queue.Condition.notify_all();
+		}
+
+		glfwMakeContextCurrent(nullptr);
+	}
+
+	const void* RenderCommandQueue::Copy(const void* data, size_t size) {
+		if (RenderCommandList* list = GetRecordingList())
+			return list->copy(data, size);
+		return data;
+	}
+
+	void RenderCommandQueue::StartRenderThread(GLFWwindow* window, GLFWwindow* sharedContext) {
+		SHADO_CORE_ASSERT(!s_Queue.Threaded, "Render thread is already running!");
+
+		s_Queue.Window = window;
+		s_Queue.SharedContext = sharedContext;
+		s_Queue.Stop = false;
+
+		// Hand the window's context over, the main thread keeps working on the shared one
+		glfwMakeContextCurrent(sharedContext);
+		RenderState::Invalidate();
+
+		s_Queue.Threaded = true;
+		s_Queue.Thread = std::thread(renderThreadMain);
+	}
+
+	void RenderCommandQueue::StopRenderThread() {
+		if (!s_Queue.Threaded)
+			return;
+
+		// Whatever was recorded since the last frame (deletions mostly) still has to run
+		EndFrame();
+
+		{
+			std::lock_guard<std::mutex> lock(s_Queue.Mutex);
+			s_Queue.Stop = true;
+		}
+		s_Queue.Condition.notify_all();
+		s_Queue.Thread.join();
+
+		glfwMakeContextCurrent(s_Queue.Window);
+		RenderState::Invalidate();
+		s_Queue.Threaded = false;
+
+		// Both lists were replayed, this releases what they captured with the window's context current
+		s_Queue.Lists[0].reset();
+		s_Queue.Lists[1].reset();
+	}
+
+	void RenderCommandQueue::EndFrame() {
+		if (!s_Queue.Threaded)
+			return;
+
+		RenderCommandList* list = &s_Queue.Lists[s_Queue.Recording];
+
+		GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glFlush();
+
+		auto start = Clock::now();
+		{
+			std::unique_lock<std::mutex> lock(s_Queue.Mutex);
+			s_Queue.Condition.wait(lock, [] { return !s_Queue.Pending && !s_Queue.Busy; });
+			s_Queue.Stats.WaitTime = millisecondsSince(start);
+
+			s_Queue.Pending = list;
+			s_Queue.PendingFence = fence;
+		}
+		s_Queue.Condition.notify_all();
+
+		// The other list holds the frame before, which is done. Its captures are released here so
+		// destructors run on the main thread, as they would without the render thread
+		s_Queue.Recording ^= 1;
+		s_Queue.Lists[s_Queue.Recording].reset();
+	}
+
+	bool RenderCommandQueue::IsThreaded() {
+		return s_Queue.Threaded;
+	}
+
+	bool RenderCommandQueue::IsRenderThread() {
+		return s_IsRenderThread;
+	}
+
+	RenderCommandQueue::Statistics RenderCommandQueue::GetStats() {
+		std::lock_guard<std::mutex> lock(s_Queue.Mutex);
+		return s_Queue.Stats;
+	}
+
+	RenderCommandList* RenderCommandQueue::GetRecordingList() {
+		if (!s_Queue.Threaded || s_IsRenderThread)
+			return nullptr;
+		return &s_Queue.Lists[s_Queue.Recording];
+	}
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#ifndef RENDER_COMMAND_QUEUE_H
+#define RENDER_COMMAND_QUEUE_H
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+struct GLFWwindow;
+
+namespace Shado {
+
+	/**
+	 * Recorded frame of GL work. Commands are type erased callables placed in a linear arena,
+	 * the arena also holds the data they read (vertices, uniforms...) so the recording side can
+	 * reuse its own buffers right away.
+	 */
+	class RenderCommandList {
+	public:
+		RenderCommandList() = default;
+		~RenderCommandList();
+
+		RenderCommandList(const RenderCommandList&) = delete;
+		RenderCommandList& operator=(const RenderCommandList&) = delete;
+
+		template<typename F>
+		void record(F&& command) {
+			using Fn = typename std::decay<F>::type;
+
+			void* storage = allocate(sizeof(Fn), alignof(Fn));
+			new (storage) Fn(std::forward<F>(command));
+
+			m_Commands.push_back({
+				[](void* fn) { (*(Fn*)fn)(); },
+				[](void* fn) { ((Fn*)fn)->~Fn(); },
+				storage
+			});
+		}
+
+		// Raw storage living until the list is reset
+		void* allocate(size_t size, size_t alignment = 16);
+		const void* copy(const void* data, size_t size);
+
+		void execute();
+
+		// Destroys the recorded commands (and what they captured), the memory is kept for the next frame
+		void reset();
+
+		uint32_t getCommandCount() const { return (uint32_t)m_Commands.size(); }
+		size_t getUsedBytes() const;
+
+	private:
+		struct Command {
+			void (*execute)(void*);
+			void (*destroy)(void*);
+			void* fn;
+		};
+
+		struct Chunk {
+			std::unique_ptr<uint8_t[]> data;
+			size_t size = 0;
+			size_t used = 0;
+		};
+
+		static constexpr size_t ChunkSize = 256 * 1024;
+
+		std::vector<Command> m_Commands;
+		std::vector<Chunk> m_Chunks;		// The last one is being filled
+		std::vector<Chunk> m_FreeChunks;
+	};
+
+	/**
+	 * Optional render thread.
+	 *
+	 * Once started, the window's GL context belongs to the render thread and the main thread keeps a
+	 * hidden context sharing its objects. Everything that must run on the window's context (draws,
+	 * bindings, state changes, deletions) goes through Submit: the command is recorded for frame N+1
+	 * while the render thread replays frame N, then EndFrame hands the list over.
+	 * When the render thread isn't running, or when called from it, Submit runs the command right away.
+	 *
+	 * Creating buffers, textures and shaders from the main thread is fine. Modifying one that
+	 * the in-flight frame uses is not, nor is reconfiguring a vertex array after it was first drawn.
+	 */
+	class RenderCommandQueue {
+	public:
+		template<typename F>
+		static void Submit(F&& command) {
+			if (RenderCommandList* list = GetRecordingList())
+				list->record(std::forward<F>(command));
+			else
+				command();
+		}
+
+		// Copy of `data` readable by submitted commands. Returns `data` itself when commands run immediately
+		static const void* Copy(const void* data, size_t size);
+
+		static void StartRenderThread(GLFWwindow* window, GLFWwindow* sharedContext);
+		// Replays what is left, waits for the thread and gives the window's context back to the caller
+		static void StopRenderThread();
+
+		// Publishes the recorded frame to the render thread, which swaps the window's buffers after
+		// replaying it. Blocks while the previous frame is still being rendered
+		static void EndFrame();
+
+		static bool IsThreaded();
+		static bool IsRenderThread();
+
+		struct Statistics {
+			uint32_t CommandCount = 0;
+			uint64_t CommandBytes = 0;
+			float WaitTime = 0.0f;		// Main thread blocked on the render thread, in ms
+			float ExecuteTime = 0.0f;	// Replaying the commands, in ms
+			float SwapTime = 0.0f;		// glfwSwapBuffers, in ms
+		};
+		// Last frame the render thread finished
+		static Statistics GetStats();
+
+	private:
+		static RenderCommandList* GetRecordingList();
+	};
+}
+
+#endif
@@ -0,0 +1,106 @@
+#include "RenderState.h"
+
+#include "GL/glew.h"
+#include "Stats.h"
+
+namespace Shado {
+
+	// Never a valid GL name, forces the next bind through
+	static constexpr uint32_t UNKNOWN = 0xFFFFFFFF;
+
+	struct RenderStateData {
+		uint32_t VertexArray = UNKNOWN;
+		uint32_t Program = UNKNOWN;
+		uint32_t Textures[RenderState::MaxTextureUnits];
+
+		RenderState::Statistics Stats;
+
+		RenderStateData() {
+			for (auto& texture : Textures)
+				texture = UNKNOWN;
+		}
+	};
+
+	// One shadow per thread, a thread has at most one context current (see RenderCommandQueue)
+	static thread_local RenderStateData s_State;
+
+	// Binds that reached GL, from every thread. The skipped ones stay in the per thread Statistics
+	struct RenderStateStats {
+		StatHandle VertexArrayBinds = Stats::Register("RenderState.VertexArrayBinds");
+		StatHandle ShaderSwitches = Stats::Register("RenderState.ShaderSwitches");
+		StatHandle TextureBinds = Stats::Register("RenderState.TextureBinds");
+	};
+	static RenderStateStats s_Stats;
+
+	void RenderState::BindVertexArray(uint32_t vertexArray) {
+		if (s_State.VertexArray == vertexArray) {
+			s_State.Stats.VertexArrayBindsSkipped++;
+			return;
+		}
+
+		glBindVertexArray(vertexArray);
+		s_State.VertexArray = vertexArray;
+		s_State.Stats.VertexArrayBinds++;
+		Stats::Add(s_Stats.VertexArrayBinds);
+	}
+
+	void RenderState::UseProgram(uint32_t program) {
+		if (s_State.Program == program) {
+			s_State.Stats.ProgramBindsSkipped++;
+			return;
+		}
+
+		glUseProgram(program);
+		s_State.Program = program;
+		s_State.Stats.ProgramBinds++;
+		Stats::Add(s_Stats.ShaderSwitches);
+	}
+
+	void RenderState::BindTextureUnit(uint32_t unit, uint32_t texture) {
+		if (unit < MaxTextureUnits) {
+			if (s_State.Textures[unit] == texture) {
+				s_State.Stats.TextureBindsSkipped++;
+				return;
+			}
+			s_State.Textures[unit] = texture;
+		}
+
+		glBindTextureUnit(unit, texture);
+		s_State.Stats.TextureBinds++;
+		Stats::Add(s_Stats.TextureBinds);
+	}
+
+	void RenderState::Invalidate() {
+		s_State.VertexArray = UNKNOWN;
+		s_State.Program = UNKNOWN;
+		for (auto& texture : s_State.Textures)
+			texture = UNKNOWN;
+	}
+
+	void RenderState::OnVertexArrayDeleted(uint32_t vertexArray) {
+		// Deleting the bound VAO reverts the binding to 0
+		if (s_State.VertexArray == vertexArray)
+			s_State.VertexArray = 0;
+	}
+
+	void RenderState::OnProgramDeleted(uint32_t program) {
+		// A deleted program stays in use until another one is, the name can't be trusted anymore
+		if (s_State.Program == program)
+			s_State.Program = UNKNOWN;
+	}
+
+	void RenderState::OnTextureDeleted(uint32_t texture) {
+		// Deleting a texture unbinds it from every unit
+		for (auto& bound : s_State.Textures)
+			if (bound == texture)
+				bound = 0;
+	}
+
+	void RenderState::ResetStats() {
+		s_State.Stats = Statistics();
+	}
+
+	RenderState::Statistics RenderState::GetStats() {
+		return s_State.Stats;
+	}
+}
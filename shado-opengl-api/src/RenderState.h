@@ -0,0 +1,46 @@
+#pragma once
+
+#ifndef RENDER_STATE_H
+#define RENDER_STATE_H
+
+#include <cstdint>
+
+namespace Shado {
+
+	/**
+	 * Shadow copy of the GL binding state, redundant binds are skipped.
+	 *
+	 * Everything in the engine binds through here. Code that talks to GL directly (ImGui's backend,
+	 * raw GL in client code) must call Invalidate() afterwards so the cache doesn't lie.
+	 * The cache and the stats are per thread, like GL contexts.
+	 */
+	class RenderState {
+	public:
+		static constexpr uint32_t MaxTextureUnits = 32;
+
+		static void BindVertexArray(uint32_t vertexArray);
+		static void UseProgram(uint32_t program);
+		static void BindTextureUnit(uint32_t unit, uint32_t texture);
+
+		// Forget the cached state, the next bind of every kind goes through
+		static void Invalidate();
+
+		// GL unbinds (or keeps using) deleted objects, and their names can be recycled
+		static void OnVertexArrayDeleted(uint32_t vertexArray);
+		static void OnProgramDeleted(uint32_t program);
+		static void OnTextureDeleted(uint32_t texture);
+
+		struct Statistics {
+			uint32_t VertexArrayBinds = 0;
+			uint32_t VertexArrayBindsSkipped = 0;
+			uint32_t ProgramBinds = 0;
+			uint32_t ProgramBindsSkipped = 0;
+			uint32_t TextureBinds = 0;
+			uint32_t TextureBindsSkipped = 0;
+		};
+		static void ResetStats();
+		static Statistics GetStats();
+	};
+}
+
+#endif
@@ -2,49 +2,59 @@
 #include "Renderer2D.h"
 #include <GL/glew.h>
 #include "Buffer.h"
+#include "GpuBufferArena.h"
 #include "Debug.h"
 #include <glm/glm.hpp>
 #include <glm/gtx/transform.hpp>
+#include <glm/gtc/packing.hpp>
 #include "cameras/OrbitCamera.h"
 #include "VertexArray.h"
+#include "Profiler.h"
+#include "RenderCommandQueue.h"
+#include "Stats.h"
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define SHADO_RENDERER2D_SSE 1
+	#include <emmintrin.h>
+#else
+	#define SHADO_RENDERER2D_SSE 0
+#endif
 
 
 namespace Shado {
 
-	struct QuadVertex
-	{
-		glm::vec3 Position;
-		glm::vec4 Color;
-		glm::vec2 TexCoord;
-		float TexIndex;
-		float TilingFactor;
-	};
+	using QuadVertex = Renderer2D::QuadVertex;
+	static_assert(sizeof(QuadVertex) == 24, "QuadVertex must match its buffer layout");
 
 	struct LineVertex
 	{
 		glm::vec3 Position;
-		glm::vec4 Color;
+		uint32_t Color;			// UByte4Norm
 	};
+	static_assert(sizeof(LineVertex) == 16, "LineVertex must match its buffer layout");
 
 	struct CircleVertex {
 		glm::vec3 WorldPosition;
-		glm::vec3 LocalPosition;
-		glm::vec4 Color;		
-		float Thickness;
-		float Fade;
+		uint32_t LocalPosition;	// Half2
+		uint32_t Color;			// UByte4Norm
+		uint16_t Thickness;		// Half
+		uint16_t Fade;			// Half
 	};
+	static_assert(sizeof(CircleVertex) == 24, "CircleVertex must match its buffer layout");
 	
 	struct Renderer2DData
 	{
-		static const uint32_t MaxQuads = 20000;
+		static const uint32_t MaxQuads = IndexBuffer::MaxQuads16;	// Keeps the shared quad indices 16 bits
 		static const uint32_t MaxVertices = MaxQuads * 4;
 		static const uint32_t MaxIndices = MaxQuads * 6;
 		static const uint32_t MaxTextureSlots = 32; // TODO: RenderCaps
 
 		static const uint32_t MaxLines = 10000;
 		static const uint32_t MaxLineVertices = MaxLines * 2;
-		static const uint32_t MaxLineIndices = MaxLines * 6;
 
 		// ===============================
 		glm::mat4 CameraViewProj;
@@ -61,8 +71,11 @@ namespace Shado {
 
 		std::array<Ref<Texture2D>, MaxTextureSlots> TextureSlots;
 		uint32_t TextureSlotIndex = 1; // 0 = white texture
+		uint32_t BatchIndex = 0;		// Bumped on every flush, slots found before are stale
 
 		glm::vec4 QuadVertexPositions[4];
+		uint32_t QuadTexCoords[4];			// Packed as Half2
+		uint32_t CircleLocalPositions[4];	// Packed as Half2
 
 		// Circles
 		Ref<VertexArray> CircleVertexArray;
@@ -76,11 +89,10 @@ namespace Shado {
 		// Lines
 		Ref<VertexArray> LineVertexArray;
 		Ref<VertexBuffer> LineVertexBuffer;
-		Ref<IndexBuffer> LineIndexBuffer;
 
 		Ref<Shader> LineShader;
 
-		uint32_t LineIndexCount = 0;
+		uint32_t LineVertexCount = 0;
 		LineVertex* LineVertexBufferBase = nullptr;
 		LineVertex* LineVertexBufferPtr = nullptr;
 
@@ -91,6 +103,25 @@ namespace Shado {
 
 	static Renderer2DData s_Data;
 
+	// Per frame, in the engine-wide Stats. Counted per batch, Renderer2D::Statistics counts per primitive
+	struct Renderer2DStats {
+		StatHandle DrawCalls = Stats::Register("Renderer2D.DrawCalls");
+		StatHandle Quads = Stats::Register("Renderer2D.Quads");
+		StatHandle Circles = Stats::Register("Renderer2D.Circles");
+		StatHandle Lines = Stats::Register("Renderer2D.Lines");
+		StatHandle Vertices = Stats::Register("Renderer2D.Vertices");
+		StatHandle Indices = Stats::Register("Renderer2D.Indices");
+		StatHandle TextureBinds = Stats::Register("Renderer2D.TextureBinds");
+		StatHandle BytesUploaded = Stats::Register("Renderer2D.BytesUploaded", StatKind::PerFrame, StatUnit::Bytes);
+		StatHandle CachedQuads = Stats::Register("Renderer2D.CachedQuads");	// Drawn from a QuadCache, not uploaded
+
+		// Why batches were cut short. Each one costs a draw call
+		StatHandle FlushBufferFull = Stats::Register("Renderer2D.FlushBufferFull");
+		StatHandle FlushTextureSlotsFull = Stats::Register("Renderer2D.FlushTextureSlotsFull");
+		StatHandle FlushLineBufferFull = Stats::Register("Renderer2D.FlushLineBufferFull");
+	};
+	static Renderer2DStats s_Stats;
+
 	bool Renderer2D::s_Init = false;
 
 	void Renderer2D::Init()
@@ -98,41 +129,19 @@ namespace Shado {
 		glEnable(GL_BLEND);
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 		glEnable(GL_DEPTH_TEST);
+		glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
 
 		// Rectangles
 		s_Data.QuadVertexArray = VertexArray::create();
 
 		s_Data.QuadVertexBuffer = VertexBuffer::create(s_Data.MaxVertices * sizeof(QuadVertex));
-		s_Data.QuadVertexBuffer->setLayout({
-			{ ShaderDataType::Float3, "a_Position" },
-			{ ShaderDataType::Float4, "a_Color" },
-			{ ShaderDataType::Float2, "a_TexCoord" },
-			{ ShaderDataType::Float, "a_TexIndex" },
-			{ ShaderDataType::Float, "a_TilingFactor" }
-			});
+		s_Data.QuadVertexBuffer->setLayout(GetQuadVertexLayout());
 		s_Data.QuadVertexArray->addVertexBuffer(s_Data.QuadVertexBuffer);
 
 		s_Data.QuadVertexBufferBase = new QuadVertex[s_Data.MaxVertices];
 
-		uint32_t* quadIndices = new uint32_t[s_Data.MaxIndices];
-
-		uint32_t offset = 0;
-		for (uint32_t i = 0; i < s_Data.MaxIndices; i += 6)
-		{
-			quadIndices[i + 0] = offset + 0;
-			quadIndices[i + 1] = offset + 1;
-			quadIndices[i + 2] = offset + 2;
-
-			quadIndices[i + 3] = offset + 2;
-			quadIndices[i + 4] = offset + 3;
-			quadIndices[i + 5] = offset + 0;
-
-			offset += 4;
-		}
-
-		Ref<IndexBuffer> quadIB = IndexBuffer::create(quadIndices, s_Data.MaxIndices);
+		Ref<IndexBuffer> quadIB = IndexBuffer::getQuadIndexBuffer();
 		s_Data.QuadVertexArray->setIndexBuffer(quadIB);
-		delete[] quadIndices;
 
 		// Circles
 		s_Data.CircleVertexArray = VertexArray::create();
@@ -140,10 +149,10 @@ namespace Shado {
 		s_Data.CircleVertexBuffer = VertexBuffer::create(s_Data.MaxVertices * sizeof(CircleVertex));
 		s_Data.CircleVertexBuffer->setLayout({
 			{ ShaderDataType::Float3, "a_WorldPosition" },
-			{ ShaderDataType::Float3, "a_LocalPosition" },
-			{ ShaderDataType::Float4, "a_Color" },
-			{ ShaderDataType::Float, "a_Thickness" },
-			{ ShaderDataType::Float, "a_Fade" }
+			{ ShaderDataType::Half2, "a_LocalPosition" },
+			{ ShaderDataType::UByte4Norm, "a_Color" },
+			{ ShaderDataType::Half, "a_Thickness" },
+			{ ShaderDataType::Half, "a_Fade" }
 			});
 		s_Data.CircleVertexArray->addVertexBuffer(s_Data.CircleVertexBuffer);
 		s_Data.CircleVertexArray->setIndexBuffer(quadIB);	// Use quad Index Buffer
@@ -174,6 +183,12 @@ namespace Shado {
 		s_Data.QuadVertexPositions[2] = { 0.5f,  0.5f, 0.0f, 1.0f };
 		s_Data.QuadVertexPositions[3] = { -0.5f,  0.5f, 0.0f, 1.0f };
 
+		constexpr glm::vec2 textureCoords[] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+		for (int i = 0; i < 4; i++) {
+			s_Data.QuadTexCoords[i] = glm::packHalf2x16(textureCoords[i]);
+			s_Data.CircleLocalPositions[i] = glm::packHalf2x16(glm::vec2(s_Data.QuadVertexPositions[i]) * 2.0f);
+		}
+
 
 		// Lines
 		{
@@ -182,28 +197,44 @@ namespace Shado {
 			s_Data.LineVertexBuffer = std::make_shared<VertexBuffer>(s_Data.MaxLineVertices * sizeof(LineVertex));
 			s_Data.LineVertexBuffer->setLayout({
 				{ ShaderDataType::Float3, "a_Position" },
-				{ ShaderDataType::Float4, "a_Color" }
+				{ ShaderDataType::UByte4Norm, "a_Color" }
 				});
 
 			s_Data.LineVertexBufferBase = new LineVertex[s_Data.MaxLineVertices];
 
-			uint32_t* lineIndices = new uint32_t[s_Data.MaxLineIndices];
-			for (uint32_t i = 0; i < s_Data.MaxLineIndices; i++)
-				lineIndices[i] = i;
-
-			s_Data.LineIndexBuffer = std::make_shared<IndexBuffer>(lineIndices, s_Data.MaxLineIndices);
-
+			// Lines are drawn straight from the vertices, no index buffer needed
 			s_Data.LineVertexArray = std::make_shared<VertexArray>();
 			s_Data.LineVertexArray->addVertexBuffer(s_Data.LineVertexBuffer);
-			s_Data.LineVertexArray->setIndexBuffer(s_Data.LineIndexBuffer);
-
-			delete[] lineIndices;
 		}
 
 
 		s_Init = true;
 	}
 
+	const BufferLayout& Renderer2D::GetQuadVertexLayout()
+	{
+		static const BufferLayout layout = {
+			{ ShaderDataType::Float3, "a_Position" },
+			{ ShaderDataType::UByte4Norm, "a_Color" },
+			{ ShaderDataType::Half2, "a_TexCoord" },
+			{ ShaderDataType::UShort, "a_TexIndex" },
+			{ ShaderDataType::Half, "a_TilingFactor" }
+		};
+		return layout;
+	}
+
+	const BufferLayout& Renderer2D::GetTileVertexLayout()
+	{
+		static const BufferLayout layout = {
+			{ ShaderDataType::Float3, "a_Position" },
+			{ ShaderDataType::UByte4Norm, "a_Color" },
+			{ ShaderDataType::Float2, "a_TexCoord" },
+			{ ShaderDataType::UShort, "a_TexIndex" },
+			{ ShaderDataType::Half, "a_TilingFactor" }
+		};
+		return layout;
+	}
+
 	void Renderer2D::Shutdown()
 	{
 		delete[] s_Data.QuadVertexBufferBase;
@@ -211,15 +242,12 @@ namespace Shado {
 
 	void Renderer2D::BeginScene(const Camera& camera)
 	{
-		s_Data.TextureShader->bind();
-		s_Data.TextureShader->setMat4("u_ViewProjection", camera.getViewProjectionMatrix());
-
 		s_Data.CameraViewProj = camera.getViewProjectionMatrix();
 
 		s_Data.QuadIndexCount = 0;
 		s_Data.QuadVertexBufferPtr = s_Data.QuadVertexBufferBase;
 
-		s_Data.LineIndexCount = 0;
+		s_Data.LineVertexCount = 0;
 		s_Data.LineVertexBufferPtr = s_Data.LineVertexBufferBase;
 
 		s_Data.CircleIndexCount = 0;
@@ -249,6 +277,8 @@ namespace Shado {
 
 	void Renderer2D::EndScene()
 	{
+		SHADO_PROFILE_FUNCTION();
+
 #if 0
 		uint32_t dataSize = (uint32_t)((uint8_t*)s_Data.QuadVertexBufferPtr - (uint8_t*)s_Data.QuadVertexBufferBase);
 		s_Data.QuadVertexBuffer->setData(s_Data.QuadVertexBufferBase, dataSize);
@@ -256,52 +286,68 @@ namespace Shado {
 		Flush();
 #endif
 
+		// Batches are recorded with a copy of their vertices and textures, the CPU side buffers are
+		// refilled right away while the render thread (if any) draws them
+		const glm::mat4 viewProj = s_Data.CameraViewProj;
+
 		uint32_t dataSize = (uint8_t*)s_Data.QuadVertexBufferPtr - (uint8_t*)s_Data.QuadVertexBufferBase;
 		if (dataSize)
 		{
-			s_Data.QuadVertexBuffer->setData(s_Data.QuadVertexBufferBase, dataSize);
+			const void* vertices = RenderCommandQueue::Copy(s_Data.QuadVertexBufferBase, dataSize);
+			const uint32_t indexCount = s_Data.QuadIndexCount;
+			const uint32_t textureCount = s_Data.TextureSlotIndex;
+			std::array<Ref<Texture2D>, Renderer2DData::MaxTextureSlots> textures;
+			for (uint32_t i = 0; i < textureCount; i++)
+				textures[i] = s_Data.TextureSlots[i];
 
-			s_Data.TextureShader->bind();
-			s_Data.TextureShader->setMat4("u_ViewProjection", s_Data.CameraViewProj);
+			RenderCommandQueue::Submit([vertices, dataSize, indexCount, textureCount, textures, viewProj]() {
+				s_Data.QuadVertexBuffer->setData(vertices, dataSize);
 
-			for (uint32_t i = 0; i < s_Data.TextureSlotIndex; i++)
-				s_Data.TextureSlots[i]->bind(i);
+				s_Data.TextureShader->bind();
+				s_Data.TextureShader->setMat4("u_ViewProjection", viewProj);
 
-			s_Data.QuadVertexArray->bind();
-			s_Data.QuadVertexArray->getIndexBuffers()->bind();
-			
-			CmdDrawIndexed(s_Data.QuadVertexArray, s_Data.QuadIndexCount);
-			s_Data.Stats.DrawCalls++;
-		}
+				for (uint32_t i = 0; i < textureCount; i++)
+					textures[i]->bind(i);
 
-		dataSize = (uint8_t*)s_Data.LineVertexBufferPtr - (uint8_t*)s_Data.LineVertexBufferBase;
-		if (dataSize)
-		{
-			s_Data.LineVertexBuffer->setData(s_Data.LineVertexBufferBase, dataSize);
-
-			s_Data.LineShader->bind();
-			s_Data.LineShader->setMat4("u_ViewProjection", s_Data.CameraViewProj);
+				s_Data.QuadVertexArray->bind();
 
-			s_Data.LineVertexArray->bind();
-			s_Data.LineIndexBuffer->bind();
-			SetLineThickness(2.0f);
-			CmdDrawIndexedLine(s_Data.LineVertexArray, s_Data.LineIndexCount);
+				CmdDrawIndexed(s_Data.QuadVertexArray, indexCount);
+			});
 			s_Data.Stats.DrawCalls++;
+
+			Stats::Add(s_Stats.DrawCalls);
+			Stats::Add(s_Stats.Quads, indexCount / 6);
+			Stats::Add(s_Stats.Vertices, indexCount / 6 * 4);
+			Stats::Add(s_Stats.Indices, indexCount);
+			Stats::Add(s_Stats.TextureBinds, textureCount);
+			Stats::Add(s_Stats.BytesUploaded, dataSize);
 		}
 
+		FlushAndResetLines();
+
 
 		if (s_Data.CircleIndexCount) {
 			uint32_t dataSize = (uint8_t*)s_Data.CircleVertexBufferPtr - (uint8_t*)s_Data.CircleVertexBufferBase;
-			s_Data.CircleVertexBuffer->setData(s_Data.CircleVertexBufferBase, dataSize);
+			const void* vertices = RenderCommandQueue::Copy(s_Data.CircleVertexBufferBase, dataSize);
+			const uint32_t indexCount = s_Data.CircleIndexCount;
 
-			s_Data.CircleShader->bind();
-			s_Data.CircleShader->setMat4("u_ViewProjection", s_Data.CameraViewProj);
-			
-			s_Data.CircleVertexArray->bind();
-			s_Data.CircleVertexArray->getIndexBuffers()->bind();
-			
-			CmdDrawIndexed(s_Data.CircleVertexArray, s_Data.CircleIndexCount);
+			RenderCommandQueue::Submit([vertices, dataSize, indexCount, viewProj]() {
+				s_Data.CircleVertexBuffer->setData(vertices, dataSize);
+
+				s_Data.CircleShader->bind();
+				s_Data.CircleShader->setMat4("u_ViewProjection", viewProj);
+
+				s_Data.CircleVertexArray->bind();
+
+				CmdDrawIndexed(s_Data.CircleVertexArray, indexCount);
+			});
 			s_Data.Stats.DrawCalls++;
+
+			Stats::Add(s_Stats.DrawCalls);
+			Stats::Add(s_Stats.Circles, indexCount / 6);
+			Stats::Add(s_Stats.Vertices, indexCount / 6 * 4);
+			Stats::Add(s_Stats.Indices, indexCount);
+			Stats::Add(s_Stats.BytesUploaded, dataSize);
 		}
 	}
 
@@ -326,11 +372,15 @@ namespace Shado {
 	}
 
 	void Renderer2D::SetClearColor(const glm::vec4& color) {
-		glClearColor(color.r, color.g, color.b, color.a);
+		RenderCommandQueue::Submit([color]() {
+			glClearColor(color.r, color.g, color.b, color.a);
+		});
 	}
 
 	void Renderer2D::Clear() {
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+		RenderCommandQueue::Submit([]() {
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+		});
 	}
 
 	void Renderer2D::FlushAndReset()
@@ -341,6 +391,7 @@ namespace Shado {
 		s_Data.QuadVertexBufferPtr = s_Data.QuadVertexBufferBase;
 
 		s_Data.TextureSlotIndex = 1;
+		s_Data.BatchIndex++;
 
 		s_Data.CircleIndexCount = 0;
 		s_Data.CircleVertexBufferPtr = s_Data.CircleVertexBufferBase;
@@ -348,19 +399,44 @@ namespace Shado {
 
 	void Renderer2D::FlushAndResetLines()
 	{
+		if (s_Data.LineVertexCount)
+		{
+			uint32_t dataSize = (uint8_t*)s_Data.LineVertexBufferPtr - (uint8_t*)s_Data.LineVertexBufferBase;
+			const void* vertices = RenderCommandQueue::Copy(s_Data.LineVertexBufferBase, dataSize);
+			const uint32_t vertexCount = s_Data.LineVertexCount;
+			const glm::mat4 viewProj = s_Data.CameraViewProj;
+
+			RenderCommandQueue::Submit([vertices, dataSize, vertexCount, viewProj]() {
+				s_Data.LineVertexBuffer->setData(vertices, dataSize);
+
+				s_Data.LineShader->bind();
+				s_Data.LineShader->setMat4("u_ViewProjection", viewProj);
+
+				s_Data.LineVertexArray->bind();
+				SetLineThickness(2.0f);
+				CmdDrawLines(s_Data.LineVertexArray, vertexCount);
+			});
+			s_Data.Stats.DrawCalls++;
+
+			Stats::Add(s_Stats.DrawCalls);
+			Stats::Add(s_Stats.Lines, vertexCount / 2);
+			Stats::Add(s_Stats.Vertices, vertexCount);
+			Stats::Add(s_Stats.BytesUploaded, dataSize);
+		}
 
+		s_Data.LineVertexCount = 0;
+		s_Data.LineVertexBufferPtr = s_Data.LineVertexBufferBase;
 	}
 
 	void Renderer2D::CmdDrawIndexed(const Ref<VertexArray>& vertexArray, uint32_t indexCount) {
-		uint32_t count = indexCount ? indexCount : vertexArray->getIndexBuffers()->getCount();
-		glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, nullptr);
+		const auto& indexBuffer = vertexArray->getIndexBuffers();
+		uint32_t count = indexCount ? indexCount : indexBuffer->getCount();
+		glDrawElements(GL_TRIANGLES, count, indexBuffer->getType(), nullptr);
 		//glBindTexture(GL_TEXTURE_2D, 0);
 	}
 
-	void Renderer2D::CmdDrawIndexedLine(const Ref<VertexArray>& vertexArray, uint32_t indexCount) {
-		uint32_t count = indexCount ? indexCount : vertexArray->getIndexBuffers()->getCount();
-		glDrawElements(GL_LINES, count, GL_UNSIGNED_INT, nullptr);
-		//glBindTexture(GL_TEXTURE_2D, 0);
+	void Renderer2D::CmdDrawLines(const Ref<VertexArray>& vertexArray, uint32_t vertexCount) {
+		glDrawArrays(GL_LINES, 0, vertexCount);
 	}
 
 	void Renderer2D::DrawQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color)
@@ -393,18 +469,20 @@ namespace Shado {
 	void Renderer2D::DrawQuad(const glm::mat4& transform, const glm::vec4& color)
 	{
 		constexpr size_t quadVertexCount = 4;
-		const float textureIndex = 0.0f; // White Texture
-		constexpr glm::vec2 textureCoords[] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
-		const float tilingFactor = 1.0f;
+		const uint16_t textureIndex = 0; // White Texture
+		const uint16_t tilingFactor = glm::packHalf1x16(1.0f);
+		const uint32_t packedColor = glm::packUnorm4x8(color);
 
-		if (s_Data.QuadIndexCount >= Renderer2DData::MaxIndices)
+		if (s_Data.QuadIndexCount >= Renderer2DData::MaxIndices) {
+			Stats::Add(s_Stats.FlushBufferFull);
 			FlushAndReset();
+		}
 
 		for (size_t i = 0; i < quadVertexCount; i++)
 		{
 			s_Data.QuadVertexBufferPtr->Position = transform * s_Data.QuadVertexPositions[i];
-			s_Data.QuadVertexBufferPtr->Color = color;
-			s_Data.QuadVertexBufferPtr->TexCoord = textureCoords[i];
+			s_Data.QuadVertexBufferPtr->Color = packedColor;
+			s_Data.QuadVertexBufferPtr->TexCoord = s_Data.QuadTexCoords[i];
 			s_Data.QuadVertexBufferPtr->TexIndex = textureIndex;
 			s_Data.QuadVertexBufferPtr->TilingFactor = tilingFactor;
 			s_Data.QuadVertexBufferPtr++;
@@ -418,39 +496,24 @@ namespace Shado {
 	void Renderer2D::DrawQuad(const glm::mat4& transform, Ref<Texture2D> texture, float tilingFactor, const glm::vec4& tintColor)
 	{
 		constexpr size_t quadVertexCount = 4;
-		constexpr glm::vec2 textureCoords[] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
 
-		if (s_Data.QuadIndexCount >= Renderer2DData::MaxIndices)
+		if (s_Data.QuadIndexCount >= Renderer2DData::MaxIndices) {
+			Stats::Add(s_Stats.FlushBufferFull);
 			FlushAndReset();
-
-		float textureIndex = 0.0f;
-		for (uint32_t i = 1; i < s_Data.TextureSlotIndex; i++)
-		{
-			if (*s_Data.TextureSlots[i] == *texture)
-			{
-				textureIndex = (float)i;
-				break;
-			}
 		}
 
-		if (textureIndex == 0.0f)
-		{
-			if (s_Data.TextureSlotIndex >= Renderer2DData::MaxTextureSlots)
-				FlushAndReset();
+		const uint16_t textureIndex = GetTextureSlot(texture);
 
-			textureIndex = (float)s_Data.TextureSlotIndex;
-			s_Data.TextureSlots[s_Data.TextureSlotIndex] = texture;
-			texture->bind(s_Data.TextureSlotIndex);
-			s_Data.TextureSlotIndex++;
-		}
+		const uint32_t packedColor = glm::packUnorm4x8(tintColor);
+		const uint16_t packedTilingFactor = glm::packHalf1x16(tilingFactor);
 
 		for (size_t i = 0; i < quadVertexCount; i++)
 		{
 			s_Data.QuadVertexBufferPtr->Position = transform * s_Data.QuadVertexPositions[i];
-			s_Data.QuadVertexBufferPtr->Color = tintColor;
-			s_Data.QuadVertexBufferPtr->TexCoord = textureCoords[i];
+			s_Data.QuadVertexBufferPtr->Color = packedColor;
+			s_Data.QuadVertexBufferPtr->TexCoord = s_Data.QuadTexCoords[i];
 			s_Data.QuadVertexBufferPtr->TexIndex = textureIndex;
-			s_Data.QuadVertexBufferPtr->TilingFactor = tilingFactor;
+			s_Data.QuadVertexBufferPtr->TilingFactor = packedTilingFactor;
 			s_Data.QuadVertexBufferPtr++;
 		}
 
@@ -459,6 +522,25 @@ namespace Shado {
 		s_Data.Stats.QuadCount++;
 	}
 
+	uint16_t Renderer2D::GetTextureSlot(const Ref<Texture2D>& texture)
+	{
+		for (uint32_t i = 1; i < s_Data.TextureSlotIndex; i++)
+		{
+			if (*s_Data.TextureSlots[i] == *texture)
+				return (uint16_t)i;
+		}
+
+		if (s_Data.TextureSlotIndex >= Renderer2DData::MaxTextureSlots) {
+			Stats::Add(s_Stats.FlushTextureSlotsFull);
+			FlushAndReset();
+		}
+
+		const uint16_t textureIndex = (uint16_t)s_Data.TextureSlotIndex;
+		s_Data.TextureSlots[s_Data.TextureSlotIndex] = texture;	// Bound when the batch is drawn
+		s_Data.TextureSlotIndex++;
+		return textureIndex;
+	}
+
 	void Renderer2D::DrawRotatedQuad(const glm::vec2& position, const glm::vec2& size, float rotation, const glm::vec4& color)
 	{
 		DrawRotatedQuad({ position.x, position.y, 0.0f }, size, rotation, color);
@@ -512,24 +594,422 @@ namespace Shado {
 		DrawQuad(transform, texture, tilingFactor, tintColor);
 	}
 
+	// Sines and cosines of 4 angles. The angle is brought back to [-pi/4, pi/4] around the nearest multiple
+	// of pi/2 (in three parts to keep the precision), then both come from the Cephes polynomials
+	static void sinCos4(const float* angles, float* sines, float* cosines) {
+#if SHADO_RENDERER2D_SSE
+		const __m128 x = _mm_loadu_ps(angles);
+		const __m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(0.63661977236f)));	// 2 / pi, rounded
+		const __m128 q = _mm_cvtepi32_ps(quadrant);
+
+		__m128 r = _mm_sub_ps(x, _mm_mul_ps(q, _mm_set1_ps(1.5703125f)));
+		r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(4.837512969970703125e-4f)));
+		r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(7.54978995489188216e-8f)));
+		const __m128 r2 = _mm_mul_ps(r, r);
+
+		__m128 sinR = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.9515295891e-4f), r2), _mm_set1_ps(8.3321608736e-3f));
+		sinR = _mm_add_ps(_mm_mul_ps(sinR, r2), _mm_set1_ps(-1.6666654611e-1f));
+		sinR = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinR, r2), r), r);
+
+		__m128 cosR = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.443315711809948e-5f), r2), _mm_set1_ps(-1.388731625493765e-3f));
+		cosR = _mm_add_ps(_mm_mul_ps(cosR, r2), _mm_set1_ps(4.166664568298827e-2f));
+		cosR = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(cosR, r2), r2), _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(r2, _mm_set1_ps(0.5f))));
+
+		// Odd quadrants swap the two, sin is negated in quadrants 2 and 3, cos in 1 and 2
+		const __m128i one = _mm_set1_epi32(1), two = _mm_set1_epi32(2);
+		const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one));
+		const __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, two), 30));
+		const __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, one), two), 30));
+
+		const __m128 sine = _mm_or_ps(_mm_and_ps(swap, cosR), _mm_andnot_ps(swap, sinR));
+		const __m128 cosine = _mm_or_ps(_mm_and_ps(swap, sinR), _mm_andnot_ps(swap, cosR));
+		_mm_storeu_ps(sines, _mm_xor_ps(sine, sinSign));
+		_mm_storeu_ps(cosines, _mm_xor_ps(cosine, cosSign));
+#else
+		for (int i = 0; i < 4; i++) {
+			sines[i] = std::sin(angles[i]);
+			cosines[i] = std::cos(angles[i]);
+		}
+#endif
+	}
+
+	void Renderer2D::DrawSprites(const SpriteArrays& sprites)
+	{
+		SHADO_PROFILE_FUNCTION();
+
+		constexpr uint16_t None = 0xFFFF;
+
+		// Slot of each texture of the table in the current batch, looked up again after a flush
+		std::vector<uint16_t> slots(sprites.TextureCount, None);
+		uint32_t slotsBatch = s_Data.BatchIndex;
+
+		const uint16_t defaultTilingFactor = glm::packHalf1x16(1.0f);
+		const uint32_t white = 0xFFFFFFFF;
+
+		for (uint32_t begin = 0; begin < sprites.Count; begin += 4) {
+			const uint32_t count = std::min(4u, sprites.Count - begin);
+
+			// Padded to 4, the extra lanes are computed and thrown away
+			float angles[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			float halfWidths[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			float halfHeights[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			for (uint32_t i = 0; i < count; i++) {
+				angles[i] = sprites.Angles ? sprites.Angles[begin + i] : 0.0f;
+				halfWidths[i] = sprites.Width[begin + i] * 0.5f;
+				halfHeights[i] = sprites.Height[begin + i] * 0.5f;
+			}
+
+			float sines[4], cosines[4];
+			sinCos4(angles, sines, cosines);
+
+			for (uint32_t i = 0; i < count; i++) {
+				const uint32_t sprite = begin + i;
+
+				if (s_Data.QuadIndexCount >= Renderer2DData::MaxIndices) {
+					Stats::Add(s_Stats.FlushBufferFull);
+					FlushAndReset();
+				}
+
+				uint16_t textureIndex = 0;
+				const uint16_t textureId = sprites.TextureIds ? sprites.TextureIds[sprite] : None;
+				if (textureId != None && sprites.Textures[textureId]) {
+					if (slotsBatch != s_Data.BatchIndex) {
+						std::fill(slots.begin(), slots.end(), None);
+						slotsBatch = s_Data.BatchIndex;
+					}
+
+					if (slots[textureId] == None) {
+						const uint16_t slot = GetTextureSlot(sprites.Textures[textureId]);
+
+						// Taking the slot may have flushed, the others found so far are gone
+						if (slotsBatch != s_Data.BatchIndex) {
+							std::fill(slots.begin(), slots.end(), None);
+							slotsBatch = s_Data.BatchIndex;
+						}
+						slots[textureId] = slot;
+					}
+					textureIndex = slots[textureId];
+				}
+
+				// Half extents along the rotated axes
+				const float ax = halfWidths[i] * cosines[i], ay = halfWidths[i] * sines[i];
+				const float bx = -halfHeights[i] * sines[i], by = halfHeights[i] * cosines[i];
+
+				const float x = sprites.X[sprite];
+				const float y = sprites.Y[sprite];
+				const float z = sprites.Z ? sprites.Z[sprite] : 0.0f;
+				const glm::vec3 corners[4] = {
+					{ x - ax - bx, y - ay - by, z },
+					{ x + ax - bx, y + ay - by, z },
+					{ x + ax + bx, y + ay + by, z },
+					{ x - ax + bx, y - ay + by, z }
+				};
+
+				const uint32_t color = sprites.Colors ? sprites.Colors[sprite] : white;
+				const uint16_t tilingFactor = sprites.TilingFactors ? glm::packHalf1x16(sprites.TilingFactors[sprite]) : defaultTilingFactor;
+
+				for (int corner = 0; corner < 4; corner++) {
+					s_Data.QuadVertexBufferPtr->Position = corners[corner];
+					s_Data.QuadVertexBufferPtr->Color = color;
+					s_Data.QuadVertexBufferPtr->TexCoord = s_Data.QuadTexCoords[corner];
+					s_Data.QuadVertexBufferPtr->TexIndex = textureIndex;
+					s_Data.QuadVertexBufferPtr->TilingFactor = tilingFactor;
+					s_Data.QuadVertexBufferPtr++;
+				}
+
+				s_Data.QuadIndexCount += 6;
+			}
+		}
+
+		s_Data.Stats.QuadCount += sprites.Count;
+	}
+
+	// ========================================
+
+	static constexpr uint32_t QuadCachePageSize = Renderer2DData::MaxQuads;
+	static constexpr uint16_t NoTextureSlot = 0xFFFF;
+
+	struct QuadCache::Page {
+		Ref<VertexArray> QuadVertexArray;		// Created by the first draw, quads can be cached before there is a GL context
+		Ref<VertexBuffer> QuadVertexBuffer;
+		std::vector<QuadVertex> Vertices;		// 4 per place, what the GPU has once the dirty range is uploaded
+
+		std::array<Ref<Texture2D>, Renderer2DData::MaxTextureSlots> Textures;
+		std::array<uint32_t, Renderer2DData::MaxTextureSlots> TextureUses = {};
+		uint32_t TextureCount = 1;		// 0 = white texture, set when drawn
+
+		std::vector<uint32_t> Free;		// Places of removed quads
+		uint32_t QuadCount = 0;
+		uint32_t DirtyBegin = None;		// Range of places changed since the last upload
+		uint32_t DirtyEnd = 0;
+	};
+
+	// Page in the high 16 bits, place in the low ones
+	static uint32_t packQuad(uint32_t page, uint32_t place) { return (page << 16) | place; }
+
+	QuadCache::QuadCache() = default;
+	QuadCache::~QuadCache() = default;
+
+	uint32_t QuadCache::add(const glm::vec3& position, const glm::vec2& size, float rotation, const Ref<Texture2D>& texture, float tilingFactor, const glm::vec4& color)
+	{
+		uint32_t pageIndex = 0;
+		uint16_t textureSlot = 0;
+		for (; pageIndex < (uint32_t)m_Pages.size(); pageIndex++) {
+			Page& page = *m_Pages[pageIndex];
+			if (page.Free.empty() && page.Vertices.size() / 4 >= QuadCachePageSize)
+				continue;
+
+			textureSlot = texture ? findTextureSlot(page, texture) : 0;
+			if (textureSlot != NoTextureSlot)
+				break;
+		}
+
+		if (pageIndex == (uint32_t)m_Pages.size()) {
+			auto page = std::make_unique<Page>();
+			textureSlot = texture ? findTextureSlot(*page, texture) : 0;
+			m_Pages.push_back(std::move(page));
+		}
+
+		Page& page = *m_Pages[pageIndex];
+		uint32_t place;
+		if (!page.Free.empty()) {
+			place = page.Free.back();
+			page.Free.pop_back();
+		} else {
+			place = (uint32_t)page.Vertices.size() / 4;
+			page.Vertices.resize(page.Vertices.size() + 4);
+		}
+
+		write(page, place, position, size, rotation, textureSlot, tilingFactor, color);
+		page.QuadCount++;
+		m_QuadCount++;
+
+		return packQuad(pageIndex, place);
+	}
+
+	uint32_t QuadCache::update(uint32_t quad, const glm::vec3& position, const glm::vec2& size, float rotation, const Ref<Texture2D>& texture, float tilingFactor, const glm::vec4& color)
+	{
+		Page& page = *m_Pages[quad >> 16];
+		const uint32_t place = quad & 0xFFFF;
+
+		const uint16_t textureSlot = texture ? findTextureSlot(page, texture) : 0;
+		if (textureSlot == NoTextureSlot) {
+			remove(quad);
+			return add(position, size, rotation, texture, tilingFactor, color);
+		}
+
+		// Taken before the old one is given back, keeping the same texture doesn't free its slot
+		releaseTextureSlot(page, page.Vertices[(size_t)place * 4].TexIndex);
+		write(page, place, position, size, rotation, textureSlot, tilingFactor, color);
+		return quad;
+	}
+
+	void QuadCache::remove(uint32_t quad)
+	{
+		Page& page = *m_Pages[quad >> 16];
+		const uint32_t place = quad & 0xFFFF;
+
+		releaseTextureSlot(page, page.Vertices[(size_t)place * 4].TexIndex);
+		write(page, place, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f }, 0.0f, 0, 1.0f, { 0.0f, 0.0f, 0.0f, 0.0f });
+
+		page.Free.push_back(place);
+		page.QuadCount--;
+		m_QuadCount--;
+	}
+
+	void QuadCache::clear()
+	{
+		m_Pages.clear();
+		m_QuadCount = 0;
+	}
+
+	uint16_t QuadCache::findTextureSlot(Page& page, const Ref<Texture2D>& texture)
+	{
+		uint16_t slot = NoTextureSlot;
+		for (uint32_t i = 1; i < page.TextureCount; i++) {
+			if (!page.Textures[i]) {
+				if (slot == NoTextureSlot)
+					slot = (uint16_t)i;
+			} else if (*page.Textures[i] == *texture) {
+				page.TextureUses[i]++;
+				return (uint16_t)i;
+			}
+		}
+
+		if (slot == NoTextureSlot) {
+			if (page.TextureCount >= Renderer2DData::MaxTextureSlots)
+				return NoTextureSlot;
+			slot = (uint16_t)page.TextureCount++;
+		}
+
+		page.Textures[slot] = texture;
+		page.TextureUses[slot] = 1;
+		return slot;
+	}
+
+	void QuadCache::releaseTextureSlot(Page& page, uint16_t slot)
+	{
+		if (slot != 0 && --page.TextureUses[slot] == 0)
+			page.Textures[slot] = nullptr;
+	}
+
+	void QuadCache::write(Page& page, uint32_t place, const glm::vec3& position, const glm::vec2& size, float rotation, uint16_t textureSlot, float tilingFactor, const glm::vec4& color)
+	{
+		// Half extents along the rotated axes, as in DrawSprites
+		const float c = std::cos(rotation), s = std::sin(rotation);
+		const float ax = size.x * 0.5f * c, ay = size.x * 0.5f * s;
+		const float bx = -size.y * 0.5f * s, by = size.y * 0.5f * c;
+
+		const glm::vec3 corners[4] = {
+			{ position.x - ax - bx, position.y - ay - by, position.z },
+			{ position.x + ax - bx, position.y + ay - by, position.z },
+			{ position.x + ax + bx, position.y + ay + by, position.z },
+			{ position.x - ax + bx, position.y - ay + by, position.z }
+		};
+
+		const uint32_t packedColor = glm::packUnorm4x8(color);
+		const uint16_t packedTilingFactor = glm::packHalf1x16(tilingFactor);
+
+		// Not s_Data's, they are only filled by Init
+		static const uint32_t texCoords[4] = {
+			glm::packHalf2x16({ 0.0f, 0.0f }), glm::packHalf2x16({ 1.0f, 0.0f }),
+			glm::packHalf2x16({ 1.0f, 1.0f }), glm::packHalf2x16({ 0.0f, 1.0f })
+		};
+
+		QuadVertex* vertex = &page.Vertices[(size_t)place * 4];
+		for (int corner = 0; corner < 4; corner++, vertex++) {
+			vertex->Position = corners[corner];
+			vertex->Color = packedColor;
+			vertex->TexCoord = texCoords[corner];
+			vertex->TexIndex = textureSlot;
+			vertex->TilingFactor = packedTilingFactor;
+		}
+
+		page.DirtyBegin = std::min(page.DirtyBegin, place);
+		page.DirtyEnd = std::max(page.DirtyEnd, place + 1);
+	}
+
+	void Renderer2D::DrawQuadCache(QuadCache& cache)
+	{
+		SHADO_PROFILE_FUNCTION();
+
+		const glm::mat4 viewProj = s_Data.CameraViewProj;
+
+		for (const auto& pagePointer : cache.m_Pages) {
+			QuadCache::Page& page = *pagePointer;
+			if (page.QuadCount == 0)
+				continue;
+
+			if (!page.QuadVertexArray) {
+				page.QuadVertexBuffer = VertexBuffer::create(QuadCachePageSize * 4 * sizeof(QuadVertex));
+				page.QuadVertexBuffer->setLayout(GetQuadVertexLayout());
+				page.QuadVertexArray = VertexArray::create();
+				page.QuadVertexArray->addVertexBuffer(page.QuadVertexBuffer);
+				page.QuadVertexArray->setIndexBuffer(IndexBuffer::getQuadIndexBuffer());
+
+				page.DirtyBegin = 0;
+				page.DirtyEnd = (uint32_t)page.Vertices.size() / 4;
+			}
+
+			const void* vertices = nullptr;
+			uint32_t dataSize = 0, offset = 0;
+			if (page.DirtyBegin < page.DirtyEnd) {
+				offset = page.DirtyBegin * 4 * sizeof(QuadVertex);
+				dataSize = (page.DirtyEnd - page.DirtyBegin) * 4 * sizeof(QuadVertex);
+				vertices = RenderCommandQueue::Copy(&page.Vertices[(size_t)page.DirtyBegin * 4], dataSize);
+				page.DirtyBegin = QuadCache::None;
+				page.DirtyEnd = 0;
+			}
+
+			// Removed quads are in the range too, collapsed
+			const uint32_t indexCount = (uint32_t)page.Vertices.size() / 4 * 6;
+			const uint32_t textureCount = page.TextureCount;
+			std::array<Ref<Texture2D>, Renderer2DData::MaxTextureSlots> textures = page.Textures;
+			textures[0] = s_Data.WhiteTexture;
+
+			// The buffers are held by the command, the cache may be cleared before the frame is drawn
+			RenderCommandQueue::Submit([vertexArray = page.QuadVertexArray, vertexBuffer = page.QuadVertexBuffer,
+				vertices, dataSize, offset, indexCount, textureCount, textures, viewProj]() {
+				if (dataSize)
+					vertexBuffer->setData(vertices, dataSize, offset);
+
+				s_Data.TextureShader->bind();
+				s_Data.TextureShader->setMat4("u_ViewProjection", viewProj);
+
+				for (uint32_t i = 0; i < textureCount; i++) {
+					if (textures[i])
+						textures[i]->bind(i);
+				}
+
+				vertexArray->bind();
+
+				CmdDrawIndexed(vertexArray, indexCount);
+			});
+			s_Data.Stats.DrawCalls++;
+			s_Data.Stats.QuadCount += page.QuadCount;
+
+			Stats::Add(s_Stats.DrawCalls);
+			Stats::Add(s_Stats.CachedQuads, page.QuadCount);
+			Stats::Add(s_Stats.Vertices, indexCount / 6 * 4);
+			Stats::Add(s_Stats.Indices, indexCount);
+			Stats::Add(s_Stats.TextureBinds, textureCount);
+			Stats::Add(s_Stats.BytesUploaded, dataSize);
+		}
+	}
+
+	void Renderer2D::DrawQuadMesh(const Ref<GpuMesh>& mesh, const Ref<Texture2D>& texture)
+	{
+		const glm::mat4 viewProj = s_Data.CameraViewProj;
+
+		// Holding the GpuMesh keeps its range alive until the draw was replayed
+		RenderCommandQueue::Submit([mesh, texture = texture ? texture : s_Data.WhiteTexture, viewProj]() {
+			s_Data.TextureShader->bind();
+			s_Data.TextureShader->setMat4("u_ViewProjection", viewProj);
+
+			texture->bind(0);
+			mesh->getVertexArray()->bind();
+
+			const auto& indexBuffer = mesh->getIndexBuffer();
+			glDrawElementsBaseVertex(GL_TRIANGLES, indexBuffer->getCount(), indexBuffer->getType(),
+				(void*)(uintptr_t)indexBuffer->getOffset(), mesh->getBaseVertex());
+		});
+
+		const uint32_t indexCount = mesh->getIndexCount();
+		s_Data.Stats.DrawCalls++;
+		s_Data.Stats.QuadCount += indexCount / 6;
+
+		Stats::Add(s_Stats.DrawCalls);
+		Stats::Add(s_Stats.Vertices, mesh->getVertexCount());
+		Stats::Add(s_Stats.Indices, indexCount);
+		Stats::Add(s_Stats.TextureBinds);
+	}
+
+	// ========================================
+
 	void Renderer2D::SetLineThickness(float thickness) {
-		glLineWidth(thickness);
+		RenderCommandQueue::Submit([thickness]() {
+			glLineWidth(thickness);
+		});
 	}
 
 	void Renderer2D::DrawLine(const glm::vec3& p0, const glm::vec3& p1, const glm::vec4& color)
 	{
-		if (s_Data.LineIndexCount >= Renderer2DData::MaxLineIndices)
+		if (s_Data.LineVertexCount >= Renderer2DData::MaxLineVertices) {
+			Stats::Add(s_Stats.FlushLineBufferFull);
 			FlushAndResetLines();
+		}
+
+		const uint32_t packedColor = glm::packUnorm4x8(color);
 
 		s_Data.LineVertexBufferPtr->Position = p0;
-		s_Data.LineVertexBufferPtr->Color = color;
+		s_Data.LineVertexBufferPtr->Color = packedColor;
 		s_Data.LineVertexBufferPtr++;
 
 		s_Data.LineVertexBufferPtr->Position = p1;
-		s_Data.LineVertexBufferPtr->Color = color;
+		s_Data.LineVertexBufferPtr->Color = packedColor;
 		s_Data.LineVertexBufferPtr++;
 
-		s_Data.LineIndexCount += 2;
+		s_Data.LineVertexCount += 2;
 
 		s_Data.Stats.LineCount++;
 	}
@@ -548,22 +1028,28 @@ namespace Shado {
 
 		constexpr size_t quadVertexCount = 4;
 
-		if (s_Data.CircleIndexCount >= Renderer2DData::MaxIndices)
+		if (s_Data.CircleIndexCount >= Renderer2DData::MaxIndices) {
+			Stats::Add(s_Stats.FlushBufferFull);
 			FlushAndReset();
+		}
+
+		const uint32_t packedColor = glm::packUnorm4x8(color);
+		const uint16_t packedThickness = glm::packHalf1x16(thickness);
+		const uint16_t packedFade = glm::packHalf1x16(fade);
 
 		for (size_t i = 0; i < quadVertexCount; i++)
 		{
 			s_Data.CircleVertexBufferPtr->WorldPosition = transform * s_Data.QuadVertexPositions[i];
-			s_Data.CircleVertexBufferPtr->LocalPosition = s_Data.QuadVertexPositions[i] * 2.0f;
-			s_Data.CircleVertexBufferPtr->Color = color;
-			s_Data.CircleVertexBufferPtr->Thickness = thickness;
-			s_Data.CircleVertexBufferPtr->Fade = fade;
+			s_Data.CircleVertexBufferPtr->LocalPosition = s_Data.CircleLocalPositions[i];
+			s_Data.CircleVertexBufferPtr->Color = packedColor;
+			s_Data.CircleVertexBufferPtr->Thickness = packedThickness;
+			s_Data.CircleVertexBufferPtr->Fade = packedFade;
 			s_Data.CircleVertexBufferPtr++;
 		}
 
 		s_Data.CircleIndexCount += 6;
 
-		s_Data.Stats.QuadCount++;
+		s_Data.Stats.CircleCount++;
 
 	}
 
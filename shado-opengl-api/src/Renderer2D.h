@@ -13,10 +13,13 @@
 
 namespace Shado {
 
-	inline std::string FLAT_COLOR_SHADER_PATH = FILE_PATH + "\\assets\\FlatColorShader.glsl";
-	inline std::string TEXTURE2D_SHADER_PATH = FILE_PATH + "\\assets\\TextureShader.glsl";
-	inline std::string LINES_SHADER_PATH = FILE_PATH + "\\assets\\Renderer2D_Lines.glsl";
-	inline std::string CIRCLE_SHADER_PATH = FILE_PATH + "\\assets\\Renderer2D_Circles.glsl";
+	inline std::string FLAT_COLOR_SHADER_PATH = FILE_PATH + "/assets/FlatColorShader.glsl";
+	inline std::string TEXTURE2D_SHADER_PATH = FILE_PATH + "/assets/TextureShader.glsl";
+	inline std::string LINES_SHADER_PATH = FILE_PATH + "/assets/Renderer2D_Lines.glsl";
+	inline std::string CIRCLE_SHADER_PATH = FILE_PATH + "/assets/Renderer2D_Circles.glsl";
+
+	class QuadCache;
+	class GpuMesh;
 
 	class Renderer2D
 	{
@@ -47,6 +50,62 @@ namespace Shado {
 		static void DrawRotatedQuad(const glm::vec3& position, const glm::vec2& size, float rotation, Ref<Texture2D> texture, float tilingFactor = 1.0f, const glm::vec4& tintColor = glm::vec4(1.0f));
 		static void DrawRotatedQuad(const glm::vec3& position, const glm::vec2& size, const glm::vec3& rotation, Ref<Texture2D> texture, float tilingFactor = 1.0f, const glm::vec4& tintColor = glm::vec4(1.0f));
 
+		/**
+		 * Structure of arrays, element i of each array is sprite i. Optional arrays can be null:
+		 * no Z = 0, no Angles = not rotated, no Colors = white, no TextureIds = white texture,
+		 * no TilingFactors = 1
+		 */
+		struct SpriteArrays {
+			uint32_t Count = 0;
+			const float* X = nullptr;
+			const float* Y = nullptr;
+			const float* Z = nullptr;
+			const float* Width = nullptr;
+			const float* Height = nullptr;
+			const float* Angles = nullptr;			// Radians, counterclockwise around the quad's center
+			const uint32_t* Colors = nullptr;		// glm::packUnorm4x8
+			const uint16_t* TextureIds = nullptr;	// Into Textures, a null texture is the white one
+			const float* TilingFactors = nullptr;
+
+			const Ref<Texture2D>* Textures = nullptr;
+			uint32_t TextureCount = 0;
+		};
+
+		// Rotated quads in bulk. The corners come straight from the sines and cosines, computed 4 sprites
+		// at a time with SSE2, without building a matrix per quad
+		static void DrawSprites(const SpriteArrays& sprites);
+
+		// Draws every quad of the cache, a draw call per page. Only the quads changed since the last
+		// time are uploaded, the rest is already on the GPU
+		static void DrawQuadCache(QuadCache& cache);
+
+		// Vertex of the quad batches, packed (see ShaderDataType) to keep the bandwidth down
+		struct QuadVertex
+		{
+			glm::vec3 Position;
+			uint32_t Color;			// UByte4Norm
+			uint32_t TexCoord;		// Half2
+			uint16_t TexIndex;		// UShort
+			uint16_t TilingFactor;	// Half
+		};
+		static const BufferLayout& GetQuadVertexLayout();
+
+		// Same attributes with full float texture coordinates: a half is off by up to a texel on a large atlas,
+		// enough for the cells of a tilemap to bleed into their neighbours
+		struct TileVertex
+		{
+			glm::vec3 Position;
+			uint32_t Color;			// UByte4Norm
+			glm::vec2 TexCoord;
+			uint16_t TexIndex;		// UShort
+			uint16_t TilingFactor;	// Half
+		};
+		static const BufferLayout& GetTileVertexLayout();
+
+		// Quads built ahead of time in a GpuBufferArena with the quad or the tile vertex layout, drawn with the
+		// texture shader. The texture is bound to slot 0, the vertices' TexIndex should be 0
+		static void DrawQuadMesh(const Ref<GpuMesh>& mesh, const Ref<Texture2D>& texture);
+
 		static void SetLineThickness(float thickness);
 		static void DrawLine(const glm::vec3& p0, const glm::vec3& p1, const glm::vec4& color = glm::vec4(1.0f));
 
@@ -60,20 +119,69 @@ namespace Shado {
 		{
 			uint32_t DrawCalls = 0;
 			uint32_t QuadCount = 0;
+			uint32_t CircleCount = 0;
 			uint32_t LineCount = 0;
 
-			uint32_t GetTotalVertexCount() { return QuadCount * 4 + LineCount * 2; }
-			uint32_t GetTotalIndexCount() { return QuadCount * 6 + LineCount * 2; }
+			uint32_t GetTotalVertexCount() { return (QuadCount + CircleCount) * 4 + LineCount * 2; }
+			uint32_t GetTotalIndexCount() { return (QuadCount + CircleCount) * 6; }	// Lines are not indexed
 		};
+		// Totals since the last reset. Per frame values and their history are in Stats, under "Renderer2D."
 		static void ResetStats();
 		static Statistics GetStats();
 	private:
 		static void FlushAndReset();
 		static void FlushAndResetLines();
+		// Slot of the texture in the current batch, flushes when they are all taken
+		static uint16_t GetTextureSlot(const Ref<Texture2D>& texture);
 		static void CmdDrawIndexed(const Ref<VertexArray>& vertexArray, uint32_t indexCount = 0);
-		static void CmdDrawIndexedLine(const Ref<VertexArray>& vertexArray, uint32_t indexCount = 0);
+		static void CmdDrawLines(const Ref<VertexArray>& vertexArray, uint32_t vertexCount);
 		static bool s_Init;
 	};
+
+	/**
+	 * Quads that stay the same from one frame to the next, kept in vertex buffers on the GPU instead of
+	 * being rebuilt and uploaded every frame. Changing a quad marks its vertices dirty, drawing uploads
+	 * the dirty range of each page and nothing else.
+	 *
+	 * Pages hold up to IndexBuffer::MaxQuads16 quads (they share the quad indices) and their own texture
+	 * slots: a quad goes to the first page with a free place that has its texture or a free slot for it.
+	 * A removed quad is collapsed to a point until its place is reused.
+	 * There is no culling, everything in the cache is drawn: it costs GPU time, not CPU time.
+	 */
+	class QuadCache {
+	public:
+		static constexpr uint32_t None = 0xFFFFFFFF;
+
+		QuadCache();
+		~QuadCache();
+
+		QuadCache(const QuadCache&) = delete;
+		QuadCache& operator=(const QuadCache&) = delete;
+
+		// Returns the handle of the quad. rotation is in radians, a null texture is the white one
+		uint32_t add(const glm::vec3& position, const glm::vec2& size, float rotation, const Ref<Texture2D>& texture, float tilingFactor, const glm::vec4& color);
+		// The quad moves to another page when its new texture doesn't fit in its own, use the handle returned
+		uint32_t update(uint32_t quad, const glm::vec3& position, const glm::vec2& size, float rotation, const Ref<Texture2D>& texture, float tilingFactor, const glm::vec4& color);
+		void remove(uint32_t quad);
+		void clear();
+
+		uint32_t getQuadCount() const { return m_QuadCount; }
+		uint32_t getPageCount() const { return (uint32_t)m_Pages.size(); }
+
+	private:
+		struct Page;
+
+		// Texture slot of the page, 0xFFFF if they are all taken
+		uint16_t findTextureSlot(Page& page, const Ref<Texture2D>& texture);
+		void releaseTextureSlot(Page& page, uint16_t slot);
+		void write(Page& page, uint32_t slot, const glm::vec3& position, const glm::vec2& size, float rotation, uint16_t textureSlot, float tilingFactor, const glm::vec4& color);
+
+		friend class Renderer2D;
+
+	private:
+		std::vector<std::unique_ptr<Page>> m_Pages;
+		uint32_t m_QuadCount = 0;
+	};
 }
 
 #endif
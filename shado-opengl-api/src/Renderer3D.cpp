@@ -3,6 +3,8 @@
 #include "GL/glew.h"
 #include "Renderer2D.h"
 #include "Shader.h"
+#include "RenderCommandQueue.h"
+#include "Stats.h"
 
 namespace Shado {
 
@@ -10,10 +12,20 @@ namespace Shado {
 		Shader* flatColorShader;
 
 		glm::mat4 viewProj;
+
+		Ref<OcclusionCuller> occlusionCuller;
 	};
 
 	static Renderer3DData s_Data;
 
+	struct Renderer3DStats {
+		StatHandle DrawCalls = Stats::Register("Renderer3D.DrawCalls");
+		StatHandle Vertices = Stats::Register("Renderer3D.Vertices");
+		StatHandle Indices = Stats::Register("Renderer3D.Indices");
+		StatHandle Culled = Stats::Register("Renderer3D.Culled");	// Models the occlusion culler skipped
+	};
+	static Renderer3DStats s_Stats;
+
 	void Renderer3D::Init() {
 		s_Data.flatColorShader = new Shader(OBJECT3D_DEFAULT_SHADER_PATH);
 	}
@@ -23,6 +35,9 @@ namespace Shado {
 
 	void Renderer3D::BeginScene(const Camera& camera) {
 		s_Data.viewProj = camera.getViewProjectionMatrix();
+
+		if (s_Data.occlusionCuller)
+			s_Data.occlusionCuller->beginFrame(s_Data.viewProj);
 	}
 
 	void Renderer3D::EndScene() {
@@ -50,26 +65,61 @@ namespace Shado {
 		DrawTransformedModel(mesh, transform, modelColor, light, fill);
 	}
 
+	void Renderer3D::SetOcclusionCuller(const Ref<OcclusionCuller>& culler) {
+		s_Data.occlusionCuller = culler;
+	}
+
+	const Ref<OcclusionCuller>& Renderer3D::GetOcclusionCuller() {
+		return s_Data.occlusionCuller;
+	}
+
+	void Renderer3D::SubmitOccluder(const Ref<Object3D>& mesh, const glm::mat4& transform) {
+		if (!s_Data.occlusionCuller)
+			return;
+
+		const auto& positions = mesh->getPositions();
+		const auto& indices = mesh->getIndices();
+		s_Data.occlusionCuller->addOccluder(positions.data(), (uint32_t)positions.size(), indices.data(), (uint32_t)indices.size(), transform);
+	}
+
 	void Renderer3D::DrawTransformedModel(const Ref<Object3D>& mesh, const glm::mat4& transform,
 		const glm::vec4& modelColor, const DiffuseLight& light, bool fill) {
 
-		s_Data.flatColorShader->bind();
-		s_Data.flatColorShader->setMat4("u_ViewProjection", s_Data.viewProj);
-		s_Data.flatColorShader->setMat4("u_Transform", transform);
-		s_Data.flatColorShader->setFloat4("u_Color", modelColor);
+		if (s_Data.occlusionCuller) {
+			if (!s_Data.occlusionCuller->hasRasterized())
+				s_Data.occlusionCuller->rasterize();
+
+			if (!s_Data.occlusionCuller->isVisible(AABB::transform(mesh->getLocalBounds(), transform))) {
+				Stats::Add(s_Stats.Culled);
+				return;
+			}
+		}
 
-		s_Data.flatColorShader->setFloat3("u_LightPos", light.getPosition());
-		s_Data.flatColorShader->setFloat3("u_LightColor", light.getColor());
+		const glm::mat4 viewProj = s_Data.viewProj;
+		const glm::vec3 lightPosition = light.getPosition();
+		const glm::vec3 lightColor = light.getColor();
+		const GLenum mode = fill ? GL_TRIANGLES : GL_LINES;
 
-		const auto& vao = mesh->getVertexArray();
-		vao->bind();
+		// Holding the GpuMesh keeps its range alive until the draw was replayed
+		RenderCommandQueue::Submit([gpuMesh = mesh->getGpuMesh(), transform, modelColor, viewProj, lightPosition, lightColor, mode]() {
+			s_Data.flatColorShader->bind();
+			s_Data.flatColorShader->setMat4("u_ViewProjection", viewProj);
+			s_Data.flatColorShader->setMat4("u_Transform", transform);
+			s_Data.flatColorShader->setFloat4("u_Color", modelColor);
 
-		{
-			auto mode = GL_TRIANGLES;
-			if (!fill)
-				mode = GL_LINES;
+			s_Data.flatColorShader->setFloat3("u_LightPos", lightPosition);
+			s_Data.flatColorShader->setFloat3("u_LightColor", lightColor);
 
-			glDrawElements(mode, vao->getIndexBuffers()->getCount(), GL_UNSIGNED_INT, nullptr);
-		}
+			gpuMesh->getVertexArray()->bind();
+
+			const auto& indexBuffer = gpuMesh->getIndexBuffer();
+			glDrawElementsBaseVertex(mode, indexBuffer->getCount(), indexBuffer->getType(),
+				(void*)(uintptr_t)indexBuffer->getOffset(), gpuMesh->getBaseVertex());
+		});
+
+		const Ref<GpuMesh>& gpuMesh = mesh->getGpuMesh();
+		Stats::Add(s_Stats.DrawCalls);
+		Stats::Add(s_Stats.Vertices, gpuMesh->getVertexCount());
+		Stats::Add(s_Stats.Indices, gpuMesh->getIndexCount());
 	}
 }
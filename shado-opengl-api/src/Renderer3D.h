@@ -2,10 +2,11 @@
 #include "glm/vec3.hpp"
 #include "Objects3D/Object3D.h"
 #include "util/Light.h"
+#include "OcclusionCuller.h"
 
 namespace Shado {
 
-	inline std::string OBJECT3D_DEFAULT_SHADER_PATH = FILE_PATH + "\\assets\\Renderer3D.glsl";
+	inline std::string OBJECT3D_DEFAULT_SHADER_PATH = FILE_PATH + "/assets/Renderer3D.glsl";
 
 	class Renderer3D {
 	public:
@@ -21,6 +22,12 @@ namespace Shado {
 		static void DrawRotatedModel(const Ref<Object3D>& mesh, const glm::vec3& position = { 0, 0, 0 },
 			const glm::vec3& scale = { 1, 1, 1 }, const glm::vec3& rotation = { 0, 0, 0 }, const glm::vec4& modelColor = { 1, 1, 1, 1 }, const DiffuseLight& light = DiffuseLight(), bool fill = true);
 
+		// Occlusion culling is off until a culler is set (nullptr turns it back off).
+		// Occluders must be submitted after BeginScene and before the first Draw call of the frame
+		static void SetOcclusionCuller(const Ref<OcclusionCuller>& culler);
+		static const Ref<OcclusionCuller>& GetOcclusionCuller();
+		static void SubmitOccluder(const Ref<Object3D>& mesh, const glm::mat4& transform);
+
 
 	private:
 
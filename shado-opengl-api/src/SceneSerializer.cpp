@@ -0,0 +1,513 @@
+#include "SceneSerializer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "box2d/b2_body.h"
+#include "box2d/b2_fixture.h"
+#include "Debug.h"
+#include "Layer.h"
+#include "Profiler.h"
+#include "util/MappedFile.h"
+
+namespace Shado {
+
+	static constexpr uint32_t NoString = 0xFFFFFFFF;
+
+	struct SceneFileHeader {
+		char Magic[4];			// "SHSC"
+		uint32_t Version;
+		uint32_t EntityCount;
+		uint32_t StringCount;
+		uint64_t EntitiesOffset;
+		uint64_t StringsOffset;	// StringCount + 1 offsets, then the characters. String i is [offset i, offset i + 1[
+	};
+	static_assert(sizeof(SceneFileHeader) == 32, "SceneFileHeader must match the file layout");
+
+	// Read in place from the mapped file, only fixed size fields
+	struct EntityRecord {
+		uint64_t Id;
+		uint32_t Name;			// In the string table
+		uint32_t Texture;		// In the string table, NoString without texture
+		float Position[3];
+		float Rotation;			// Radians
+		float Scale[2];
+		float Color[4];
+		float LinearVelocity[2];
+		float AngularVelocity;
+		float Density;
+		float Friction;
+		uint32_t TilingFactor;
+		uint8_t Type;			// EntityType
+		uint8_t Awake;
+		uint8_t Padding[6];
+	};
+	static_assert(sizeof(EntityRecord) == 88, "EntityRecord must match the file layout");
+
+	// Strings deduplicated as they are added
+	class StringTable {
+	public:
+		uint32_t add(const std::string& text) {
+			auto [it, inserted] = m_Indices.try_emplace(text, (uint32_t)m_Strings.size());
+			if (inserted)
+				m_Strings.push_back(&it->first);
+			return it->second;
+		}
+
+		const std::vector<const std::string*>& getStrings() const { return m_Strings; }
+
+	private:
+		std::unordered_map<std::string, uint32_t> m_Indices;
+		std::vector<const std::string*> m_Strings;
+	};
+
+	static EntityRecord toRecord(const Scene& scene, EntityHandle entity, StringTable& strings) {
+		const Registry& registry = scene.getRegistry();
+		const EntityInfo& info = registry.get<EntityInfo>(entity);
+		const Transform& transform = registry.get<Transform>(entity);
+		const Sprite& sprite = registry.get<Sprite>(entity);
+		const b2Body* body = registry.get<RigidBody>(entity).body;
+
+		EntityRecord record = {};
+		record.Id = info.id;
+		record.Name = strings.add(scene.getNames().get(info.name));
+		record.Texture = sprite.texture && !sprite.texture->getFilePath().empty() ? strings.add(sprite.texture->getFilePath()) : NoString;
+
+		// From the body, the transform may be a step behind
+		const b2Vec2& position = body->GetPosition();
+		record.Position[0] = position.x;
+		record.Position[1] = position.y;
+		record.Position[2] = transform.position.z;
+		record.Rotation = body->GetAngle();
+		record.Scale[0] = transform.scale.x;
+		record.Scale[1] = transform.scale.y;
+
+		const glm::vec4 color = sprite.color;
+		for (int i = 0; i < 4; i++)
+			record.Color[i] = color[i];
+		record.TilingFactor = sprite.tilingfactor;
+
+		const b2Vec2& velocity = body->GetLinearVelocity();
+		record.LinearVelocity[0] = velocity.x;
+		record.LinearVelocity[1] = velocity.y;
+		record.AngularVelocity = body->GetAngularVelocity();
+
+		// Entities have a single fixture
+		const b2Fixture* fixture = body->GetFixtureList();
+		record.Density = fixture ? fixture->GetDensity() : 1.0f;
+		record.Friction = fixture ? fixture->GetFriction() : 0.3f;
+		record.Type = (uint8_t)body->GetType();
+		record.Awake = body->IsAwake() ? 1 : 0;
+		return record;
+	}
+
+	// Every entity of the scene without a subset
+	static std::vector<EntityRecord> toRecords(Scene& scene, StringTable& strings, const std::vector<Entity>* entities = nullptr) {
+		// The bodies may be in the middle of a step
+		scene.waitForPhysics();
+
+		std::vector<EntityRecord> records;
+		if (entities) {
+			records.reserve(entities->size());
+			for (const Entity& entity : *entities) {
+				if (entity.getScene() == &scene && entity.isValid())
+					records.push_back(toRecord(scene, entity.getHandle(), strings));
+			}
+			return records;
+		}
+
+		records.reserve(scene.getRegistry().getCount());
+		scene.getRegistry().each<RigidBody>([&](EntityHandle entity, const RigidBody&) {
+			records.push_back(toRecord(scene, entity, strings));
+		});
+		return records;
+	}
+
+	static bool writeBinary(const std::string& path, const std::vector<EntityRecord>& records, const StringTable& strings) {
+		std::ofstream file(path, std::ios::binary);
+		if (!file) {
+			SHADO_CORE_ERROR("Could not open {0} for writing", path);
+			return false;
+		}
+
+		SceneFileHeader header = {};
+		std::memcpy(header.Magic, "SHSC", 4);
+		header.Version = SceneSerializer::Version;
+		header.EntityCount = (uint32_t)records.size();
+		header.StringCount = (uint32_t)strings.getStrings().size();
+		header.EntitiesOffset = sizeof(SceneFileHeader);
+		header.StringsOffset = header.EntitiesOffset + records.size() * sizeof(EntityRecord);
+
+		std::vector<uint32_t> offsets;
+		offsets.reserve(strings.getStrings().size() + 1);
+		uint32_t offset = 0;
+		for (const std::string* text : strings.getStrings()) {
+			offsets.push_back(offset);
+			offset += (uint32_t)text->size();
+		}
+		offsets.push_back(offset);
+
+		// Little endian hosts only, which is all the engine runs on
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)records.data(), records.size() * sizeof(EntityRecord));
+		file.write((const char*)offsets.data(), offsets.size() * sizeof(uint32_t));
+		for (const std::string* text : strings.getStrings())
+			file.write(text->data(), text->size());
+
+		return (bool)file;
+	}
+
+	SceneFile::SceneFile() = default;
+	SceneFile::~SceneFile() = default;
+
+	void SceneFile::close() {
+		m_File = nullptr;
+		m_Records = nullptr;
+		m_EntityCount = 0;
+		m_Strings = {};
+		m_TextureStrings = {};
+	}
+
+	bool SceneFile::open(const std::string& path) {
+		SHADO_PROFILE_FUNCTION();
+
+		close();
+
+		ScopedPtr<MappedFile> file = std::make_unique<MappedFile>(path);
+		if (!file->isOpen()) {
+			SHADO_CORE_ERROR("Could not open {0}", path);
+			return false;
+		}
+
+		const uint8_t* data = file->getData();
+		const size_t size = file->getSize();
+
+		SceneFileHeader header;
+		if (size < sizeof(header) || std::memcmp(data, "SHSC", 4) != 0) {
+			SHADO_CORE_ERROR("{0} is not a binary scene", path);
+			return false;
+		}
+		std::memcpy(&header, data, sizeof(header));
+
+		if (header.Version != SceneSerializer::Version) {
+			SHADO_CORE_ERROR("{0} is a version {1} scene, expected version {2}", path, header.Version, SceneSerializer::Version);
+			return false;
+		}
+
+		// The offsets against the size first, a sum with a corrupted one could wrap around
+		const uint64_t entitiesSize = (uint64_t)header.EntityCount * sizeof(EntityRecord);
+		const uint64_t offsetsSize = ((uint64_t)header.StringCount + 1) * sizeof(uint32_t);
+		if (header.EntitiesOffset > size || header.StringsOffset > size
+			|| entitiesSize > size - header.EntitiesOffset || offsetsSize > size - header.StringsOffset) {
+			SHADO_CORE_ERROR("{0} is truncated", path);
+			return false;
+		}
+		if (header.EntitiesOffset % alignof(EntityRecord) != 0 || header.StringsOffset % alignof(uint32_t) != 0) {
+			SHADO_CORE_ERROR("{0} has misaligned tables", path);
+			return false;
+		}
+		const uint64_t offsetsEnd = header.StringsOffset + offsetsSize;
+
+		const uint32_t* offsets = (const uint32_t*)(data + header.StringsOffset);
+		const char* characters = (const char*)(data + offsetsEnd);
+		const uint64_t charactersSize = size - offsetsEnd;
+
+		std::vector<std::string_view> strings(header.StringCount);
+		for (uint32_t i = 0; i < header.StringCount; i++) {
+			if (offsets[i] > offsets[i + 1] || offsets[i + 1] > charactersSize) {
+				SHADO_CORE_ERROR("{0} has a corrupted string table", path);
+				return false;
+			}
+			strings[i] = std::string_view(characters + offsets[i], offsets[i + 1] - offsets[i]);
+		}
+
+		m_Records = (const EntityRecord*)(data + header.EntitiesOffset);
+		m_EntityCount = header.EntityCount;
+		m_Strings = std::move(strings);
+
+		std::vector<bool> isTexture(m_Strings.size(), false);
+		for (uint32_t i = 0; i < m_EntityCount; i++) {
+			const uint32_t texture = m_Records[i].Texture;
+			if (texture < m_Strings.size() && !isTexture[texture]) {
+				isTexture[texture] = true;
+				m_TextureStrings.push_back(texture);
+			}
+		}
+
+		m_File = std::move(file);
+		return true;
+	}
+
+	SceneSerializer::SceneSerializer(Scene& scene)
+		: m_Scene(scene)
+	{
+	}
+
+	uint32_t SceneSerializer::instantiate(const EntityRecord* records, uint32_t count, const std::vector<std::string_view>& strings,
+		std::vector<Ref<Texture2D>>& textures, std::vector<Entity>* created) {
+		SHADO_PROFILE_FUNCTION();
+
+		if (textures.size() < strings.size())
+			textures.resize(strings.size());
+
+		EntityDefinition def;
+		uint32_t valid = 0;
+		uint32_t renumbered = 0;
+
+		for (uint32_t i = 0; i < count; i++) {
+			const EntityRecord& record = records[i];
+			if (record.Name >= strings.size() || (record.Texture != NoString && record.Texture >= strings.size())
+				|| record.Type > (uint8_t)EntityType::DYNAMIC) {
+				SHADO_CORE_WARN("Skipping invalid entity record {0}", i);
+				continue;
+			}
+
+			def.name.assign(strings[record.Name].data(), strings[record.Name].size());
+			def.type = (EntityType)record.Type;
+			def.position = { record.Position[0], record.Position[1], record.Position[2] };
+			def.rotation = record.Rotation;
+			def.scale = { record.Scale[0], record.Scale[1] };
+			def.tillingfactor = record.TilingFactor;
+			def.color = Color(record.Color[0], record.Color[1], record.Color[2], record.Color[3]);
+			def.density = record.Density;
+			def.friction = record.Friction;
+
+			def.texture = nullptr;
+			if (record.Texture != NoString) {
+				Ref<Texture2D>& texture = textures[record.Texture];
+				if (!texture)
+					texture = CreateRef<Texture2D>(std::string(strings[record.Texture]));
+				def.texture = texture;
+			}
+
+			// A text entity without an id keeps the fresh one addEntityToWorld gave it
+			Entity entity = m_Scene.addEntityToWorld(def);
+			if (record.Id != 0 && !m_Scene.setEntityId(entity.getHandle(), record.Id))
+				renumbered++;
+
+			b2Body* body = entity.getNativeBody();
+			body->SetLinearVelocity({ record.LinearVelocity[0], record.LinearVelocity[1] });
+			body->SetAngularVelocity(record.AngularVelocity);
+			if (!record.Awake)
+				body->SetAwake(false);
+
+			if (created)
+				created->push_back(entity);
+			valid++;
+		}
+
+		if (renumbered > 0)
+			SHADO_CORE_WARN("{0} loaded entities got new ids, theirs were already taken in the scene", renumbered);
+
+		return valid;
+	}
+
+	uint32_t SceneSerializer::instantiate(const SceneFile& file, uint32_t first, uint32_t count, std::vector<Ref<Texture2D>>& textures, std::vector<Entity>* created) {
+		SHADO_CORE_ASSERT(file.isOpen(), "The scene file isn't open");
+		if (first >= file.getEntityCount())
+			return 0;
+
+		// For the whole rest of the file, the next slices don't rehash
+		m_Scene.entitiesById.reserve(m_Scene.entitiesById.size() + file.getEntityCount() - first);
+
+		count = std::min(count, file.getEntityCount() - first);
+		return instantiate(file.m_Records + first, count, file.m_Strings, textures, created);
+	}
+
+	// =========================== BINARY ===========================
+
+	bool SceneSerializer::saveBinary(const std::string& path) const {
+		SHADO_PROFILE_FUNCTION();
+
+		StringTable strings;
+		const std::vector<EntityRecord> records = toRecords(m_Scene, strings);
+		return writeBinary(path, records, strings);
+	}
+
+	bool SceneSerializer::saveBinary(const std::string& path, const std::vector<Entity>& entities) const {
+		SHADO_PROFILE_FUNCTION();
+
+		StringTable strings;
+		const std::vector<EntityRecord> records = toRecords(m_Scene, strings, &entities);
+		return writeBinary(path, records, strings);
+	}
+
+	bool SceneSerializer::loadBinary(const std::string& path) {
+		SHADO_PROFILE_FUNCTION();
+
+		SceneFile file;
+		if (!file.open(path))
+			return false;
+
+		std::vector<Ref<Texture2D>> textures;
+		return instantiate(file, 0, file.getEntityCount(), textures) == file.getEntityCount();
+	}
+
+	// =========================== TEXT ===========================
+
+	static const char* const TypeNames[] = { "static", "kinematic", "dynamic" };
+
+	bool SceneSerializer::saveText(const std::string& path) const {
+		SHADO_PROFILE_FUNCTION();
+
+		StringTable strings;
+		const std::vector<EntityRecord> records = toRecords(m_Scene, strings);
+		const std::vector<const std::string*>& table = strings.getStrings();
+
+		std::ofstream file(path);
+		if (!file) {
+			SHADO_CORE_ERROR("Could not open {0} for writing", path);
+			return false;
+		}
+
+		// Enough digits to read back the same floats
+		file << std::setprecision(std::numeric_limits<float>::max_digits10);
+		file << "ShadoScene " << Version << "\n";
+
+		for (const EntityRecord& record : records) {
+			file << "\nentity\n";
+			file << "\tid " << record.Id << "\n";
+			file << "\tname " << std::quoted(*table[record.Name]) << "\n";
+			file << "\ttype " << TypeNames[record.Type] << "\n";
+			file << "\tposition " << record.Position[0] << " " << record.Position[1] << " " << record.Position[2] << "\n";
+			file << "\trotation " << record.Rotation << "\n";
+			file << "\tscale " << record.Scale[0] << " " << record.Scale[1] << "\n";
+			file << "\tcolor " << record.Color[0] << " " << record.Color[1] << " " << record.Color[2] << " " << record.Color[3] << "\n";
+			if (record.Texture != NoString)
+				file << "\ttexture " << std::quoted(*table[record.Texture]) << "\n";
+			file << "\ttilingFactor " << record.TilingFactor << "\n";
+			file << "\tdensity " << record.Density << "\n";
+			file << "\tfriction " << record.Friction << "\n";
+			file << "\tvelocity " << record.LinearVelocity[0] << " " << record.LinearVelocity[1] << "\n";
+			file << "\tangularVelocity " << record.AngularVelocity << "\n";
+			file << "\tawake " << (record.Awake ? "true" : "false") << "\n";
+			file << "end\n";
+		}
+
+		return (bool)file;
+	}
+
+	bool SceneSerializer::loadText(const std::string& path) {
+		SHADO_PROFILE_FUNCTION();
+
+		std::ifstream file(path);
+		if (!file) {
+			SHADO_CORE_ERROR("Could not open {0}", path);
+			return false;
+		}
+
+		std::string keyword;
+		uint32_t version = 0;
+		if (!(file >> keyword >> version) || keyword != "ShadoScene") {
+			SHADO_CORE_ERROR("{0} is not a text scene", path);
+			return false;
+		}
+		if (version != Version) {
+			SHADO_CORE_ERROR("{0} is a version {1} scene, expected version {2}", path, version, Version);
+			return false;
+		}
+
+		// Parsed into the same records as the binary format
+		std::vector<EntityRecord> records;
+		std::vector<std::string> table;
+		std::unordered_map<std::string, uint32_t> tableIndices;
+		auto addString = [&](const std::string& text) {
+			auto [it, inserted] = tableIndices.try_emplace(text, (uint32_t)table.size());
+			if (inserted)
+				table.push_back(text);
+			return it->second;
+		};
+
+		const EntityDefinition defaults;
+		auto fail = [&](const std::string& what) {
+			SHADO_CORE_ERROR("{0}: {1} in entity {2}", path, what, records.size());
+			return false;
+		};
+
+		while (file >> keyword) {
+			if (keyword != "entity")
+				return fail("Expected 'entity', found '" + keyword + "'");
+
+			EntityRecord record = {};
+			record.Id = 0;
+			record.Name = addString(defaults.name);
+			record.Texture = NoString;
+			record.Position[0] = defaults.position.x;
+			record.Position[1] = defaults.position.y;
+			record.Position[2] = defaults.position.z;
+			record.Rotation = defaults.rotation;
+			record.Scale[0] = defaults.scale.x;
+			record.Scale[1] = defaults.scale.y;
+			const glm::vec4 color = defaults.color;
+			for (int i = 0; i < 4; i++)
+				record.Color[i] = color[i];
+			record.TilingFactor = defaults.tillingfactor;
+			record.Density = defaults.density;
+			record.Friction = defaults.friction;
+			record.Type = (uint8_t)defaults.type;
+			record.Awake = 1;
+
+			std::string text;
+			while (file >> keyword && keyword != "end") {
+				bool read = true;
+				if (keyword == "id")
+					read = (bool)(file >> record.Id);
+				else if (keyword == "name") {
+					read = (bool)(file >> std::quoted(text));
+					record.Name = addString(text);
+				} else if (keyword == "texture") {
+					read = (bool)(file >> std::quoted(text));
+					record.Texture = addString(text);
+				} else if (keyword == "type") {
+					read = (bool)(file >> text);
+					uint8_t type = 0;
+					while (type < 3 && text != TypeNames[type])
+						type++;
+					if (type == 3)
+						return fail("Unknown type '" + text + "'");
+					record.Type = type;
+				} else if (keyword == "position")
+					read = (bool)(file >> record.Position[0] >> record.Position[1] >> record.Position[2]);
+				else if (keyword == "rotation")
+					read = (bool)(file >> record.Rotation);
+				else if (keyword == "scale")
+					read = (bool)(file >> record.Scale[0] >> record.Scale[1]);
+				else if (keyword == "color")
+					read = (bool)(file >> record.Color[0] >> record.Color[1] >> record.Color[2] >> record.Color[3]);
+				else if (keyword == "tilingFactor")
+					read = (bool)(file >> record.TilingFactor);
+				else if (keyword == "density")
+					read = (bool)(file >> record.Density);
+				else if (keyword == "friction")
+					read = (bool)(file >> record.Friction);
+				else if (keyword == "velocity")
+					read = (bool)(file >> record.LinearVelocity[0] >> record.LinearVelocity[1]);
+				else if (keyword == "angularVelocity")
+					read = (bool)(file >> record.AngularVelocity);
+				else if (keyword == "awake") {
+					read = (bool)(file >> text) && (text == "true" || text == "false");
+					record.Awake = text == "true" ? 1 : 0;
+				} else
+					return fail("Unknown property '" + keyword + "'");
+
+				if (!read)
+					return fail("Bad value for '" + keyword + "'");
+			}
+
+			if (keyword != "end")
+				return fail("Missing 'end'");
+
+			records.push_back(record);
+		}
+
+		std::vector<std::string_view> strings(table.begin(), table.end());
+		std::vector<Ref<Texture2D>> textures;
+		m_Scene.entitiesById.reserve(m_Scene.entitiesById.size() + records.size());
+		return instantiate(records.data(), (uint32_t)records.size(), strings, textures, nullptr) == records.size();
+	}
+}
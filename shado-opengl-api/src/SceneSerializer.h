@@ -0,0 +1,100 @@
+#pragma once
+
+#ifndef SCENE_SERIALIZER_H
+#define SCENE_SERIALIZER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "util/Util.h"
+
+namespace Shado {
+
+	class Entity;
+	class MappedFile;
+	class Scene;
+	class Texture2D;
+	struct EntityRecord;
+
+	/**
+	 * A binary scene mapped and checked, its entities not created yet. Opening one touches neither GL nor
+	 * Box2D so it can be done on a worker, SceneSerializer::instantiate then adds the entities on the main
+	 * thread, all at once or a slice at a time.
+	 */
+	class SceneFile {
+	public:
+		SceneFile();
+		~SceneFile();
+
+		SceneFile(const SceneFile&) = delete;
+		SceneFile& operator=(const SceneFile&) = delete;
+
+		// Logs why it failed
+		bool open(const std::string& path);
+		// Unmaps the file, the strings go with it
+		void close();
+		bool isOpen() const { return m_File != nullptr; }
+
+		uint32_t getEntityCount() const { return m_EntityCount; }
+		std::string_view getString(uint32_t index) const { return m_Strings[index]; }
+		uint32_t getStringCount() const { return (uint32_t)m_Strings.size(); }
+		// Strings used as texture paths by the entities, each once
+		const std::vector<uint32_t>& getTextureStrings() const { return m_TextureStrings; }
+
+	private:
+		ScopedPtr<MappedFile> m_File;
+		const EntityRecord* m_Records = nullptr;
+		uint32_t m_EntityCount = 0;
+		std::vector<std::string_view> m_Strings;
+		std::vector<uint32_t> m_TextureStrings;
+
+		friend class SceneSerializer;
+	};
+
+	/**
+	 * Saves the entities of a scene (their EntityDefinition, rotation, velocities, sleep state, id) and adds
+	 * them back to a scene. Textures are saved as the path they were loaded from, each path is loaded once.
+	 *
+	 * Binary (.shscene): a header, then an array of fixed size entity records, then a string table holding
+	 * the names and the texture paths. Loading maps the file and creates the entities straight from the
+	 * records, nothing is parsed. Little endian, like every host the engine runs on.
+	 *
+	 * Text: the same data as an "entity ... end" block per entity, one property per line, meant to be
+	 * read and diffed. Properties left out keep the EntityDefinition defaults.
+	 *
+	 * Saved ids are restored so references to them survive a reload, unless an entity of the scene already
+	 * has one. Loading adds to the scene, it doesn't clear it.
+	 */
+	class SceneSerializer {
+	public:
+		static constexpr uint32_t Version = 1;
+
+		SceneSerializer(Scene& scene);
+
+		bool saveBinary(const std::string& path) const;
+		// Only these entities of the scene
+		bool saveBinary(const std::string& path, const std::vector<Entity>& entities) const;
+		bool loadBinary(const std::string& path);
+
+		/**
+		 * Adds the entities [first, first + count[ of an opened file, clipped to its entity count, so a big file
+		 * can be added over several frames. `textures` is by string of the file: null entries are loaded from
+		 * their path and kept there for the next slices. The entities made are appended to `created` if given.
+		 * Returns how many entities of the slice were valid
+		 */
+		uint32_t instantiate(const SceneFile& file, uint32_t first, uint32_t count, std::vector<Ref<Texture2D>>& textures, std::vector<Entity>* created = nullptr);
+
+		bool saveText(const std::string& path) const;
+		bool loadText(const std::string& path);
+
+	private:
+		// Adds the entities of the records, returns how many were valid. `strings` is the file's string table
+		uint32_t instantiate(const EntityRecord* records, uint32_t count, const std::vector<std::string_view>& strings,
+			std::vector<Ref<Texture2D>>& textures, std::vector<Entity>* created);
+
+	private:
+		Scene& m_Scene;
+	};
+}
+
+#endif
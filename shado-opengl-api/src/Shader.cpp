@@ -3,6 +3,8 @@
 #include <fstream>
 #include <array>
 #include "Debug.h"
+#include "RenderState.h"
+#include "RenderCommandQueue.h"
 #include "glm/gtc/type_ptr.hpp"
 
 namespace Shado {
@@ -54,9 +56,10 @@ namespace Shado {
 
 	Shader::~Shader()
 	{
-
-
-		glDeleteProgram(m_Renderer2DID);
+		RenderCommandQueue::Submit([id = m_Renderer2DID]() {
+			RenderState::OnProgramDeleted(id);
+			glDeleteProgram(id);
+		});
 	}
 
 	std::string Shader::readFile(const std::string& filepath)
@@ -189,12 +192,12 @@ namespace Shado {
 
 	void Shader::bind() const
 	{
-		glUseProgram(m_Renderer2DID);
+		RenderState::UseProgram(m_Renderer2DID);
 	}
 
 	void Shader::unbind() const
 	{
-		glUseProgram(0);
+		RenderState::UseProgram(0);
 	}
 
 	void Shader::setInt(const std::string& name, int value)
@@ -12,7 +12,16 @@
 #include "Buffer.h"
 #include "Texture2D.h"
 #include "VertexArray.h"
+#include "Framebuffer.h"
+#include "GpuTimer.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "Stats.h"
 #include "Entity.h"
+#include "SceneSerializer.h"
+#include "WorldPartition.h"
+#include "ecs/Registry.h"
+#include "ecs/Components.h"
 
 #include "cameras/Camera.h"
 #include "cameras/OrthoCamera.h"
@@ -35,6 +44,18 @@
 #include "util/Util.h"
 #include "util/random.h"
 #include "util/ParticuleSystem.h"
+#include "util/Bounds.h"
+#include "util/DynamicBVH.h"
+#include "util/FrameLimiter.h"
+#include "util/TimerWheel.h"
+#include "util/DynamicResolution.h"
+#include "util/ImageWriter.h"
+#include "util/MappedFile.h"
+#include "OcclusionCuller.h"
+#include "GpuBufferArena.h"
+#include "Tilemap.h"
+#include "RenderState.h"
+#include "RenderCommandQueue.h"
 #include "Objects3D/Object3D.h"
 #include "Objects3D/Sphere.h"
 #include "Objects3D/Cube.h"
@@ -0,0 +1,124 @@
+#include "Stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include "Debug.h"
+
+namespace Shado {
+
+	struct StatsData {
+		std::mutex Mutex;	// Registration only
+		std::unordered_map<std::string, StatHandle> Handles;
+		StatInfo Infos[Stats::MaxStats];
+		std::atomic<uint32_t> Count = 0;
+
+		std::atomic<int64_t> Current[Stats::MaxStats] = {};
+
+		// HistorySize rows of MaxStats values, a ring indexed by the frame count
+		std::vector<int64_t> History = std::vector<int64_t>((size_t)Stats::HistorySize * Stats::MaxStats, 0);
+		uint64_t Frames = 0;
+	};
+
+	// Handles are registered from static initializers of other files, the data must be there first
+	static StatsData& getData() {
+		static StatsData data;
+		return data;
+	}
+
+	StatHandle Stats::Register(const std::string& name, StatKind kind, StatUnit unit) {
+		StatsData& data = getData();
+		std::lock_guard<std::mutex> lock(data.Mutex);
+
+		auto it = data.Handles.find(name);
+		if (it != data.Handles.end()) {
+			SHADO_CORE_ASSERT(data.Infos[it->second].Kind == kind && data.Infos[it->second].Unit == unit,
+				"Stat registered twice with a different kind or unit");
+			return it->second;
+		}
+
+		const uint32_t count = data.Count.load(std::memory_order_relaxed);
+		if (count >= MaxStats) {
+			SHADO_CORE_ERROR("Too many stats, {0} isn't recorded", name);
+			return InvalidStat;
+		}
+
+		data.Infos[count] = { name, kind, unit };
+		data.Handles[name] = count;
+		// Readers check the handle against the count, the info must be written before
+		data.Count.store(count + 1, std::memory_order_release);
+		return count;
+	}
+
+	StatHandle Stats::Find(const std::string& name) {
+		StatsData& data = getData();
+		std::lock_guard<std::mutex> lock(data.Mutex);
+
+		auto it = data.Handles.find(name);
+		return it != data.Handles.end() ? it->second : InvalidStat;
+	}
+
+	void Stats::Add(StatHandle stat, int64_t value) {
+		if (stat < MaxStats)
+			getData().Current[stat].fetch_add(value, std::memory_order_relaxed);
+	}
+
+	void Stats::Set(StatHandle stat, int64_t value) {
+		if (stat < MaxStats)
+			getData().Current[stat].store(value, std::memory_order_relaxed);
+	}
+
+	void Stats::EndFrame() {
+		StatsData& data = getData();
+		const uint32_t count = data.Count.load(std::memory_order_acquire);
+		int64_t* row = &data.History[(data.Frames % HistorySize) * MaxStats];
+
+		for (uint32_t i = 0; i < count; i++) {
+			// A count added between the two would be lost, exchange takes the value and resets it at once
+			if (data.Infos[i].Kind == StatKind::PerFrame)
+				row[i] = data.Current[i].exchange(0, std::memory_order_relaxed);
+			else
+				row[i] = data.Current[i].load(std::memory_order_relaxed);
+		}
+
+		data.Frames++;
+	}
+
+	uint32_t Stats::GetCount() {
+		return getData().Count.load(std::memory_order_acquire);
+	}
+
+	const StatInfo& Stats::GetInfo(StatHandle stat) {
+		SHADO_CORE_ASSERT(stat < GetCount(), "Invalid stat handle");
+		return getData().Infos[stat];
+	}
+
+	int64_t Stats::GetValue(StatHandle stat) {
+		const StatsData& data = getData();
+		if (stat >= MaxStats || data.Frames == 0)
+			return 0;
+
+		return data.History[((data.Frames - 1) % HistorySize) * MaxStats + stat];
+	}
+
+	int64_t Stats::GetValue(const std::string& name) {
+		return GetValue(Find(name));
+	}
+
+	void Stats::GetHistory(StatHandle stat, std::vector<int64_t>& values) {
+		const StatsData& data = getData();
+		values.clear();
+		if (stat >= MaxStats)
+			return;
+
+		const uint64_t frames = std::min<uint64_t>(data.Frames, HistorySize);
+		values.reserve(frames);
+		for (uint64_t frame = data.Frames - frames; frame < data.Frames; frame++)
+			values.push_back(data.History[(frame % HistorySize) * MaxStats + stat]);
+	}
+
+	uint64_t Stats::GetFrameCount() {
+		return getData().Frames;
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Shado {
+
+	// Values are integers, times are kept in microseconds and shown in ms
+	enum class StatUnit { Count, Bytes, Microseconds };
+
+	// Per frame stats go back to 0 every frame, gauges (memory in use...) keep their value
+	enum class StatKind { PerFrame, Gauge };
+
+	using StatHandle = uint32_t;
+	constexpr StatHandle InvalidStat = 0xFFFFFFFF;
+
+	struct StatInfo {
+		std::string Name;
+		StatKind Kind;
+		StatUnit Unit;
+	};
+
+	/**
+	 * Registry of the engine's counters, every renderer reports here under "Group.Name".
+	 *
+	 * Add and Set are a relaxed atomic each and can be called from any thread (the render thread counts
+	 * the binds). EndFrame, once per frame from the main thread, snapshots every stat into a history of
+	 * the last frames and resets the per frame ones. Values read back are those of the last snapshot, so
+	 * they don't move while the frame is being recorded.
+	 *
+	 * Handles are registered once and kept, usually in a static:
+	 *     static const StatHandle s_DrawCalls = Stats::Register("MyRenderer.DrawCalls");
+	 *     Stats::Add(s_DrawCalls);
+	 */
+	class Stats {
+	public:
+		static constexpr uint32_t MaxStats = 256;
+		static constexpr uint32_t HistorySize = 240;
+
+		// Registering a name again gives back the same handle
+		static StatHandle Register(const std::string& name, StatKind kind = StatKind::PerFrame, StatUnit unit = StatUnit::Count);
+		static StatHandle Find(const std::string& name);
+
+		static void Add(StatHandle stat, int64_t value = 1);
+		static void Set(StatHandle stat, int64_t value);
+
+		// Main thread, once per frame
+		static void EndFrame();
+
+		static uint32_t GetCount();
+		static const StatInfo& GetInfo(StatHandle stat);
+		// At the last EndFrame
+		static int64_t GetValue(StatHandle stat);
+		static int64_t GetValue(const std::string& name);
+		// Oldest first, at most HistorySize frames
+		static void GetHistory(StatHandle stat, std::vector<int64_t>& values);
+		static uint64_t GetFrameCount();
+	};
+}
+
+#endif
@@ -1,6 +1,9 @@
 ﻿#include "Texture2D.h"
 
 #include "Debug.h"
+#include "RenderState.h"
+#include "RenderCommandQueue.h"
+#include "Stats.h"
 
 
 #include "stb_image.h"
@@ -8,6 +11,13 @@
 #include <GLFW/glfw3.h>
 
 namespace Shado {
+
+	static const StatHandle s_TextureMemory = Stats::Register("GPU.TextureMemory", StatKind::Gauge, StatUnit::Bytes);
+	static const StatHandle s_BytesUploaded = Stats::Register("GPU.BytesUploaded", StatKind::PerFrame, StatUnit::Bytes);
+
+	static int64_t textureBytes(uint32_t width, uint32_t height, GLenum internalFormat) {
+		return (int64_t)width * height * (internalFormat == GL_RGB8 ? 3 : 4);
+	}
 	
 	Texture2D::Texture2D(uint32_t width, uint32_t height)
 		: m_Width(width), m_Height(height) {
@@ -17,6 +27,7 @@ namespace Shado {
 
 		glCreateTextures(GL_TEXTURE_2D, 1, &m_RendererID);
 		glTextureStorage2D(m_RendererID, 1, m_InternalFormat, m_Width, m_Height);
+		Stats::Add(s_TextureMemory, textureBytes(m_Width, m_Height, m_InternalFormat));
 
 		glTextureParameteri(m_RendererID, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTextureParameteri(m_RendererID, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -25,27 +36,58 @@ namespace Shado {
 		glTextureParameteri(m_RendererID, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	}
 
-	Texture2D::Texture2D(const std::string& path)
-		: m_RendererID(0), m_Width(0), m_Height(0)
+	TextureImage::TextureImage(const std::string& path)
+		: m_Path(path)
 	{
-		int width, height, channels;
-		stbi_set_flip_vertically_on_load(1);
-		
-		stbi_uc* data = nullptr;
-		{
-			data = stbi_load(path.c_str(), &width, &height, &channels, 0);
+		// Per thread, workers decode images side by side
+		stbi_set_flip_vertically_on_load_thread(1);
+		m_Pixels = stbi_load(path.c_str(), &m_Width, &m_Height, &m_Channels, 0);
+	}
+
+	TextureImage::~TextureImage() {
+		if (m_Pixels)
+			stbi_image_free(m_Pixels);
+	}
+
+	TextureImage::TextureImage(TextureImage&& other) noexcept
+		: m_Path(std::move(other.m_Path)), m_Width(other.m_Width), m_Height(other.m_Height), m_Channels(other.m_Channels), m_Pixels(other.m_Pixels)
+	{
+		other.m_Pixels = nullptr;
+	}
+
+	TextureImage& TextureImage::operator=(TextureImage&& other) noexcept {
+		if (this != &other) {
+			if (m_Pixels)
+				stbi_image_free(m_Pixels);
+
+			m_Path = std::move(other.m_Path);
+			m_Width = other.m_Width;
+			m_Height = other.m_Height;
+			m_Channels = other.m_Channels;
+			m_Pixels = other.m_Pixels;
+			other.m_Pixels = nullptr;
 		}
-		
-		SHADO_CORE_ASSERT(data, "Failed to load image!");
-		m_Width = width;
-		m_Height = height;
+		return *this;
+	}
+
+	Texture2D::Texture2D(const std::string& path)
+		: Texture2D(TextureImage(path))
+	{
+	}
+
+	Texture2D::Texture2D(const TextureImage& image)
+		: m_RendererID(0), m_Width(0), m_Height(0), m_FilePath(image.getPath())
+	{
+		SHADO_CORE_ASSERT(image.isValid(), "Failed to load image!");
+		m_Width = image.getWidth();
+		m_Height = image.getHeight();
 
 		GLenum internalFormat = 0, dataFormat = 0;
-		if (channels == 4)
+		if (image.getChannels() == 4)
 		{
 			internalFormat = GL_RGBA8;
 			dataFormat = GL_RGBA;
-		} else if (channels == 3)
+		} else if (image.getChannels() == 3)
 		{
 			internalFormat = GL_RGB8;
 			dataFormat = GL_RGB;
@@ -58,6 +100,7 @@ namespace Shado {
 
 		glCreateTextures(GL_TEXTURE_2D, 1, &m_RendererID);
 		glTextureStorage2D(m_RendererID, 1, internalFormat, m_Width, m_Height);
+		Stats::Add(s_TextureMemory, textureBytes(m_Width, m_Height, internalFormat));
 
 		glTextureParameteri(m_RendererID, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTextureParameteri(m_RendererID, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -65,23 +108,28 @@ namespace Shado {
 		glTextureParameteri(m_RendererID, GL_TEXTURE_WRAP_S, GL_REPEAT);
 		glTextureParameteri(m_RendererID, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-		glTextureSubImage2D(m_RendererID, 0, 0, 0, m_Width, m_Height, dataFormat, GL_UNSIGNED_BYTE, data);
-
-		stbi_image_free(data);
+		glTextureSubImage2D(m_RendererID, 0, 0, 0, m_Width, m_Height, dataFormat, GL_UNSIGNED_BYTE, image.getPixels());
+		Stats::Add(s_BytesUploaded, textureBytes(m_Width, m_Height, internalFormat));
 	}
 
 	Texture2D::~Texture2D() {
-		glDeleteTextures(1, &m_RendererID);
+		Stats::Add(s_TextureMemory, -textureBytes(m_Width, m_Height, m_InternalFormat));
+
+		RenderCommandQueue::Submit([id = m_RendererID]() {
+			RenderState::OnTextureDeleted(id);
+			glDeleteTextures(1, &id);
+		});
 	}
 
 	void Texture2D::setData(void* data, uint32_t size) {
 		uint32_t bpp = m_DataFormat == GL_RGBA ? 4 : 3;
 		SHADO_CORE_ASSERT(size == m_Width * m_Height * bpp, "Data must be entire texture!");
 		glTextureSubImage2D(m_RendererID, 0, 0, 0, m_Width, m_Height, m_DataFormat, GL_UNSIGNED_BYTE, data);
+		Stats::Add(s_BytesUploaded, size);
 	}
 
 	void Texture2D::bind(uint32_t slot) const {
-		glBindTextureUnit(slot, m_RendererID);
+		RenderState::BindTextureUnit(slot, m_RendererID);
 	}
 
 	void Texture2D::unbind() const {
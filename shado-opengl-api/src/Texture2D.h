@@ -2,11 +2,43 @@
 #include <string>
 
 namespace Shado {
+
+	/**
+	 * Pixels of an image file, decoded without touching GL so it can be done on any thread. A Texture2D
+	 * made from it on the main thread only has to upload them
+	 */
+	class TextureImage {
+	public:
+		TextureImage() = default;
+		// Flipped like Texture2D(path) does. Invalid when the file couldn't be decoded
+		TextureImage(const std::string& path);
+		~TextureImage();
+
+		TextureImage(TextureImage&& other) noexcept;
+		TextureImage& operator=(TextureImage&& other) noexcept;
+		TextureImage(const TextureImage&) = delete;
+		TextureImage& operator=(const TextureImage&) = delete;
+
+		bool isValid() const { return m_Pixels != nullptr; }
+
+		const std::string& getPath() const { return m_Path; }
+		int getWidth() const { return m_Width; }
+		int getHeight() const { return m_Height; }
+		int getChannels() const { return m_Channels; }
+		const unsigned char* getPixels() const { return m_Pixels; }
+
+	private:
+		std::string m_Path;
+		int m_Width = 0, m_Height = 0, m_Channels = 0;
+		unsigned char* m_Pixels = nullptr;
+	};
 	
 	class Texture2D {
 	public:
 		Texture2D(uint32_t width, uint32_t height);
 		Texture2D(const std::string& path);
+		// Uploads an image decoded ahead, the path is the image's
+		Texture2D(const TextureImage& image);
 		~Texture2D();
 
 		void setData(void* data, uint32_t size);
@@ -17,6 +49,8 @@ namespace Shado {
 		int getWidth() const { return m_Width; }
 		int getHeight() const { return m_Height; }
 		uint32_t getRendererID() const { return m_RendererID; }
+		// Empty when the texture wasn't loaded from a file
+		const std::string& getFilePath() const { return m_FilePath; }
 
 		bool operator==(const Texture2D& other) const
 		{
@@ -0,0 +1,207 @@
+#include "Tilemap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/packing.hpp>
+#include "Debug.h"
+#include "GpuBufferArena.h"
+#include "Profiler.h"
+#include "Renderer2D.h"
+#include "Stats.h"
+
+namespace Shado {
+
+	static constexpr uint32_t TilesPerChunk = Tilemap::ChunkSize * Tilemap::ChunkSize;
+
+	struct TilemapStats {
+		StatHandle ChunksDrawn = Stats::Register("Tilemap.ChunksDrawn");
+		StatHandle ChunksCulled = Stats::Register("Tilemap.ChunksCulled");
+		StatHandle ChunksRebuilt = Stats::Register("Tilemap.ChunksRebuilt");
+	};
+	static TilemapStats s_Stats;
+
+	// 0 1 2 2 3 0 for every tile a chunk can hold, the arena narrows them to 16 bits
+	static const std::vector<uint32_t>& getChunkIndices() {
+		static const std::vector<uint32_t> indices = []() {
+			std::vector<uint32_t> result(TilesPerChunk * 6);
+			for (uint32_t quad = 0; quad < TilesPerChunk; quad++) {
+				const uint32_t vertex = quad * 4;
+				const uint32_t index = quad * 6;
+				result[index + 0] = vertex + 0;
+				result[index + 1] = vertex + 1;
+				result[index + 2] = vertex + 2;
+				result[index + 3] = vertex + 2;
+				result[index + 4] = vertex + 3;
+				result[index + 5] = vertex + 0;
+			}
+			return result;
+		}();
+		return indices;
+	}
+
+	Tilemap::Tilemap(uint32_t width, uint32_t height, const Ref<Texture2D>& atlas, uint32_t atlasColumns, uint32_t atlasRows)
+		: m_Width(width), m_Height(height),
+		m_ChunksX((width + ChunkSize - 1) / ChunkSize), m_ChunksY((height + ChunkSize - 1) / ChunkSize),
+		m_Atlas(atlas), m_AtlasColumns(std::max(1u, atlasColumns)), m_AtlasRows(std::max(1u, atlasRows))
+	{
+		m_Tiles.resize((size_t)m_ChunksX * m_ChunksY * TilesPerChunk, Empty);
+		m_Chunks.resize((size_t)m_ChunksX * m_ChunksY);
+		m_Arena = GpuBufferArena::get(Renderer2D::GetTileVertexLayout());
+	}
+
+	Tilemap::~Tilemap() = default;
+
+	uint32_t Tilemap::getTileIndex(uint32_t x, uint32_t y) const {
+		const uint32_t chunk = (y / ChunkSize) * m_ChunksX + x / ChunkSize;
+		return chunk * TilesPerChunk + (y % ChunkSize) * ChunkSize + x % ChunkSize;
+	}
+
+	void Tilemap::setTile(uint32_t x, uint32_t y, uint16_t tile) {
+		if (x >= m_Width || y >= m_Height)
+			return;
+
+		uint16_t& current = m_Tiles[getTileIndex(x, y)];
+		if (current == tile)
+			return;
+
+		current = tile;
+		m_Chunks[(y / ChunkSize) * m_ChunksX + x / ChunkSize].dirty = true;
+	}
+
+	uint16_t Tilemap::getTile(uint32_t x, uint32_t y) const {
+		if (x >= m_Width || y >= m_Height)
+			return Empty;
+
+		return m_Tiles[getTileIndex(x, y)];
+	}
+
+	void Tilemap::fill(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint16_t tile) {
+		const uint32_t endX = (uint32_t)std::min<uint64_t>((uint64_t)x + width, m_Width);
+		const uint32_t endY = (uint32_t)std::min<uint64_t>((uint64_t)y + height, m_Height);
+
+		for (uint32_t row = y; row < endY; row++) {
+			for (uint32_t column = x; column < endX; column++)
+				setTile(column, row, tile);
+		}
+	}
+
+	void Tilemap::setPosition(const glm::vec3& position) {
+		m_Position = position;
+		markAllDirty();
+	}
+
+	void Tilemap::setTileSize(const glm::vec2& size) {
+		m_TileSize = size;
+		markAllDirty();
+	}
+
+	void Tilemap::setAtlas(const Ref<Texture2D>& atlas, uint32_t atlasColumns, uint32_t atlasRows) {
+		m_Atlas = atlas;
+		m_AtlasColumns = std::max(1u, atlasColumns);
+		m_AtlasRows = std::max(1u, atlasRows);
+		markAllDirty();
+	}
+
+	void Tilemap::markAllDirty() {
+		for (Chunk& chunk : m_Chunks)
+			chunk.dirty = true;
+	}
+
+	bool Tilemap::worldToTile(const glm::vec2& position, uint32_t& x, uint32_t& y) const {
+		const float column = std::floor((position.x - m_Position.x) / m_TileSize.x);
+		const float row = std::floor((position.y - m_Position.y) / m_TileSize.y);
+		if (column < 0.0f || row < 0.0f || column >= (float)m_Width || row >= (float)m_Height)
+			return false;
+
+		x = (uint32_t)column;
+		y = (uint32_t)row;
+		return true;
+	}
+
+	void Tilemap::GetCellTexCoords(uint16_t tile, uint32_t atlasColumns, uint32_t atlasRows, glm::vec2& min, glm::vec2& max) {
+		// Textures are flipped on load, v = 1 is the top row of the atlas. Each edge is computed on its own
+		// so neighbouring cells share it exactly
+		const uint32_t cell = (uint32_t)(tile - 1) % (atlasColumns * atlasRows);
+		const uint32_t column = cell % atlasColumns;
+		const uint32_t row = cell / atlasColumns;
+		min = { (float)column / atlasColumns, 1.0f - (float)(row + 1) / atlasRows };
+		max = { (float)(column + 1) / atlasColumns, 1.0f - (float)row / atlasRows };
+	}
+
+	AABB Tilemap::getChunkBounds(uint32_t chunkX, uint32_t chunkY) const {
+		const glm::vec3 chunkSize = { m_TileSize.x * ChunkSize, m_TileSize.y * ChunkSize, 0.0f };
+		const glm::vec3 min = m_Position + glm::vec3(chunkSize.x * chunkX, chunkSize.y * chunkY, 0.0f);
+		return { min, min + chunkSize };
+	}
+
+	void Tilemap::draw(const Camera& camera) {
+		SHADO_PROFILE_FUNCTION();
+
+		Frustum frustum(camera.getViewProjectionMatrix());
+
+		uint32_t drawn = 0;
+		for (uint32_t chunkY = 0; chunkY < m_ChunksY; chunkY++) {
+			for (uint32_t chunkX = 0; chunkX < m_ChunksX; chunkX++) {
+				if (!frustum.intersects(getChunkBounds(chunkX, chunkY)))
+					continue;
+
+				// Rebuilt once seen, edits far from the camera cost nothing until then
+				Chunk& chunk = m_Chunks[chunkY * m_ChunksX + chunkX];
+				if (chunk.dirty)
+					rebuild(chunkX, chunkY);
+
+				if (chunk.mesh) {
+					Renderer2D::DrawQuadMesh(chunk.mesh, m_Atlas);
+					drawn++;
+				}
+			}
+		}
+
+		Stats::Add(s_Stats.ChunksDrawn, drawn);
+		Stats::Add(s_Stats.ChunksCulled, m_Chunks.size() - drawn);
+	}
+
+	void Tilemap::rebuild(uint32_t chunkX, uint32_t chunkY) {
+		Chunk& chunk = m_Chunks[chunkY * m_ChunksX + chunkX];
+		chunk.dirty = false;
+		chunk.mesh = nullptr;		// Its range goes back to the arena once the frames drawing it are done
+
+		const uint16_t* tiles = &m_Tiles[(size_t)(chunkY * m_ChunksX + chunkX) * TilesPerChunk];
+
+		const uint32_t white = 0xFFFFFFFF;
+		const uint16_t tilingFactor = glm::packHalf1x16(1.0f);
+		const AABB bounds = getChunkBounds(chunkX, chunkY);
+
+		std::vector<Renderer2D::TileVertex> vertices;
+		vertices.reserve(TilesPerChunk * 4);
+
+		for (uint32_t row = 0; row < ChunkSize; row++) {
+			for (uint32_t column = 0; column < ChunkSize; column++) {
+				const uint16_t tile = tiles[row * ChunkSize + column];
+				if (tile == Empty)
+					continue;
+
+				glm::vec2 uv0, uv1;
+				GetCellTexCoords(tile, m_AtlasColumns, m_AtlasRows, uv0, uv1);
+
+				const float x0 = bounds.min.x + column * m_TileSize.x;
+				const float y0 = bounds.min.y + row * m_TileSize.y;
+				const float x1 = x0 + m_TileSize.x;
+				const float y1 = y0 + m_TileSize.y;
+
+				// Same corner order as Renderer2D's quads
+				const glm::vec3 positions[4] = { { x0, y0, m_Position.z }, { x1, y0, m_Position.z }, { x1, y1, m_Position.z }, { x0, y1, m_Position.z } };
+				const glm::vec2 texCoords[4] = { { uv0.x, uv0.y }, { uv1.x, uv0.y }, { uv1.x, uv1.y }, { uv0.x, uv1.y } };
+				for (int corner = 0; corner < 4; corner++)
+					vertices.push_back({ positions[corner], white, texCoords[corner], 0, tilingFactor });
+			}
+		}
+
+		Stats::Add(s_Stats.ChunksRebuilt);
+		if (vertices.empty())
+			return;
+
+		const uint32_t quadCount = (uint32_t)vertices.size() / 4;
+		chunk.mesh = m_Arena->allocate(vertices.data(), (uint32_t)vertices.size(), getChunkIndices().data(), quadCount * 6);
+	}
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#ifndef TILEMAP_H
+#define TILEMAP_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include "cameras/Camera.h"
+#include "Texture2D.h"
+#include "util/Bounds.h"
+#include "util/Util.h"
+
+namespace Shado {
+
+	class GpuBufferArena;
+	class GpuMesh;
+
+	/**
+	 * Grid of tiles taken from a texture atlas. Tile ids are 16 bits: Empty (0) is no tile, id n is cell n - 1
+	 * of the atlas, counted left to right from the top row.
+	 *
+	 * The map is cut in chunks of ChunkSize x ChunkSize tiles, the ids of a chunk are contiguous. Each chunk
+	 * is a mesh of its non empty tiles in the GpuBufferArena of Renderer2D's tile vertices. Editing a tile
+	 * only marks its chunk dirty, the next draw rebuilds the dirty chunks it sees. Drawing tests the chunks
+	 * against the camera and draws the visible ones through Renderer2D's texture shader, one call each.
+	 */
+	class Tilemap {
+	public:
+		static constexpr uint32_t ChunkSize = 32;
+		static constexpr uint16_t Empty = 0;
+
+		// atlasColumns x atlasRows cells of the same size. A null atlas draws the tiles white
+		Tilemap(uint32_t width, uint32_t height, const Ref<Texture2D>& atlas, uint32_t atlasColumns = 1, uint32_t atlasRows = 1);
+		~Tilemap();
+
+		Tilemap(const Tilemap&) = delete;
+		Tilemap& operator=(const Tilemap&) = delete;
+
+		// Out of the map, setting does nothing and getting returns Empty
+		void setTile(uint32_t x, uint32_t y, uint16_t tile);
+		uint16_t getTile(uint32_t x, uint32_t y) const;
+		// Clipped to the map
+		void fill(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint16_t tile);
+		void clear() { fill(0, 0, m_Width, m_Height, Empty); }
+
+		// World position of the bottom left corner of tile (0, 0). Every chunk is rebuilt
+		void setPosition(const glm::vec3& position);
+		// World size of a tile. Every chunk is rebuilt
+		void setTileSize(const glm::vec2& size);
+		void setAtlas(const Ref<Texture2D>& atlas, uint32_t atlasColumns, uint32_t atlasRows);
+
+		// Tile under a world position, false outside of the map
+		bool worldToTile(const glm::vec2& position, uint32_t& x, uint32_t& y) const;
+
+		// Texture coordinates of the corners of a tile's cell in an atlas of atlasColumns x atlasRows cells
+		static void GetCellTexCoords(uint16_t tile, uint32_t atlasColumns, uint32_t atlasRows, glm::vec2& min, glm::vec2& max);
+
+		/**
+		 * Draws the chunks visible by the camera. Must be called between Renderer2D::BeginScene and EndScene
+		 */
+		void draw(const Camera& camera);
+
+		uint32_t getWidth()					const { return m_Width; }
+		uint32_t getHeight()				const { return m_Height; }
+		const glm::vec3& getPosition()		const { return m_Position; }
+		const glm::vec2& getTileSize()		const { return m_TileSize; }
+		const Ref<Texture2D>& getAtlas()	const { return m_Atlas; }
+		uint32_t getChunkCount()			const { return (uint32_t)m_Chunks.size(); }
+
+	private:
+		struct Chunk {
+			Ref<GpuMesh> mesh;		// Null when the chunk has no tile
+			bool dirty = false;
+		};
+
+		uint32_t getTileIndex(uint32_t x, uint32_t y) const;
+		AABB getChunkBounds(uint32_t chunkX, uint32_t chunkY) const;
+		void rebuild(uint32_t chunkX, uint32_t chunkY);
+		void markAllDirty();
+
+	private:
+		uint32_t m_Width, m_Height;
+		uint32_t m_ChunksX, m_ChunksY;
+		std::vector<uint16_t> m_Tiles;		// Chunk by chunk, row by row within a chunk
+		std::vector<Chunk> m_Chunks;		// Row by row
+
+		glm::vec3 m_Position = { 0.0f, 0.0f, 0.0f };
+		glm::vec2 m_TileSize = { 1.0f, 1.0f };
+
+		Ref<Texture2D> m_Atlas;
+		uint32_t m_AtlasColumns, m_AtlasRows;
+
+		Ref<GpuBufferArena> m_Arena;		// Kept so its pages outlive the chunks being rebuilt
+	};
+}
+
+#endif
@@ -1,7 +1,8 @@
 #include "VertexArray.h"
 #include <memory>
 #include "Buffer.h"
-#include "Renderer2D.h"
+#include "RenderState.h"
+#include "RenderCommandQueue.h"
 #include <GL/glew.h>
 
 namespace Shado {
@@ -22,90 +23,152 @@ namespace Shado {
 		case ShaderDataType::Int3:		return GL_INT;
 		case ShaderDataType::Int4:		return GL_INT;
 		case ShaderDataType::Bool:		return GL_BOOL;
+		case ShaderDataType::UByte4Norm:	return GL_UNSIGNED_BYTE;
+		case ShaderDataType::Half:		return GL_HALF_FLOAT;
+		case ShaderDataType::Half2:		return GL_HALF_FLOAT;
+		case ShaderDataType::Half4:		return GL_HALF_FLOAT;
+		case ShaderDataType::Int10_10_10_2:	return GL_INT_2_10_10_10_REV;
+		case ShaderDataType::UShort:	return GL_UNSIGNED_SHORT;
 		}
 		SHADO_CORE_ASSERT(false, "Unknown ShaderDataType");
 		return 0;
 	}
 
 	VertexArray::VertexArray() {
-		glCreateVertexArrays(1, &m_RendererID);
 	}
 
 	VertexArray::~VertexArray() {
-		glDeleteVertexArrays(1, &m_RendererID);
+		if (!m_RendererID)
+			return;
+
+		RenderCommandQueue::Submit([id = m_RendererID]() {
+			RenderState::OnVertexArrayDeleted(id);
+			glDeleteVertexArrays(1, &id);
+		});
 	}
 
 	void VertexArray::bind() const {
-		glBindVertexArray(m_RendererID);
-		//m_IndexBuffers->bind();
+		if (m_Dirty)
+			apply();
+
+		RenderState::BindVertexArray(m_RendererID);
 	}
 
 	void VertexArray::unBind() const {
-		glBindVertexArray(0);
+		RenderState::BindVertexArray(0);
+	}
+
+	uint32_t VertexArray::addLayout(const BufferLayout& layout) {
+
+		SHADO_CORE_ASSERT(layout.getElements().size(), "Vertex buffer has no layout!");
+
+		const uint32_t binding = (uint32_t)m_VertexBuffers.size();
+
+		m_Layouts.push_back(layout);
+		m_VertexBuffers.push_back(nullptr);
+		m_Dirty = true;
+		return binding;
 	}
 
 	void VertexArray::addVertexBuffer(const std::shared_ptr<VertexBuffer>& vertexBuffer) {
+		uint32_t binding = addLayout(vertexBuffer->getLayout());
+		setVertexBuffer(binding, vertexBuffer);
+	}
 
-		SHADO_CORE_ASSERT(vertexBuffer->getLayout().getElements().size(), "Vertex buffer has no layout!");
+	void VertexArray::setVertexBuffer(uint32_t binding, const std::shared_ptr<VertexBuffer>& vertexBuffer) {
+		SHADO_CORE_ASSERT(binding < m_VertexBuffers.size(), "Vertex array binding has no layout!");
 
-		glBindVertexArray(m_RendererID);
-		vertexBuffer->bind();
+		m_VertexBuffers[binding] = vertexBuffer;
+		m_Dirty = true;
+	}
 
-		const auto& layout = vertexBuffer->getLayout();
-		for (const auto& element : layout)
-		{
-			switch (element.Type)
-			{
-			case ShaderDataType::Float:
-			case ShaderDataType::Float2:
-			case ShaderDataType::Float3:
-			case ShaderDataType::Float4:
-			case ShaderDataType::Int:
-			case ShaderDataType::Int2:
-			case ShaderDataType::Int3:
-			case ShaderDataType::Int4:
-			case ShaderDataType::Bool:
-			{
-				glEnableVertexAttribArray(m_VertexBufferIndex);
-				glVertexAttribPointer(m_VertexBufferIndex,
-					element.getComponentCount(),
-					toOpenGLType(element.Type),
-					element.Normalized ? GL_TRUE : GL_FALSE,
-					layout.getStride(),
-					(const void*)element.Offset);
-				m_VertexBufferIndex++;
-				break;
-			}
-			case ShaderDataType::Mat3:
-			case ShaderDataType::Mat4:
+	void VertexArray::setIndexBuffer(const std::shared_ptr<IndexBuffer>& indexBuffer) {
+		m_IndexBuffer = indexBuffer;
+		m_Dirty = true;
+	}
+
+	void VertexArray::apply() const {
+		// VAOs aren't shared between contexts, so the GL object is made by whoever draws with it first
+		if (!m_RendererID)
+			glCreateVertexArrays(1, &m_RendererID);
+
+		uint32_t attribute = 0;
+		for (uint32_t binding = 0; binding < (uint32_t)m_Layouts.size(); binding++) {
+			const BufferLayout& layout = m_Layouts[binding];
+
+			for (const auto& element : layout)
 			{
-				uint8_t count = element.getComponentCount();
-				for (uint8_t i = 0; i < count; i++)
+				switch (element.Type)
+				{
+				case ShaderDataType::Int:
+				case ShaderDataType::Int2:
+				case ShaderDataType::Int3:
+				case ShaderDataType::Int4:
+				case ShaderDataType::UShort:
+				{
+					glEnableVertexArrayAttrib(m_RendererID, attribute);
+					glVertexArrayAttribIFormat(m_RendererID, attribute,
+						element.getComponentCount(),
+						toOpenGLType(element.Type),
+						(GLuint)element.Offset);
+					glVertexArrayAttribBinding(m_RendererID, attribute, binding);
+					attribute++;
+					break;
+				}
+				case ShaderDataType::Float:
+				case ShaderDataType::Float2:
+				case ShaderDataType::Float3:
+				case ShaderDataType::Float4:
+				case ShaderDataType::Bool:
+				case ShaderDataType::UByte4Norm:
+				case ShaderDataType::Half:
+				case ShaderDataType::Half2:
+				case ShaderDataType::Half4:
+				case ShaderDataType::Int10_10_10_2:
 				{
-					glEnableVertexAttribArray(m_VertexBufferIndex);
-					glVertexAttribPointer(m_VertexBufferIndex,
-						count,
+					glEnableVertexArrayAttrib(m_RendererID, attribute);
+					glVertexArrayAttribFormat(m_RendererID, attribute,
+						element.getComponentCount(),
 						toOpenGLType(element.Type),
 						element.Normalized ? GL_TRUE : GL_FALSE,
-						layout.getStride(),
-						(const void*)(element.Offset + sizeof(float) * count * i));
-					glVertexAttribDivisor(m_VertexBufferIndex, 1);
-					m_VertexBufferIndex++;
+						(GLuint)element.Offset);
+					glVertexArrayAttribBinding(m_RendererID, attribute, binding);
+					attribute++;
+					break;
+				}
+				case ShaderDataType::Mat3:
+				case ShaderDataType::Mat4:
+				{
+					uint8_t count = element.getComponentCount();
+					for (uint8_t i = 0; i < count; i++)
+					{
+						glEnableVertexArrayAttrib(m_RendererID, attribute);
+						glVertexArrayAttribFormat(m_RendererID, attribute,
+							count,
+							toOpenGLType(element.Type),
+							element.Normalized ? GL_TRUE : GL_FALSE,
+							(GLuint)(element.Offset + sizeof(float) * count * i));
+						glVertexArrayAttribBinding(m_RendererID, attribute, binding);
+						attribute++;
+					}
+
+					// Divisors belong to the binding with DSA, a matrix makes the whole buffer per instance
+					glVertexArrayBindingDivisor(m_RendererID, binding, 1);
+					break;
+				}
+				default:
+					SHADO_CORE_ASSERT(false, "Unknown ShaderDataType!");
 				}
-				break;
-			}
-			default:
-				SHADO_CORE_ASSERT(false, "Unknown ShaderDataType!");
 			}
-		}
 
-		m_VertexBuffers.push_back(vertexBuffer);
-	}
+			// Views are bound at their offset, so their first vertex is vertex 0
+			if (const auto& vertexBuffer = m_VertexBuffers[binding])
+				glVertexArrayVertexBuffer(m_RendererID, binding, vertexBuffer->getRendererID(), vertexBuffer->getOffset(), layout.getStride());
+		}
 
-	void VertexArray::setIndexBuffer(const std::shared_ptr<IndexBuffer>& indexBuffer) {
-		glBindVertexArray(m_RendererID);
-		indexBuffer->bind();
+		if (m_IndexBuffer)
+			glVertexArrayElementBuffer(m_RendererID, m_IndexBuffer->getRendererID());
 
-		m_IndexBuffer = indexBuffer;
+		m_Dirty = false;
 	}
-}
\ No newline at end of file
+}
@@ -11,17 +11,34 @@ namespace Shado {
 		virtual void bind() const;
 		virtual void unBind() const;
 
+		// Declares the attributes of `layout` on a new binding slot and returns the slot.
+		// Buffers are attached to it afterwards with setVertexBuffer, so one format can be reused by many buffers.
+		// Changes reach GL on the next bind, from the thread that draws
+		virtual uint32_t addLayout(const BufferLayout& layout);
+
+		// Same as addLayout(vertexBuffer->getLayout()) followed by setVertexBuffer
 		virtual void addVertexBuffer(const std::shared_ptr<VertexBuffer>& vertexBuffer);
+
+		// Swaps the buffer of a binding slot, the attribute format stays untouched
+		virtual void setVertexBuffer(uint32_t binding, const std::shared_ptr<VertexBuffer>& vertexBuffer);
 		virtual void setIndexBuffer(const std::shared_ptr<IndexBuffer>& vertexBuffer);
 
 		virtual const std::vector<std::shared_ptr<VertexBuffer>>& getVertexBuffers() const { return m_VertexBuffers; };
 		virtual const std::shared_ptr<IndexBuffer>& getIndexBuffers() const { return m_IndexBuffer; };
 
+		// 0 until the vertex array is first bound
+		uint32_t getRendererID() const { return m_RendererID; }
+
 		static std::shared_ptr<VertexArray> create();
 
 	private:
-		uint32_t m_RendererID;
-		uint32_t m_VertexBufferIndex = 0;
+		// Creates the GL object if needed and uploads the pending layout and buffer changes
+		void apply() const;
+
+	private:
+		mutable uint32_t m_RendererID = 0;
+		mutable bool m_Dirty = false;
+		std::vector<BufferLayout> m_Layouts;		// One per binding slot
 		std::vector<std::shared_ptr<VertexBuffer>> m_VertexBuffers;
 		std::shared_ptr<IndexBuffer> m_IndexBuffer;
 	};
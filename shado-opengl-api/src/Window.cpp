@@ -7,12 +7,13 @@
 #include "Events/KeyEvent.h"
 #include "Events/MouseEvent.h"
 #include "GL/glew.h"
+#include "RenderCommandQueue.h"
 
 #define BIND_EVENT_FN(x) std::bind(&Window::x, this, std::placeholders::_1)
 
 namespace Shado {
 
-	Window::Window(uint32_t width, uint32_t height, const std::string& title, WindowMode mode)
+	Window::Window(uint32_t width, uint32_t height, const std::string& title, WindowMode mode, bool visible, ContextAPI contextAPI)
 		: m_Mode(mode)
 	{
 		/* Initialize the library */
@@ -23,6 +24,19 @@ namespace Shado {
 		m_Data.width = width;
 		m_Data.height = height;
 
+		glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
+		switch (contextAPI) {
+		case ContextAPI::NATIVE:
+			glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_NATIVE_CONTEXT_API);
+			break;
+		case ContextAPI::EGL:
+			glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+			break;
+		case ContextAPI::OSMESA:
+			glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+			break;
+		}
+
 		/* Create a windowed mode window and its OpenGL context */
 		native_window = glfwCreateWindow(width, height, title.c_str(), NULL, NULL);
 		if (!native_window)
@@ -30,6 +44,8 @@ namespace Shado {
 			glfwTerminate();
 			SHADO_CORE_ASSERT(false, "Failed to create window");
 		}
+		// The context API hint stays, a context shared with this one has to come from the same API
+		glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
 
 		/* Make the window's context current */
 		glfwMakeContextCurrent(native_window);
@@ -42,6 +58,9 @@ namespace Shado {
 		glfwSetWindowUserPointer(native_window, &m_Data);
 		listenToEvents();
 
+		// The driver's default swap interval varies, make it match m_Data.VSync
+		setVSync(m_Data.VSync);
+
 		glfwGetWindowSize(native_window, (int*)&m_Data.width, (int*)&m_Data.height);
 		glfwGetWindowPos(native_window, &m_Position.first, &m_Position.second);
 
@@ -54,6 +73,8 @@ namespace Shado {
 	}
 
 	Window::~Window() {
+		if (m_SharedContext)
+			glfwDestroyWindow(m_SharedContext);
 		glfwDestroyWindow(native_window);
 	}
 
@@ -62,6 +83,27 @@ namespace Shado {
 		glfwPollEvents();
 	}
 
+	void Window::pollEvents() {
+		glfwPollEvents();
+	}
+
+	void Window::waitEvents(double timeout) {
+		glfwWaitEventsTimeout(timeout);
+	}
+
+	GLFWwindow* Window::getSharedContext() {
+		if (!m_SharedContext) {
+			// Invisible window, only there for its context
+			glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+			m_SharedContext = glfwCreateWindow(1, 1, "", NULL, native_window);
+			glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+
+			SHADO_CORE_ASSERT(m_SharedContext, "Failed to create shared context");
+		}
+
+		return m_SharedContext;
+	}
+
 	void Window::setTitle(const std::string& title) {
 		if (title == m_Data.title)
 			return;
@@ -71,10 +113,13 @@ namespace Shado {
 	}
 
 	void Window::setVSync(bool enabled) {
-		if (enabled)
-			glfwSwapInterval(1);
-		else
-			glfwSwapInterval(0);
+		// The swap interval belongs to the context presenting the window
+		RenderCommandQueue::Submit([enabled]() {
+			if (enabled)
+				glfwSwapInterval(1);
+			else
+				glfwSwapInterval(0);
+		});
 
 		m_Data.VSync = enabled;
 	}
@@ -157,7 +202,9 @@ namespace Shado {
 		int height = m_Data.height;
 		
 		glfwGetFramebufferSize(native_window, &width, &height);
-		glViewport(0, 0, width, height);
+		RenderCommandQueue::Submit([width, height]() {
+			glViewport(0, 0, width, height);
+		});
 
 		// Send the resize event to the application
 		WindowResizeEvent event(width, height);
@@ -219,6 +266,24 @@ namespace Shado {
 			data.eventCallback(event);
 			});
 
+		glfwSetWindowFocusCallback(native_window, [](GLFWwindow* window, int focused) {
+			WindowData& data = *(WindowData*)glfwGetWindowUserPointer(window);
+			data.focused = focused == GLFW_TRUE;
+
+			if (data.focused) {
+				WindowFocusEvent event;
+				data.eventCallback(event);
+			} else {
+				WindowLostFocusEvent event;
+				data.eventCallback(event);
+			}
+			});
+
+		glfwSetWindowIconifyCallback(native_window, [](GLFWwindow* window, int iconified) {
+			WindowData& data = *(WindowData*)glfwGetWindowUserPointer(window);
+			data.minimized = iconified == GLFW_TRUE;
+			});
+
 		glfwSetWindowCloseCallback(native_window, [](GLFWwindow* window) {
 			WindowData& data = *(WindowData*)glfwGetWindowUserPointer(window);
 			WindowCloseEvent event;
@@ -298,12 +363,14 @@ namespace Shado {
 	bool Window::onWindowResize(WindowResizeEvent& e) {
 		if (e.getWidth() == 0 || e.getHeight() == 0)
 		{
-			//m_Minimized = true;
+			m_Data.minimized = true;
 			return false;
 		}
 
-		//m_Minimized = false;
-		glViewport(0, 0, e.getWidth(), e.getHeight());
+		m_Data.minimized = false;
+		RenderCommandQueue::Submit([width = e.getWidth(), height = e.getHeight()]() {
+			glViewport(0, 0, width, height);
+		});
 
 
 		m_Data.width = e.getWidth();
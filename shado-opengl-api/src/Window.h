@@ -11,14 +11,22 @@ namespace Shado {
 	enum class WindowMode {
 		FULLSCREEN, WINDOWED, BORDERLESS_WINDOWED
 	};
+
+	// Who creates the GL context. Whichever it is, the window needs a display, even hidden
+	enum class ContextAPI {
+		NATIVE, EGL, OSMESA
+	};
 	
 	class Window {
 	public:
-		Window(uint32_t width, uint32_t height, const std::string& title = "Shado OpenGL Engine", WindowMode mode = WindowMode::WINDOWED);
+		Window(uint32_t width, uint32_t height, const std::string& title = "Shado OpenGL Engine", WindowMode mode = WindowMode::WINDOWED,
+			bool visible = true, ContextAPI contextAPI = ContextAPI::NATIVE);
 		Window();
 		~Window();
 
 		void onUpdate();
+		void pollEvents();	// onUpdate without the swap, for when the render thread presents
+		void waitEvents(double timeout);	// Sleeps until an event arrives or `timeout` seconds passed
 
 		void setTitle(const std::string& title);
 		void setVSync(bool enabled = true);
@@ -37,9 +45,13 @@ namespace Shado {
 		float getAspectRatio() const { return (float)getWidth() / (float)getHeight(); }
 		const std::string& getTitle() const { return m_Data.title; }
 		WindowMode getMode() const { return m_Mode; }
-		bool isVSync() const { return vsync; }
+		bool isVSync() const { return m_Data.VSync; }
+		bool isMinimized() const { return m_Data.minimized; }
+		bool isFocused() const { return m_Data.focused; }
 		
 		GLFWwindow* getNativeWindow() const { return native_window; }	
+		// Hidden context sharing the window's objects, created on first use
+		GLFWwindow* getSharedContext();
 
 	private:
 		using EventCallbackFn = std::function<void(Event&)>;
@@ -47,7 +59,9 @@ namespace Shado {
 		{
 			std::string title;
 			unsigned int width, height;
-			bool VSync;
+			bool VSync = true;
+			bool minimized = false;
+			bool focused = true;
 
 			EventCallbackFn eventCallback;
 		};
@@ -64,14 +78,13 @@ namespace Shado {
 		
 	private:
 		GLFWwindow* native_window;
+		GLFWwindow* m_SharedContext = nullptr;
 		WindowData m_Data;
 		WindowMode m_Mode;
 		GLFWmonitor* monitor;
 
 		std::pair<int, int> m_Position;
 		std::pair<int, int> m_Size;
-
-		bool vsync = true;
 	};
 	
 }
@@ -0,0 +1,314 @@
+#include "WorldPartition.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include "Debug.h"
+#include "Layer.h"
+#include "Profiler.h"
+#include "Stats.h"
+
+namespace Shado {
+
+	// Entities created or destroyed between two looks at the clock
+	static constexpr uint32_t EntitySlice = 64;
+
+	struct WorldPartitionStats {
+		StatHandle ResidentCells = Stats::Register("WorldPartition.ResidentCells", StatKind::Gauge);
+		StatHandle PendingCells = Stats::Register("WorldPartition.PendingCells", StatKind::Gauge);
+		StatHandle EntitiesCreated = Stats::Register("WorldPartition.EntitiesCreated");
+		StatHandle EntitiesDestroyed = Stats::Register("WorldPartition.EntitiesDestroyed");
+		StatHandle TexturesUploaded = Stats::Register("WorldPartition.TexturesUploaded");
+	};
+	static WorldPartitionStats s_Stats;
+
+	static std::string cellPath(const std::string& directory, int32_t x, int32_t y) {
+		return (std::filesystem::path(directory) / ("cell_" + std::to_string(x) + "_" + std::to_string(y) + ".shscene")).string();
+	}
+
+	WorldPartition::WorldPartition(Scene& scene, const std::string& directory, float cellSize)
+		: m_Scene(scene), m_Serializer(scene), m_Directory(directory), m_CellSize(cellSize),
+		m_LoadRadius(cellSize), m_UnloadRadius(cellSize * 1.5f)
+	{
+		SHADO_CORE_ASSERT(cellSize > 0.0f, "Cells must have a size");
+		m_Latencies.reserve(LatencyHistory);
+	}
+
+	WorldPartition::~WorldPartition() {
+		// The workers write into the cells
+		for (auto& [key, cell] : m_Cells) {
+			if (cell->state == CellState::Loading)
+				JobSystem::Wait(cell->job);
+		}
+	}
+
+	bool WorldPartition::SaveCells(Scene& scene, const std::string& directory, float cellSize) {
+		SHADO_PROFILE_FUNCTION();
+
+		std::error_code error;
+		std::filesystem::create_directories(directory, error);
+		if (error) {
+			SHADO_CORE_ERROR("Could not create {0}: {1}", directory, error.message());
+			return false;
+		}
+
+		// Cells left from a previous save would load on top of the new ones
+		for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+			const std::string name = entry.path().filename().string();
+			if (name.rfind("cell_", 0) == 0 && entry.path().extension() == ".shscene")
+				std::filesystem::remove(entry.path(), error);
+		}
+
+		scene.waitForPhysics();
+
+		std::unordered_map<uint64_t, std::vector<Entity>> cells;
+		scene.getRegistry().each<RigidBody>([&](EntityHandle entity, const RigidBody& rigidBody) {
+			const b2Vec2& position = rigidBody.body->GetPosition();
+			const int32_t x = (int32_t)std::floor(position.x / cellSize);
+			const int32_t y = (int32_t)std::floor(position.y / cellSize);
+			cells[getKey(x, y)].push_back({ entity, &scene });
+		});
+
+		SceneSerializer serializer(scene);
+		bool saved = true;
+		for (const auto& [key, entities] : cells) {
+			const int32_t x = (int32_t)(uint32_t)(key >> 32);
+			const int32_t y = (int32_t)(uint32_t)key;
+			saved &= serializer.saveBinary(cellPath(directory, x, y), entities);
+		}
+
+		return saved;
+	}
+
+	void WorldPartition::setRadii(float loadRadius, float unloadRadius) {
+		m_LoadRadius = loadRadius;
+		m_UnloadRadius = std::max(loadRadius, unloadRadius);
+	}
+
+	glm::ivec2 WorldPartition::getCell(const glm::vec2& position) const {
+		return { (int32_t)std::floor(position.x / m_CellSize), (int32_t)std::floor(position.y / m_CellSize) };
+	}
+
+	std::string WorldPartition::getCellPath(int32_t x, int32_t y) const {
+		return cellPath(m_Directory, x, y);
+	}
+
+	float WorldPartition::getDistance(int32_t x, int32_t y) const {
+		const glm::vec2 min = glm::vec2(x, y) * m_CellSize;
+		const glm::vec2 max = min + m_CellSize;
+		const float dx = std::max({ min.x - m_Focus.x, m_Focus.x - max.x, 0.0f });
+		const float dy = std::max({ min.y - m_Focus.y, m_Focus.y - max.y, 0.0f });
+		return std::sqrt(dx * dx + dy * dy);
+	}
+
+	void WorldPartition::update() {
+		SHADO_PROFILE_FUNCTION();
+		process(true);
+	}
+
+	void WorldPartition::flush() {
+		SHADO_PROFILE_FUNCTION();
+		process(false);
+	}
+
+	void WorldPartition::request(int32_t x, int32_t y) {
+		ScopedPtr<Cell> cell = std::make_unique<Cell>();
+		cell->x = x;
+		cell->y = y;
+		cell->requested = Clock::now();
+
+		// Cells stay put in the map until their job is done
+		Cell& requested = *cell;
+		m_Cells.emplace(getKey(x, y), std::move(cell));
+		JobSystem::Run([this, &requested, path = getCellPath(x, y)]() { load(requested, path); }, &requested.job);
+	}
+
+	void WorldPartition::load(Cell& cell, const std::string& path) {
+		SHADO_PROFILE_FUNCTION();
+
+		// No file, no entity in that cell
+		std::error_code error;
+		if (!std::filesystem::exists(path, error) || !cell.file.open(path))
+			return;
+
+		const std::vector<uint32_t>& textureStrings = cell.file.getTextureStrings();
+		cell.images.resize(textureStrings.size());
+		for (uint32_t i = 0; i < textureStrings.size(); i++) {
+			const std::string texturePath(cell.file.getString(textureStrings[i]));
+			{
+				std::lock_guard<std::mutex> lock(m_TexturesMutex);
+				auto it = m_Textures.find(texturePath);
+				if (it != m_Textures.end() && !it->second.expired())
+					continue;
+			}
+
+			cell.images[i] = TextureImage(texturePath);
+			if (!cell.images[i].isValid())
+				SHADO_CORE_ERROR("Could not decode {0}, needed by {1}", texturePath, path);
+		}
+	}
+
+	bool WorldPartition::instantiateSlice(Cell& cell) {
+		// The textures first, one per slice: an upload costs as much as many entities
+		const std::vector<uint32_t>& textureStrings = cell.file.getTextureStrings();
+		if (cell.nextTexture < textureStrings.size()) {
+			const uint32_t string = textureStrings[cell.nextTexture];
+			TextureImage image = std::move(cell.images[cell.nextTexture]);
+			const std::string path(cell.file.getString(string));
+			cell.nextTexture++;
+
+			Ref<Texture2D> texture;
+			{
+				std::lock_guard<std::mutex> lock(m_TexturesMutex);
+				texture = m_Textures[path].lock();
+			}
+
+			if (!texture && image.isValid()) {
+				texture = CreateRef<Texture2D>(image);
+				Stats::Add(s_Stats.TexturesUploaded);
+
+				std::lock_guard<std::mutex> lock(m_TexturesMutex);
+				m_Textures[path] = texture;
+			}
+
+			// Still null when it didn't decode, or was freed after the worker found it in memory: the
+			// serializer loads it from its path then
+			if (cell.textures.size() < cell.file.getStringCount())
+				cell.textures.resize(cell.file.getStringCount());
+			cell.textures[string] = texture;
+			return true;
+		}
+
+		const uint32_t entityCount = cell.file.getEntityCount();
+		if (cell.nextEntity < entityCount) {
+			const size_t before = cell.entities.size();
+			m_Serializer.instantiate(cell.file, cell.nextEntity, EntitySlice, cell.textures, &cell.entities);
+			cell.nextEntity = std::min(cell.nextEntity + EntitySlice, entityCount);
+			Stats::Add(s_Stats.EntitiesCreated, cell.entities.size() - before);
+
+			if (cell.nextEntity < entityCount)
+				return true;
+		}
+
+		// Done, the sprites hold the textures now
+		cell.state = CellState::Loaded;
+		cell.file.close();
+		cell.images.clear();
+		cell.images.shrink_to_fit();
+		cell.textures.clear();
+		cell.textures.shrink_to_fit();
+
+		const float latency = std::chrono::duration<float, std::milli>(Clock::now() - cell.requested).count();
+		if (m_Latencies.size() < LatencyHistory)
+			m_Latencies.push_back(latency);
+		else
+			m_Latencies[m_NextLatency] = latency;
+		m_NextLatency = (m_NextLatency + 1) % LatencyHistory;
+		return false;
+	}
+
+	bool WorldPartition::unloadSlice(Cell& cell) {
+		// Destroying an entity the game already destroyed does nothing
+		const size_t end = cell.entities.size() > EntitySlice ? cell.entities.size() - EntitySlice : 0;
+		for (size_t i = end; i < cell.entities.size(); i++)
+			m_Scene.destroyEntity(cell.entities[i]);
+
+		Stats::Add(s_Stats.EntitiesDestroyed, cell.entities.size() - end);
+		cell.entities.resize(end);
+		return !cell.entities.empty();
+	}
+
+	void WorldPartition::process(bool budgeted) {
+		const Clock::time_point deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float, std::milli>(m_FrameBudget));
+
+		// Cells coming in range
+		const glm::ivec2 first = getCell(m_Focus - m_LoadRadius);
+		const glm::ivec2 last = getCell(m_Focus + m_LoadRadius);
+		for (int32_t y = first.y; y <= last.y; y++) {
+			for (int32_t x = first.x; x <= last.x; x++) {
+				if (getDistance(x, y) <= m_LoadRadius && m_Cells.find(getKey(x, y)) == m_Cells.end())
+					request(x, y);
+			}
+		}
+
+		// Cells going out of range, and those with work for the main thread
+		std::vector<Cell*> pending;
+		for (auto it = m_Cells.begin(); it != m_Cells.end();) {
+			Cell& cell = *it->second;
+			const bool outOfRange = getDistance(cell.x, cell.y) > m_UnloadRadius;
+
+			if (cell.state == CellState::Loading) {
+				if (budgeted && !cell.job.isDone()) {
+					++it;
+					continue;
+				}
+				// Also lets the worker out of Finish before the cell can go
+				JobSystem::Wait(cell.job);
+
+				// Left before anything was created
+				if (outOfRange) {
+					it = m_Cells.erase(it);
+					continue;
+				}
+				cell.state = CellState::Instantiating;
+				cell.fileEntityCount = cell.file.getEntityCount();
+			} else if (outOfRange && cell.state != CellState::Unloading)
+				cell.state = CellState::Unloading;
+
+			if (cell.state != CellState::Loaded)
+				pending.push_back(&cell);
+			++it;
+		}
+
+		// Unloads first, they free memory. Then the closest cells
+		std::sort(pending.begin(), pending.end(), [this](const Cell* a, const Cell* b) {
+			if ((a->state == CellState::Unloading) != (b->state == CellState::Unloading))
+				return a->state == CellState::Unloading;
+			return getDistance(a->x, a->y) < getDistance(b->x, b->y);
+		});
+
+		bool worked = false;
+		for (Cell* cell : pending) {
+			bool more = true;
+			while (more) {
+				if (budgeted && worked && Clock::now() >= deadline)
+					break;
+
+				more = cell->state == CellState::Unloading ? unloadSlice(*cell) : instantiateSlice(*cell);
+				worked = true;
+			}
+
+			if (more)
+				break;
+
+			if (cell->state == CellState::Unloading)
+				m_Cells.erase(getKey(cell->x, cell->y));
+		}
+
+		// Forget the textures no loaded entity uses anymore
+		std::lock_guard<std::mutex> lock(m_TexturesMutex);
+		for (auto it = m_Textures.begin(); it != m_Textures.end();)
+			it = it->second.expired() ? m_Textures.erase(it) : std::next(it);
+
+		uint32_t resident = 0;
+		for (const auto& [key, cell] : m_Cells)
+			resident += cell->state == CellState::Loaded ? 1 : 0;
+		Stats::Set(s_Stats.ResidentCells, resident);
+		Stats::Set(s_Stats.PendingCells, m_Cells.size() - resident);
+	}
+
+	void WorldPartition::getCells(std::vector<CellInfo>& cells) const {
+		cells.clear();
+		cells.reserve(m_Cells.size());
+		for (const auto& [key, cell] : m_Cells) {
+			cells.push_back({ cell->x, cell->y, cell->state, (uint32_t)cell->entities.size(), cell->fileEntityCount });
+		}
+	}
+
+	void WorldPartition::getLoadLatencies(std::vector<float>& latencies) const {
+		latencies.clear();
+		latencies.reserve(m_Latencies.size());
+		for (uint32_t i = 0; i < m_Latencies.size(); i++)
+			latencies.push_back(m_Latencies[(m_NextLatency + i) % m_Latencies.size()]);
+	}
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#ifndef WORLD_PARTITION_H
+#define WORLD_PARTITION_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glm/vec2.hpp>
+#include "Entity.h"
+#include "JobSystem.h"
+#include "SceneSerializer.h"
+#include "Texture2D.h"
+
+namespace Shado {
+
+	class Scene;
+
+	/**
+	 * Streams a world too big to be held at once. The world is cut in square cells of cellSize world units,
+	 * each saved as its own binary scene (directory/cell_x_y.shscene, see SaveCells). The cells within
+	 * loadRadius of the focus are loaded into the scene, those beyond unloadRadius are unloaded: the gap
+	 * keeps a cell at the border from coming and going every frame. A missing file is an empty cell.
+	 *
+	 * A load maps the cell's file and decodes its textures on a job system worker. What has to be done on
+	 * the main thread (uploading the textures, creating the entities and their b2Body, destroying them on
+	 * unload) is spread over the frames: update() stops once it has spent the frame budget, closest cells
+	 * first. Textures are shared between the cells and freed once no loaded entity uses them.
+	 *
+	 * Entities belong to the cell they were saved in, even after moving out of it, and are destroyed with
+	 * it. Cells are read only: what happens to their entities is lost once they are unloaded.
+	 */
+	class WorldPartition {
+	public:
+		static constexpr uint32_t LatencyHistory = 128;
+
+		enum class CellState {
+			Loading,		// On a worker
+			Instantiating,	// Creating its entities, a slice per frame
+			Loaded,
+			Unloading		// Destroying its entities, a slice per frame
+		};
+
+		struct CellInfo {
+			int32_t x, y;
+			CellState state;
+			uint32_t entityCount;		// Created so far
+			uint32_t fileEntityCount;	// In its file, known once it leaves Loading
+		};
+
+		WorldPartition(Scene& scene, const std::string& directory, float cellSize);
+		// Waits for the loads running on workers. The entities of the loaded cells stay in the scene
+		~WorldPartition();
+
+		WorldPartition(const WorldPartition&) = delete;
+		WorldPartition& operator=(const WorldPartition&) = delete;
+
+		/**
+		 * Saves the entities of the scene in cells of cellSize, each in the cell under its position, replacing
+		 * the cells already in the directory. Builds the files a WorldPartition streams
+		 */
+		static bool SaveCells(Scene& scene, const std::string& directory, float cellSize);
+
+		// World units from the focus to the closest point of a cell. unloadRadius is at least loadRadius
+		void setRadii(float loadRadius, float unloadRadius);
+		// Main thread time update() may spend per frame, in ms. It always does at least a slice of work
+		void setFrameBudget(float milliseconds)		{ m_FrameBudget = milliseconds; }
+		// Usually the camera's position, set before update()
+		void setFocus(const glm::vec2& focus)		{ m_Focus = focus; }
+
+		/**
+		 * Starts loading the cells that came in range, unloads those gone out of it, then works on the cells
+		 * waiting for the main thread within the frame budget. Main thread, once per frame: the Application
+		 * does it for the active scene, right after its onUpdate
+		 */
+		void update();
+
+		// Loads every cell in range and unloads the others right away, blocking. For the first frame or a teleport
+		void flush();
+
+		glm::ivec2 getCell(const glm::vec2& position) const;
+		std::string getCellPath(int32_t x, int32_t y) const;
+
+		// Every cell the partition holds, whatever its state
+		void getCells(std::vector<CellInfo>& cells) const;
+		// Time from a cell coming in range to its last entity created, in ms. The last loads, oldest first
+		void getLoadLatencies(std::vector<float>& latencies) const;
+
+		const std::string& getDirectory()	const { return m_Directory; }
+		float getCellSize()					const { return m_CellSize; }
+		float getLoadRadius()				const { return m_LoadRadius; }
+		float getUnloadRadius()				const { return m_UnloadRadius; }
+		float getFrameBudget()				const { return m_FrameBudget; }
+		const glm::vec2& getFocus()			const { return m_Focus; }
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		struct Cell {
+			int32_t x, y;
+			CellState state = CellState::Loading;
+			Clock::time_point requested;
+			JobCounter job;
+
+			// Written by the worker, read once the job is done
+			SceneFile file;
+			std::vector<TextureImage> images;	// By place in file.getTextureStrings(), invalid when already in memory
+
+			// Main thread
+			std::vector<Ref<Texture2D>> textures;	// By string of the file
+			uint32_t fileEntityCount = 0;
+			uint32_t nextTexture = 0;
+			uint32_t nextEntity = 0;
+			std::vector<Entity> entities;
+		};
+
+		float getDistance(int32_t x, int32_t y) const;
+		void request(int32_t x, int32_t y);
+		// Runs on a worker
+		void load(Cell& cell, const std::string& path);
+		// One texture or a slice of entities, false once there is nothing left to do
+		bool instantiateSlice(Cell& cell);
+		bool unloadSlice(Cell& cell);
+		// Starts and drops cells, then works until the deadline. No deadline does everything there is to do
+		void process(bool budgeted);
+
+		static uint64_t getKey(int32_t x, int32_t y) { return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y; }
+
+	private:
+		Scene& m_Scene;
+		SceneSerializer m_Serializer;
+		std::string m_Directory;
+		float m_CellSize;
+		float m_LoadRadius;
+		float m_UnloadRadius;
+		float m_FrameBudget = 2.0f;
+		glm::vec2 m_Focus = { 0.0f, 0.0f };
+
+		std::unordered_map<uint64_t, ScopedPtr<Cell>> m_Cells;
+
+		// Textures of the loaded cells by path. Workers look in it to skip decoding what is already in memory
+		std::unordered_map<std::string, std::weak_ptr<Texture2D>> m_Textures;
+		mutable std::mutex m_TexturesMutex;
+
+		std::vector<float> m_Latencies;			// Ring of LatencyHistory
+		uint32_t m_NextLatency = 0;
+	};
+}
+
+#endif
@@ -0,0 +1,59 @@
+#pragma once
+
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+#include <cmath>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include "../Texture2D.h"
+#include "../util/Util.h"
+#include "../util/Bounds.h"
+#include "../util/StringInterner.h"
+
+class b2Body;
+
+namespace Shado {
+
+	struct EntityInfo {
+		uint64_t id = 0;								// Unique, never reused
+		InternedString name = StringInterner::None;		// In the scene's name table
+		uint32_t nameSlot = 0;							// Place among the scene's entities with that name
+	};
+
+	// Written by the physics step for entities with a RigidBody, drawing only reads this
+	struct Transform {
+		glm::vec3 position = { 0, 0, 0 };
+		float rotation = 0.0f;
+		glm::vec2 scale = { 1, 1 };
+
+		// World space bounds of the rotated quad
+		AABB getBounds() const {
+			float c = std::abs(std::cos(rotation));
+			float s = std::abs(std::sin(rotation));
+			float ex = c * scale.x / 2.0f + s * scale.y / 2.0f;
+			float ey = s * scale.x / 2.0f + c * scale.y / 2.0f;
+
+			return { { position.x - ex, position.y - ey, position.z }, { position.x + ex, position.y + ey, position.z } };
+		}
+	};
+
+	struct Sprite {
+		Ref<Texture2D> texture = nullptr;
+		uint32_t tilingfactor = 1;
+		Color color = Color::WHITE;
+		uint32_t cachedQuad = 0xFFFFFFFF;	// In the scene's QuadCache while the entity rests
+	};
+
+	struct RigidBody {
+		static constexpr uint32_t NotMoving = 0xFFFFFFFF;
+
+		b2Body* body = nullptr;
+		int32_t proxyId = -1;				// Node in the scene's BVH
+		uint32_t movingSlot = NotMoving;	// In the scene's list of non-static bodies
+		bool resting = false;				// Static or asleep: its proxy is in the resting index, its quad in the cache
+	};
+}
+
+#endif
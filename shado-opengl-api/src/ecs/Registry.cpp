@@ -0,0 +1,53 @@
+#include "Registry.h"
+
+#include <atomic>
+
+namespace Shado {
+
+	EntityHandle Registry::create() {
+		uint32_t index;
+		if (!m_Free.empty()) {
+			index = m_Free.back();
+			m_Free.pop_back();
+		} else {
+			index = (uint32_t)m_Generations.size();
+			m_Generations.push_back(0);
+			m_Alive.push_back(false);
+		}
+
+		m_Alive[index] = true;
+		m_Count++;
+		return { index, m_Generations[index] };
+	}
+
+	void Registry::destroy(EntityHandle entity) {
+		if (!isValid(entity))
+			return;
+
+		for (auto& pool : m_Pools) {
+			if (pool)
+				pool->remove(entity.Index);
+		}
+
+		m_Alive[entity.Index] = false;
+		m_Generations[entity.Index]++;
+		m_Free.push_back(entity.Index);
+		m_Count--;
+	}
+
+	bool Registry::isValid(EntityHandle entity) const {
+		return entity.Index < m_Generations.size() && m_Alive[entity.Index] && m_Generations[entity.Index] == entity.Generation;
+	}
+
+	void Registry::clear() {
+		for (uint32_t index = 0; index < m_Generations.size(); index++) {
+			if (m_Alive[index])
+				destroy({ index, m_Generations[index] });
+		}
+	}
+
+	uint32_t Registry::nextTypeIndex() {
+		static std::atomic<uint32_t> next = 0;
+		return next++;
+	}
+}
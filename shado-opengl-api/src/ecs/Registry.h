@@ -0,0 +1,246 @@
+#pragma once
+
+#ifndef REGISTRY_H
+#define REGISTRY_H
+
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "../Debug.h"
+
+namespace Shado {
+
+	struct EntityHandle {
+		uint32_t Index = 0xFFFFFFFF;
+		uint32_t Generation = 0;
+
+		bool operator==(const EntityHandle& other) const { return Index == other.Index && Generation == other.Generation; }
+		bool operator!=(const EntityHandle& other) const { return !(*this == other); }
+
+		// Fits in a Lua integer
+		uint64_t pack() const { return ((uint64_t)Generation << 32) | Index; }
+		static EntityHandle unpack(uint64_t value) { return { (uint32_t)value, (uint32_t)(value >> 32) }; }
+	};
+
+	/**
+	 * Sparse set of one component type. The components are packed in a dense array, in no particular
+	 * order, next to the index of the entity owning each one. The sparse array maps an entity index
+	 * to its slot in the dense array.
+	 * Adding, removing (swap with the last one and pop) and looking up are O(1).
+	 */
+	class ComponentPoolBase {
+	public:
+		virtual ~ComponentPoolBase() = default;
+
+		virtual void remove(uint32_t entity) = 0;
+
+		bool has(uint32_t entity) const { return entity < m_Sparse.size() && m_Sparse[entity] != None; }
+		uint32_t size() const { return (uint32_t)m_Dense.size(); }
+		// Entity index of each component, in the same order as the components
+		const uint32_t* entities() const { return m_Dense.data(); }
+
+	protected:
+		static constexpr uint32_t None = 0xFFFFFFFF;
+
+		std::vector<uint32_t> m_Sparse;		// Entity index -> dense slot
+		std::vector<uint32_t> m_Dense;		// Dense slot -> entity index
+	};
+
+	template<typename T>
+	class ComponentPool : public ComponentPoolBase {
+	public:
+		template<typename... Args>
+		T& emplace(uint32_t entity, Args&&... args) {
+			SHADO_CORE_ASSERT(!has(entity), "Entity already has this component!");
+
+			if (entity >= m_Sparse.size())
+				m_Sparse.resize((size_t)entity + 1, None);
+
+			m_Sparse[entity] = (uint32_t)m_Dense.size();
+			m_Dense.push_back(entity);
+			return m_Components.emplace_back(T{ std::forward<Args>(args)... });
+		}
+
+		void remove(uint32_t entity) override {
+			if (!has(entity))
+				return;
+
+			const uint32_t slot = m_Sparse[entity];
+			const uint32_t last = (uint32_t)m_Dense.size() - 1;
+			if (slot != last) {
+				m_Components[slot] = std::move(m_Components[last]);
+				m_Dense[slot] = m_Dense[last];
+				m_Sparse[m_Dense[slot]] = slot;
+			}
+
+			m_Components.pop_back();
+			m_Dense.pop_back();
+			m_Sparse[entity] = None;
+		}
+
+		T& get(uint32_t entity) {
+			SHADO_CORE_ASSERT(has(entity), "Entity doesn't have this component!");
+			return m_Components[m_Sparse[entity]];
+		}
+
+		const T& get(uint32_t entity) const {
+			SHADO_CORE_ASSERT(has(entity), "Entity doesn't have this component!");
+			return m_Components[m_Sparse[entity]];
+		}
+
+		T* data() { return m_Components.data(); }
+		const T* data() const { return m_Components.data(); }
+
+	private:
+		std::vector<T> m_Components;
+	};
+
+	/**
+	 * Entities are an index and a generation, components live in one sparse set per type.
+	 * Destroyed indices are recycled with their generation bumped, so a handle to a destroyed entity
+	 * stays invalid after its index is reused. Creating and destroying are O(1).
+	 *
+	 * Systems go through each<T, Others...>(), which walks the dense array of T in order. Entities
+	 * must not be created or destroyed, nor T added or removed, while iterating.
+	 * Not thread safe.
+	 */
+	class Registry {
+	public:
+		Registry() = default;
+		Registry(const Registry&) = delete;
+		Registry& operator=(const Registry&) = delete;
+
+		EntityHandle create();
+		// Removes all its components
+		void destroy(EntityHandle entity);
+		bool isValid(EntityHandle entity) const;
+		void clear();
+
+		// The handle of the entity living at that index
+		EntityHandle getHandle(uint32_t index) const { return { index, m_Generations[index] }; }
+		uint32_t getCount() const { return m_Count; }
+
+		template<typename T, typename... Args>
+		T& emplace(EntityHandle entity, Args&&... args) {
+			SHADO_CORE_ASSERT(isValid(entity), "Invalid entity handle!");
+			return getPool<T>().emplace(entity.Index, std::forward<Args>(args)...);
+		}
+
+		template<typename T>
+		void remove(EntityHandle entity) {
+			SHADO_CORE_ASSERT(isValid(entity), "Invalid entity handle!");
+			getPool<T>().remove(entity.Index);
+		}
+
+		template<typename T>
+		bool has(EntityHandle entity) const {
+			const ComponentPool<T>* pool = findPool<T>();
+			return isValid(entity) && pool && pool->has(entity.Index);
+		}
+
+		template<typename T>
+		T& get(EntityHandle entity) {
+			SHADO_CORE_ASSERT(isValid(entity), "Invalid entity handle!");
+			return getPool<T>().get(entity.Index);
+		}
+
+		template<typename T>
+		const T& get(EntityHandle entity) const {
+			SHADO_CORE_ASSERT(isValid(entity), "Invalid entity handle!");
+			const ComponentPool<T>* pool = findPool<T>();
+			SHADO_CORE_ASSERT(pool, "Entity doesn't have this component!");
+			return pool->get(entity.Index);
+		}
+
+		template<typename T>
+		T* tryGet(EntityHandle entity) {
+			ComponentPool<T>& pool = getPool<T>();
+			return isValid(entity) && pool.has(entity.Index) ? &pool.get(entity.Index) : nullptr;
+		}
+
+		template<typename T>
+		ComponentPool<T>& getPool() {
+			const uint32_t type = typeIndex<T>();
+			if (type >= m_Pools.size())
+				m_Pools.resize((size_t)type + 1);
+			if (!m_Pools[type])
+				m_Pools[type] = std::make_unique<ComponentPool<T>>();
+
+			return static_cast<ComponentPool<T>&>(*m_Pools[type]);
+		}
+
+		/**
+		 * Calls function(EntityHandle, T&, Others&...) for every entity having T and all of Others.
+		 * Walks T's components in memory order, so T should be the rarest of the types.
+		 */
+		template<typename T, typename... Others, typename Function>
+		void each(Function&& function) {
+			ComponentPool<T>& pool = getPool<T>();
+			const uint32_t* entities = pool.entities();
+			T* components = pool.data();
+
+			if constexpr (sizeof...(Others) == 0) {
+				for (uint32_t i = 0; i < pool.size(); i++)
+					function(getHandle(entities[i]), components[i]);
+			} else {
+				auto others = std::forward_as_tuple(getPool<Others>()...);
+				for (uint32_t i = 0; i < pool.size(); i++) {
+					const uint32_t index = entities[i];
+					if (!(std::get<ComponentPool<Others>&>(others).has(index) && ...))
+						continue;
+
+					function(getHandle(index), components[i], std::get<ComponentPool<Others>&>(others).get(index)...);
+				}
+			}
+		}
+
+		template<typename T, typename... Others, typename Function>
+		void each(Function&& function) const {
+			const ComponentPool<T>* pool = findPool<T>();
+			if (!pool || ((findPool<Others>() == nullptr) || ...))
+				return;
+
+			const uint32_t* entities = pool->entities();
+			const T* components = pool->data();
+
+			if constexpr (sizeof...(Others) == 0) {
+				for (uint32_t i = 0; i < pool->size(); i++)
+					function(getHandle(entities[i]), components[i]);
+			} else {
+				auto others = std::forward_as_tuple(*findPool<Others>()...);
+				for (uint32_t i = 0; i < pool->size(); i++) {
+					const uint32_t index = entities[i];
+					if (!(std::get<const ComponentPool<Others>&>(others).has(index) && ...))
+						continue;
+
+					function(getHandle(index), components[i], std::get<const ComponentPool<Others>&>(others).get(index)...);
+				}
+			}
+		}
+
+	private:
+		template<typename T>
+		static uint32_t typeIndex() {
+			static const uint32_t index = nextTypeIndex();
+			return index;
+		}
+		static uint32_t nextTypeIndex();
+
+		template<typename T>
+		const ComponentPool<T>* findPool() const {
+			const uint32_t type = typeIndex<T>();
+			return type < m_Pools.size() ? static_cast<const ComponentPool<T>*>(m_Pools[type].get()) : nullptr;
+		}
+
+	private:
+		std::vector<uint32_t> m_Generations;
+		std::vector<uint32_t> m_Free;
+		std::vector<bool> m_Alive;
+		std::vector<std::unique_ptr<ComponentPoolBase>> m_Pools;	// By type index
+		uint32_t m_Count = 0;
+	};
+}
+
+#endif
@@ -6,14 +6,14 @@
 layout(location = 0) in vec3 a_Position;
 layout(location = 1) in vec4 a_Color;
 layout(location = 2) in vec2 a_TexCoord;
-layout(location = 3) in float a_TexIndex;
+layout(location = 3) in uint a_TexIndex;
 layout(location = 4) in float a_TilingFactor;
 
 uniform mat4 u_ViewProjection;
 
 out vec4 v_Color;
 out vec2 v_TexCoord;
-flat out float v_TexIndex;
+flat out uint v_TexIndex;
 out float v_TilingFactor;
 
 void main()
@@ -32,7 +32,7 @@ layout(location = 0) out vec4 color;
 
 in vec4 v_Color;
 in vec2 v_TexCoord;
-flat in float v_TexIndex;
+flat in uint v_TexIndex;
 in float v_TilingFactor;
 
 uniform sampler2D u_Textures[32];
@@ -9,6 +9,7 @@
 #include "Events/MouseEvent.h"
 #include "Events/KeyEvent.h"
 #include "Events/KeyCodes.h"
+#include "Stats.h"
 
 namespace Shado {
 
@@ -20,6 +21,12 @@ namespace Shado {
 	static std::unordered_map<std::string, int> eventToData(Event&);
 	
     // Entity Wrapper functions
+	// Entities are passed to lua as their scene ptr and their packed handle
+	static Entity toEntity(lua_State* L, int sceneIndex, int handleIndex) {
+		Scene* scene = (Scene*)lua_touserdata(L, sceneIndex);
+		return Entity(EntityHandle::unpack((uint64_t)lua_tointeger(L, handleIndex)), scene);
+	}
+
 	int _CreateEntity(lua_State* L) {
         
 		// Check if lua has provided a b2World for entity and a width and height
@@ -35,76 +42,127 @@ namespace Shado {
 		def.scale = { width, height };
 		def.name = "Lua entity";
 		
-		Entity* e = scene->addEntityToWorld(def);
-		lua_pushlightuserdata(L, e);
+		Entity e = scene->addEntityToWorld(def);
+		lua_pushinteger(L, (lua_Integer)e.getHandle().pack());
 
 		return 1;	
 	}
 
-	int _SetEntityTexture(lua_State* L) {
-		// Check if lua has provided an Entity Ptr and a path for texture
+	int _GetEntityByName(lua_State* L) {
+		// Check if lua has provided a scene ptr and a name
+		if (lua_gettop(L) != 2) return -1;
+
+		Scene* scene = (Scene*)lua_touserdata(L, 1);
+		Entity e = scene->getEntity(std::string(lua_tostring(L, 2)));
+		if (e.isValid())
+			lua_pushinteger(L, (lua_Integer)e.getHandle().pack());
+		else
+			lua_pushnil(L);
+
+		return 1;
+	}
+
+	int _GetEntityById(lua_State* L) {
+		// Check if lua has provided a scene ptr and an id
+		if (lua_gettop(L) != 2) return -1;
+
+		Scene* scene = (Scene*)lua_touserdata(L, 1);
+		Entity e = scene->getEntity((uint64_t)lua_tointeger(L, 2));
+		if (e.isValid())
+			lua_pushinteger(L, (lua_Integer)e.getHandle().pack());
+		else
+			lua_pushnil(L);
+
+		return 1;
+	}
+
+	int _GetEntityId(lua_State* L) {
+		// Check if lua has provided a scene ptr and an entity
 		if (lua_gettop(L) != 2) return -1;
+
+		Entity e = toEntity(L, 1, 2);
+		if (e.isValid())
+			lua_pushinteger(L, (lua_Integer)e.getId());
+		else
+			lua_pushnil(L);
+
+		return 1;
+	}
+
+	int _SetEntityTexture(lua_State* L) {
+		// Check if lua has provided a scene ptr, an entity and a path for texture
+		if (lua_gettop(L) != 3) return -1;
 		
 		// Get entity
-		Entity* e = (Entity*)lua_touserdata(L, 1);
-		std::string path = lua_tostring(L, 2);
-		e->setTexture(path);
+		Entity e = toEntity(L, 1, 2);
+		if (!e.isValid()) return 0;
+
+		std::string path = lua_tostring(L, 3);
+		e.setTexture(path);
 
 		return 1;
 	}
 
 	int _SetTillingFactor(lua_State* L) {
-		// Check if lua has provided an Entity Ptr and a factor
-		if (lua_gettop(L) != 2) return -1;
+		// Check if lua has provided a scene ptr, an entity and a factor
+		if (lua_gettop(L) != 3) return -1;
 
 		// Get entity
-		Entity* e = (Entity*)lua_touserdata(L, 1);
-		int factor = (int)lua_tonumber(L, 2);
-		e->setTillingFactor(factor);
+		Entity e = toEntity(L, 1, 2);
+		if (!e.isValid()) return 0;
+
+		int factor = (int)lua_tonumber(L, 3);
+		e.setTillingFactor(factor);
 		return 1;
 	}
 	
 	int _SetColor(lua_State* L) {
-		// Check if lua has provided an Entity Ptr and 4 arguments for colour
-		if (lua_gettop(L) != 5) return -1;
+		// Check if lua has provided a scene ptr, an entity and 4 arguments for colour
+		if (lua_gettop(L) != 6) return -1;
 
-		Entity* e = (Entity*)lua_touserdata(L, 1);
-		float r = lua_tonumber(L, 2);
-		float g = lua_tonumber(L, 3);
-		float b = lua_tonumber(L, 4);
-		float a = lua_tonumber(L, 5);
-		e->setColor({r, g, b, a});
+		Entity e = toEntity(L, 1, 2);
+		if (!e.isValid()) return 0;
+
+		float r = lua_tonumber(L, 3);
+		float g = lua_tonumber(L, 4);
+		float b = lua_tonumber(L, 5);
+		float a = lua_tonumber(L, 6);
+		e.setColor({r, g, b, a});
 
 		return 1;
 	}
 
 	int _SetPosition(lua_State* L) {
-		// Check if lua has provided an Entity Ptr and 2 arguments for position
-		if (lua_gettop(L) != 3) return -1;
+		// Check if lua has provided a scene ptr, an entity and 2 arguments for position
+		if (lua_gettop(L) != 4) return -1;
+
+		Entity e = toEntity(L, 1, 2);
+		if (!e.isValid()) return 0;
 
-		Entity* e = (Entity*)lua_touserdata(L, 1);
-		float x = lua_tonumber(L, 2);
-		float y = lua_tonumber(L, 3);
+		float x = lua_tonumber(L, 3);
+		float y = lua_tonumber(L, 4);
 
-		e->getNativeBody()->SetTransform({ x, y }, e->getNativeBody()->GetAngle());
+		e.setPosition({ x, y });
 
 		return 1;
 	}
 	
 	int _SetType(lua_State* L) {
-		// Check if lua has provided an Entity Ptr and 1 arguments for type
-		if (lua_gettop(L) != 2) return -1;
+		// Check if lua has provided a scene ptr, an entity and 1 arguments for type
+		if (lua_gettop(L) != 3) return -1;
 
-		Entity* e = (Entity*)lua_touserdata(L, 1);
-		std::string type = lua_tostring(L, 2);
+		Entity e = toEntity(L, 1, 2);
+		if (!e.isValid()) return 0;
+
+		std::string type = lua_tostring(L, 3);
 
 		using namespace std::string_literals;
 		if (toLower(type) == "dynamic"s)
-			e->getNativeBody()->SetType(b2_dynamicBody);
+			e.setType(EntityType::DYNAMIC);
 		else if (toLower(type) == "static"s)
-			e->getNativeBody()->SetType(b2_staticBody);
+			e.setType(EntityType::STATIC);
 		else if (toLower(type) == "kinematic"s)
-			e->getNativeBody()->SetType(b2_kinematicBody);
+			e.setType(EntityType::KINEMATIC);
 
 		return 1;	
 	}
@@ -229,15 +287,49 @@ namespace Shado {
 		return 1;
 	}
 
+	int _GetStat(lua_State* L) {
+		// Check if lua has provided a stat name
+		if (lua_gettop(L) != 1) return -1;
+
+		StatHandle stat = Stats::Find(lua_tostring(L, 1));
+		if (stat == InvalidStat)
+			lua_pushnil(L);
+		else
+			lua_pushinteger(L, Stats::GetValue(stat));
+		return 1;
+	}
+
+	int _GetStatHistory(lua_State* L) {
+		// Check if lua has provided a stat name
+		if (lua_gettop(L) != 1) return -1;
+
+		StatHandle stat = Stats::Find(lua_tostring(L, 1));
+		if (stat == InvalidStat) {
+			lua_pushnil(L);
+			return 1;
+		}
+
+		std::vector<int64_t> values;
+		Stats::GetHistory(stat, values);
+
+		// Oldest first, from 1 like any lua array
+		lua_createtable(L, (int)values.size(), 0);
+		for (size_t i = 0; i < values.size(); i++) {
+			lua_pushinteger(L, values[i]);
+			lua_rawseti(L, -2, (lua_Integer)i + 1);
+		}
+		return 1;
+	}
+
 	int _DestroyEntity(lua_State* L) {
-		// Check if lua has provided a entity ptr and scene ptr
+		// Check if lua has provided a scene ptr and an entity
 		if (lua_gettop(L) != 2) return -1;
 
-		Entity* entity = (Entity*)lua_touserdata(L, 1);
-		Scene* scene = (Scene*)lua_touserdata(L, 2);
+		Entity entity = toEntity(L, 1, 2);
+		bool valid = entity.isValid();
 
-		scene->destroyEntity(entity);
-		lua_pushboolean(L, true);
+		entity.destroy();
+		lua_pushboolean(L, valid);
 		
 		return 1;
 	}
@@ -262,6 +354,9 @@ namespace Shado {
 		lua_register(L, "_SetEntityPosition", _SetPosition);
 		lua_register(L, "_SetEntityType", _SetType);
 		lua_register(L, "_DestroyEntity", _DestroyEntity);
+		lua_register(L, "_GetEntityByName", _GetEntityByName);
+		lua_register(L, "_GetEntityById", _GetEntityById);
+		lua_register(L, "_GetEntityId", _GetEntityId);
 		
 		lua_register(L, "_IsKeyDown", _IsKeyDown);
 		lua_register(L, "_GetMouseX", _GetMouseX);
@@ -278,6 +373,9 @@ namespace Shado {
 		lua_register(L, "_GetSceneByName", _GetSceneByName);
 		lua_register(L, "_GetActiveScene", _GetActiveScene);
 		lua_register(L, "_SetActiveScene", _SetActiveScene);
+
+		lua_register(L, "_GetStat", _GetStat);
+		lua_register(L, "_GetStatHistory", _GetStatHistory);
 		
 		
 		int code = luaL_dofile(L, filename.c_str());
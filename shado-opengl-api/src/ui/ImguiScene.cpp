@@ -2,6 +2,17 @@
 #include <backends/imgui_impl_glfw.h>
 #include <backends/imgui_impl_opengl3.h>
 #include "Application.h"
+#include "Profiler.h"
+#include "RenderState.h"
+#include "RenderCommandQueue.h"
+#include "Stats.h"
+#include "WorldPartition.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
 
 namespace Shado {
 
@@ -53,6 +64,280 @@ namespace Shado {
 	void ImguiLayer::onImGuiRender() {
 		if (m_ShowDemo)
 			ImGui::ShowDemoWindow(&m_ShowDemo);
+
+		if (m_ShowProfiler)
+			drawProfiler();
+
+		if (m_ShowStats)
+			drawStats();
+
+		if (m_ShowWorldPartition)
+			drawWorldPartition();
+	}
+
+	static ImU32 profileColor(const char* name) {
+		// FNV-1a, the same name keeps its color from one frame to the next
+		uint32_t hash = 2166136261u;
+		for (const char* c = name; *c; c++)
+			hash = (hash ^ (uint8_t)*c) * 16777619u;
+		return ImColor::HSV((hash % 360) / 360.0f, 0.45f, 0.75f);
+	}
+
+	void ImguiLayer::drawProfiler() {
+		if (!ImGui::Begin("Profiler", &m_ShowProfiler)) {
+			ImGui::End();
+			return;
+		}
+
+		bool paused = Profiler::IsPaused();
+		if (ImGui::Checkbox("Pause", &paused))
+			Profiler::SetPaused(paused);
+		ImGui::SameLine();
+		if (ImGui::Button("Save Chrome trace"))
+			Profiler::SaveChromeTrace("profile.json");
+		ImGui::SameLine();
+		if (ImGui::Button("Save binary"))
+			Profiler::SaveBinary("profile.shpf");
+		ImGui::SameLine();
+		ImGui::Text("Dropped events: %llu", (unsigned long long)Profiler::GetDroppedEventCount());
+
+		const std::vector<ProfileFrame>& frames = Profiler::GetFrames();
+		if (frames.empty()) {
+			ImGui::End();
+			return;
+		}
+
+		// Frame times, clicking one inspects it
+		std::vector<float> times(frames.size());
+		for (size_t i = 0; i < frames.size(); i++)
+			times[i] = (frames[i].End - frames[i].Start) / 1e6f;
+
+		ImGui::PlotHistogram("##FrameTimes", times.data(), (int)times.size(), 0, "Frame times (ms)", 0.0f, FLT_MAX, ImVec2(-1.0f, 60.0f));
+		if (ImGui::IsItemClicked()) {
+			const float x = (ImGui::GetMousePos().x - ImGui::GetItemRectMin().x) / ImGui::GetItemRectSize().x;
+			m_ProfilerFrame = std::clamp((int)(x * frames.size()), 0, (int)frames.size() - 1);
+			Profiler::SetPaused(true);
+		}
+		if (!Profiler::IsPaused() || m_ProfilerFrame >= (int)frames.size())
+			m_ProfilerFrame = -1;
+
+		const size_t selected = m_ProfilerFrame >= 0 ? m_ProfilerFrame : frames.size() - 1;
+		const ProfileFrame& frame = frames[selected];
+		const double duration = (double)std::max<uint64_t>(frame.End - frame.Start, 1);
+		ImGui::Text("Frame %zu: %.3f ms", selected, duration / 1e6);
+
+		// Events are stored in the frame they ended in, the next frame has those that overlap the end of this one
+		std::vector<const ProfileEvent*> events;
+		for (size_t i = selected; i < std::min(selected + 2, frames.size()); i++) {
+			for (const ProfileEvent& event : frames[i].Events) {
+				if (event.Start < frame.End && event.Start + event.Duration > frame.Start)
+					events.push_back(&event);
+			}
+		}
+
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+		const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+		const float width = ImGui::GetContentRegionAvail().x;
+		const std::vector<std::string>& threads = Profiler::GetThreadNames();
+
+		for (uint16_t thread = 0; thread < threads.size(); thread++) {
+			uint16_t maxDepth = 0;
+			bool any = false;
+			for (const ProfileEvent* event : events) {
+				if (event->Thread == thread) {
+					maxDepth = std::max(maxDepth, event->Depth);
+					any = true;
+				}
+			}
+			if (!any)
+				continue;
+
+			ImGui::TextUnformatted(threads[thread].c_str());
+			const ImVec2 origin = ImGui::GetCursorScreenPos();
+
+			for (const ProfileEvent* event : events) {
+				if (event->Thread != thread)
+					continue;
+
+				const double start = std::max<double>((double)event->Start - frame.Start, 0.0);
+				const double end = std::min<double>((double)(event->Start + event->Duration) - frame.Start, duration);
+				const ImVec2 min = { origin.x + (float)(start / duration) * width, origin.y + event->Depth * rowHeight };
+				const ImVec2 max = { std::max(origin.x + (float)(end / duration) * width, min.x + 1.0f), min.y + rowHeight - 1.0f };
+
+				drawList->AddRectFilled(min, max, profileColor(event->Name));
+				if (max.x - min.x > ImGui::CalcTextSize(event->Name).x + 4.0f) {
+					drawList->PushClipRect(min, max, true);
+					drawList->AddText({ min.x + 2.0f, min.y }, IM_COL32_WHITE, event->Name);
+					drawList->PopClipRect();
+				}
+
+				if (ImGui::IsMouseHoveringRect(min, max))
+					ImGui::SetTooltip("%s: %.3f ms", event->Name, event->Duration / 1e6);
+			}
+
+			ImGui::Dummy(ImVec2(width, (maxDepth + 1) * rowHeight));
+		}
+
+		ImGui::End();
+	}
+
+	static void formatStat(char* buffer, size_t size, int64_t value, StatUnit unit) {
+		if (unit == StatUnit::Bytes && std::abs(value) >= 1024 * 1024)
+			snprintf(buffer, size, "%.2f MB", value / (1024.0 * 1024.0));
+		else if (unit == StatUnit::Bytes && std::abs(value) >= 1024)
+			snprintf(buffer, size, "%.2f KB", value / 1024.0);
+		else if (unit == StatUnit::Bytes)
+			snprintf(buffer, size, "%lld B", (long long)value);
+		else if (unit == StatUnit::Microseconds)
+			snprintf(buffer, size, "%.2f ms", value / 1000.0);
+		else
+			snprintf(buffer, size, "%lld", (long long)value);
+	}
+
+	void ImguiLayer::drawStats() {
+		ImGui::SetNextWindowBgAlpha(0.75f);
+		if (!ImGui::Begin("Stats", &m_ShowStats, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoFocusOnAppearing)) {
+			ImGui::End();
+			return;
+		}
+
+		// Grouped by the prefix of their names, in the order they were registered
+		std::string group;
+		std::vector<int64_t> history;
+		std::vector<float> plot;
+		char value[32];
+
+		for (StatHandle stat = 0; stat < Stats::GetCount(); stat++) {
+			const StatInfo& info = Stats::GetInfo(stat);
+			const size_t dot = info.Name.find('.');
+			const std::string statGroup = dot != std::string::npos ? info.Name.substr(0, dot) : "";
+			const char* label = info.Name.c_str() + (dot != std::string::npos ? dot + 1 : 0);
+
+			if (stat == 0 || statGroup != group) {
+				group = statGroup;
+				if (stat != 0)
+					ImGui::Separator();
+				ImGui::TextDisabled("%s", group.c_str());
+			}
+
+			formatStat(value, sizeof(value), Stats::GetValue(stat), info.Unit);
+			ImGui::Text("  %-28s %12s", label, value);
+
+			if (ImGui::IsItemHovered()) {
+				Stats::GetHistory(stat, history);
+				plot.assign(history.begin(), history.end());
+
+				ImGui::BeginTooltip();
+				ImGui::PlotLines("##History", plot.data(), (int)plot.size(), 0, info.Name.c_str(), 0.0f, FLT_MAX, ImVec2(300.0f, 80.0f));
+				ImGui::EndTooltip();
+			}
+		}
+
+		ImGui::End();
+	}
+
+	static ImU32 cellColor(WorldPartition::CellState state) {
+		switch (state) {
+		case WorldPartition::CellState::Loading:		return IM_COL32(200, 180, 60, 255);
+		case WorldPartition::CellState::Instantiating:	return IM_COL32(220, 120, 40, 255);
+		case WorldPartition::CellState::Loaded:			return IM_COL32(70, 170, 90, 255);
+		case WorldPartition::CellState::Unloading:		return IM_COL32(190, 60, 60, 255);
+		}
+		return IM_COL32_WHITE;
+	}
+
+	static const char* cellStateName(WorldPartition::CellState state) {
+		switch (state) {
+		case WorldPartition::CellState::Loading:		return "Loading";
+		case WorldPartition::CellState::Instantiating:	return "Instantiating";
+		case WorldPartition::CellState::Loaded:			return "Loaded";
+		case WorldPartition::CellState::Unloading:		return "Unloading";
+		}
+		return "";
+	}
+
+	void ImguiLayer::drawWorldPartition() {
+		if (!ImGui::Begin("World partition", &m_ShowWorldPartition)) {
+			ImGui::End();
+			return;
+		}
+
+		std::vector<WorldPartition::CellInfo> cells;
+		std::vector<float> latencies;
+		bool any = false;
+
+		for (const Scene* scene : Application::get().getScenes()) {
+			const WorldPartition* partition = scene->getWorldPartition();
+			if (!partition)
+				continue;
+
+			any = true;
+			ImGui::PushID(scene);
+			ImGui::TextDisabled("%s", scene->getName().c_str());
+
+			partition->getCells(cells);
+			uint32_t resident = 0, entities = 0;
+			for (const WorldPartition::CellInfo& cell : cells) {
+				resident += cell.state == WorldPartition::CellState::Loaded ? 1 : 0;
+				entities += cell.entityCount;
+			}
+			ImGui::Text("Cells: %u resident, %u pending, %u entities", resident, (uint32_t)cells.size() - resident, entities);
+
+			partition->getLoadLatencies(latencies);
+			if (!latencies.empty()) {
+				float total = 0.0f, longest = 0.0f;
+				for (float latency : latencies) {
+					total += latency;
+					longest = std::max(longest, latency);
+				}
+				ImGui::Text("Load latency: last %.1f ms, average %.1f ms, max %.1f ms", latencies.back(), total / latencies.size(), longest);
+				ImGui::PlotHistogram("##Latencies", latencies.data(), (int)latencies.size(), 0, "Load latency (ms)", 0.0f, FLT_MAX, ImVec2(-1.0f, 60.0f));
+			}
+
+			// The cells within the unload radius, the focus in the middle
+			const float cellSize = partition->getCellSize();
+			const int32_t reach = (int32_t)std::ceil(partition->getUnloadRadius() / cellSize) + 1;
+			const glm::ivec2 center = partition->getCell(partition->getFocus());
+			const float side = std::min(ImGui::GetContentRegionAvail().x, 320.0f);
+			const float pixels = side / (2 * reach + 1);
+
+			ImDrawList* drawList = ImGui::GetWindowDrawList();
+			const ImVec2 origin = ImGui::GetCursorScreenPos();
+			drawList->AddRectFilled(origin, { origin.x + side, origin.y + side }, IM_COL32(30, 30, 30, 255));
+
+			// World y goes up, the screen's goes down
+			auto toScreen = [&](const glm::vec2& world) {
+				const glm::vec2 cell = world / cellSize - glm::vec2(center - reach);
+				return ImVec2(origin.x + cell.x * pixels, origin.y + side - cell.y * pixels);
+			};
+
+			for (const WorldPartition::CellInfo& cell : cells) {
+				if (std::abs(cell.x - center.x) > reach || std::abs(cell.y - center.y) > reach)
+					continue;
+
+				const ImVec2 a = toScreen(glm::vec2(cell.x, cell.y + 1) * cellSize);
+				const ImVec2 b = toScreen(glm::vec2(cell.x + 1, cell.y) * cellSize);
+				const ImVec2 min = { a.x + 1.0f, a.y + 1.0f }, max = { b.x - 1.0f, b.y - 1.0f };
+				drawList->AddRectFilled(min, max, cellColor(cell.state));
+
+				if (ImGui::IsMouseHoveringRect(min, max))
+					ImGui::SetTooltip("Cell %d, %d: %s, %u / %u entities", cell.x, cell.y, cellStateName(cell.state), cell.entityCount, cell.fileEntityCount);
+			}
+
+			const ImVec2 focus = toScreen(partition->getFocus());
+			drawList->AddCircle(focus, partition->getLoadRadius() / cellSize * pixels, IM_COL32(255, 255, 255, 160), 48);
+			drawList->AddCircle(focus, partition->getUnloadRadius() / cellSize * pixels, IM_COL32(255, 255, 255, 60), 48);
+			drawList->AddCircleFilled(focus, 3.0f, IM_COL32_WHITE);
+
+			ImGui::Dummy(ImVec2(side, side));
+			ImGui::Separator();
+			ImGui::PopID();
+		}
+
+		if (!any)
+			ImGui::TextDisabled("No scene streams a world");
+
+		ImGui::End();
 	}
 
 	void ImguiLayer::begin() {
@@ -61,6 +346,26 @@ namespace Shado {
 		ImGui::NewFrame();
 	}
 
+	// ImGui reuses its draw lists on the next NewFrame, the render thread gets its own copy
+	struct ImDrawDataCopy {
+		ImDrawData data;
+		std::vector<ImDrawList*> lists;
+
+		ImDrawDataCopy(const ImDrawData* source)
+			: data(*source)
+		{
+			lists.reserve(source->CmdListsCount);
+			for (int i = 0; i < source->CmdListsCount; i++)
+				lists.push_back(source->CmdLists[i]->CloneOutput());
+			data.CmdLists = lists.data();
+		}
+
+		~ImDrawDataCopy() {
+			for (ImDrawList* list : lists)
+				IM_DELETE(list);
+		}
+	};
+
 	void ImguiLayer::end() {
 		ImGuiIO& io = ImGui::GetIO();
 		Application& app = Application::get();
@@ -68,6 +373,16 @@ namespace Shado {
 
 		// Render
 		ImGui::Render();
+
+		if (RenderCommandQueue::IsThreaded()) {
+			// Platform windows are presented from the main thread, Application turns them off in this mode
+			RenderCommandQueue::Submit([drawData = std::make_shared<ImDrawDataCopy>(ImGui::GetDrawData())]() {
+				ImGui_ImplOpenGL3_RenderDrawData(&drawData->data);
+				RenderState::Invalidate();
+			});
+			return;
+		}
+
 		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
 		if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
@@ -76,5 +391,8 @@ namespace Shado {
 			ImGui::RenderPlatformWindowsDefault();
 			glfwMakeContextCurrent(window);
 		}
+
+		// The backend binds its own program, VAO and textures
+		RenderState::Invalidate();
 	}
 }
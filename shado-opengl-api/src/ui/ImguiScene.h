@@ -20,8 +20,29 @@ namespace Shado {
 
 		void begin();
 		void end();
+
+		// Frame times and a flame graph of the profiler's history
+		void setShowProfiler(bool show) { m_ShowProfiler = show; }
+		bool isProfilerShown() const { return m_ShowProfiler; }
+
+		// Overlay with the last frame's Stats, hovering one plots its history
+		void setShowStats(bool show) { m_ShowStats = show; }
+		bool isStatsShown() const { return m_ShowStats; }
+
+		// Map of the cells each scene's WorldPartition holds, and how long the last ones took to load
+		void setShowWorldPartition(bool show) { m_ShowWorldPartition = show; }
+		bool isWorldPartitionShown() const { return m_ShowWorldPartition; }
+	private:
+		void drawProfiler();
+		void drawStats();
+		void drawWorldPartition();
+
 	private:
 		float m_Time;
 		bool m_ShowDemo;
+		bool m_ShowProfiler = false;
+		bool m_ShowStats = false;
+		bool m_ShowWorldPartition = false;
+		int m_ProfilerFrame = -1;	// Inspected frame in the history, -1 for the latest
 	};
 }
@@ -0,0 +1,163 @@
+#pragma once
+
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <algorithm>
+#include <cmath>
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "glm/mat4x4.hpp"
+
+namespace Shado {
+
+	// Axis aligned bounding box in world space
+	struct AABB {
+		glm::vec3 min = { 0.0f, 0.0f, 0.0f };
+		glm::vec3 max = { 0.0f, 0.0f, 0.0f };
+
+		AABB() = default;
+		AABB(const glm::vec3& min, const glm::vec3& max)
+			: min(min), max(max)
+		{}
+
+		glm::vec3 getCenter()	const { return (min + max) * 0.5f; }
+		glm::vec3 getExtents()	const { return (max - min) * 0.5f; }
+
+		// Used as the cost metric when building the BVH
+		float getSurfaceArea() const {
+			glm::vec3 d = max - min;
+			return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+		}
+
+		bool overlaps(const AABB& other) const {
+			return min.x <= other.max.x && max.x >= other.min.x
+				&& min.y <= other.max.y && max.y >= other.min.y
+				&& min.z <= other.max.z && max.z >= other.min.z;
+		}
+
+		bool contains(const AABB& other) const {
+			return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z
+				&& other.max.x <= max.x && other.max.y <= max.y && other.max.z <= max.z;
+		}
+
+		bool contains(const glm::vec3& point) const {
+			return point.x >= min.x && point.x <= max.x
+				&& point.y >= min.y && point.y <= max.y
+				&& point.z >= min.z && point.z <= max.z;
+		}
+
+		AABB expanded(float margin) const {
+			return { min - glm::vec3(margin), max + glm::vec3(margin) };
+		}
+
+		static AABB merge(const AABB& a, const AABB& b) {
+			return {
+				{ std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z) },
+				{ std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z) }
+			};
+		}
+
+		// Bounds of `local` once transformed by `transform` (conservative for rotations)
+		static AABB transform(const AABB& local, const glm::mat4& transform) {
+			glm::vec3 center = transform * glm::vec4(local.getCenter(), 1.0f);
+			glm::vec3 extents = local.getExtents();
+
+			glm::vec3 worldExtents;
+			for (int i = 0; i < 3; i++) {
+				worldExtents[i] = std::abs(transform[0][i]) * extents.x
+					+ std::abs(transform[1][i]) * extents.y
+					+ std::abs(transform[2][i]) * extents.z;
+			}
+
+			return { center - worldExtents, center + worldExtents };
+		}
+	};
+
+	struct Ray {
+		glm::vec3 origin = { 0.0f, 0.0f, 0.0f };
+		glm::vec3 direction = { 0.0f, 0.0f, -1.0f };	// Does not need to be normalized
+		float maxDistance = 1e30f;						// In units of direction
+
+		glm::vec3 at(float t) const { return origin + direction * t; }
+
+		// Slab test. Returns the entry distance along the ray, or a negative value on a miss
+		float intersect(const AABB& box, float maxT) const {
+			float tMin = 0.0f;
+			float tMax = maxT;
+
+			for (int i = 0; i < 3; i++) {
+				if (std::abs(direction[i]) < 1e-12f) {
+					if (origin[i] < box.min[i] || origin[i] > box.max[i])
+						return -1.0f;
+					continue;
+				}
+
+				float inv = 1.0f / direction[i];
+				float t0 = (box.min[i] - origin[i]) * inv;
+				float t1 = (box.max[i] - origin[i]) * inv;
+				if (t0 > t1)
+					std::swap(t0, t1);
+
+				tMin = std::max(tMin, t0);
+				tMax = std::min(tMax, t1);
+				if (tMin > tMax)
+					return -1.0f;
+			}
+
+			return tMin;
+		}
+	};
+
+	enum class FrustumTest {
+		Outside = 0, Intersects, Inside
+	};
+
+	// View frustum extracted from a view projection matrix (works for both ortho and perspective cameras)
+	struct Frustum {
+		glm::vec4 planes[6];	// xyz = normal pointing inside, w = distance
+
+		Frustum() = default;
+		Frustum(const glm::mat4& viewProjection) {
+			// Gribb & Hartmann: planes are combinations of the matrix rows
+			auto row = [&viewProjection](int i) {
+				return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+			};
+
+			planes[0] = row(3) + row(0);	// Left
+			planes[1] = row(3) - row(0);	// Right
+			planes[2] = row(3) + row(1);	// Bottom
+			planes[3] = row(3) - row(1);	// Top
+			planes[4] = row(3) + row(2);	// Near
+			planes[5] = row(3) - row(2);	// Far
+
+			for (auto& plane : planes) {
+				float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+				if (length > 0.0f)
+					plane = plane * (1.0f / length);
+			}
+		}
+
+		FrustumTest test(const AABB& box) const {
+			glm::vec3 center = box.getCenter();
+			glm::vec3 extents = box.getExtents();
+			FrustumTest result = FrustumTest::Inside;
+
+			for (const auto& plane : planes) {
+				float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+				float radius = std::abs(plane.x) * extents.x + std::abs(plane.y) * extents.y + std::abs(plane.z) * extents.z;
+
+				if (distance < -radius)
+					return FrustumTest::Outside;
+				if (distance < radius)
+					result = FrustumTest::Intersects;
+			}
+
+			return result;
+		}
+
+		bool intersects(const AABB& box) const { return test(box) != FrustumTest::Outside; }
+	};
+}
+
+#endif
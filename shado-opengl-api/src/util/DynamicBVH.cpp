@@ -0,0 +1,326 @@
+#include "DynamicBVH.h"
+
+#include "../Debug.h"
+
+namespace Shado {
+
+	// Fat AABBs are enlarged by this many times the predicted displacement
+	static constexpr float DISPLACEMENT_MULTIPLIER = 4.0f;
+
+	DynamicBVH::DynamicBVH(float margin)
+		: m_Margin(margin)
+	{
+		m_Nodes.reserve(16);
+	}
+
+	int32_t DynamicBVH::createProxy(const AABB& aabb, void* userData) {
+		int32_t proxyId = allocateNode();
+
+		Node& node = m_Nodes[proxyId];
+		node.aabb = aabb.expanded(m_Margin);
+		node.userData = userData;
+		node.height = 0;
+
+		insertLeaf(proxyId);
+		m_ProxyCount++;
+
+		return proxyId;
+	}
+
+	void DynamicBVH::destroyProxy(int32_t proxyId) {
+		SHADO_CORE_ASSERT(proxyId >= 0 && proxyId < (int32_t)m_Nodes.size(), "Invalid BVH proxy");
+		SHADO_CORE_ASSERT(m_Nodes[proxyId].isLeaf(), "BVH proxy is not a leaf");
+
+		removeLeaf(proxyId);
+		freeNode(proxyId);
+		m_ProxyCount--;
+	}
+
+	bool DynamicBVH::moveProxy(int32_t proxyId, const AABB& aabb, const glm::vec3& displacement) {
+		SHADO_CORE_ASSERT(proxyId >= 0 && proxyId < (int32_t)m_Nodes.size(), "Invalid BVH proxy");
+
+		Node& node = m_Nodes[proxyId];
+
+		// Predict where the proxy is heading so it doesn't get reinserted every frame
+		AABB fat = aabb.expanded(m_Margin);
+		glm::vec3 d = displacement * DISPLACEMENT_MULTIPLIER;
+		for (int i = 0; i < 3; i++) {
+			if (d[i] < 0.0f)
+				fat.min[i] += d[i];
+			else
+				fat.max[i] += d[i];
+		}
+
+		if (node.aabb.contains(aabb)) {
+			// Still inside the fat AABB, but reinsert if it has become much bigger than needed
+			// (e.g. the object stopped after moving fast)
+			AABB huge = fat.expanded(4.0f * m_Margin);
+			if (huge.contains(node.aabb))
+				return false;
+		}
+
+		removeLeaf(proxyId);
+		m_Nodes[proxyId].aabb = fat;
+		insertLeaf(proxyId);
+
+		return true;
+	}
+
+	void DynamicBVH::clear() {
+		m_Nodes.clear();
+		m_Root = NullNode;
+		m_FreeList = NullNode;
+		m_NodeCount = 0;
+		m_ProxyCount = 0;
+	}
+
+	int32_t DynamicBVH::allocateNode() {
+		if (m_FreeList == NullNode) {
+			m_Nodes.emplace_back();
+
+			// Chain the new node into the free list
+			m_Nodes.back().next = NullNode;
+			m_Nodes.back().height = -1;
+			m_FreeList = (int32_t)m_Nodes.size() - 1;
+		}
+
+		int32_t index = m_FreeList;
+		Node& node = m_Nodes[index];
+		m_FreeList = node.next;
+
+		node.parent = NullNode;
+		node.child1 = NullNode;
+		node.child2 = NullNode;
+		node.height = 0;
+		node.userData = nullptr;
+		m_NodeCount++;
+
+		return index;
+	}
+
+	void DynamicBVH::freeNode(int32_t index) {
+		Node& node = m_Nodes[index];
+		node.next = m_FreeList;
+		node.height = -1;
+		m_FreeList = index;
+		m_NodeCount--;
+	}
+
+	void DynamicBVH::insertLeaf(int32_t leaf) {
+		if (m_Root == NullNode) {
+			m_Root = leaf;
+			m_Nodes[leaf].parent = NullNode;
+			return;
+		}
+
+		// Find the best sibling using the surface area heuristic
+		const AABB leafAABB = m_Nodes[leaf].aabb;
+		int32_t index = m_Root;
+		while (!m_Nodes[index].isLeaf()) {
+			const Node& node = m_Nodes[index];
+			int32_t child1 = node.child1;
+			int32_t child2 = node.child2;
+
+			float area = node.aabb.getSurfaceArea();
+			float combinedArea = AABB::merge(node.aabb, leafAABB).getSurfaceArea();
+
+			// Cost of creating a new parent for this node and the new leaf
+			float cost = 2.0f * combinedArea;
+
+			// Minimum cost of pushing the leaf further down the tree
+			float inheritanceCost = 2.0f * (combinedArea - area);
+
+			auto descendCost = [&](int32_t child) {
+				const Node& c = m_Nodes[child];
+				float newArea = AABB::merge(leafAABB, c.aabb).getSurfaceArea();
+				if (c.isLeaf())
+					return newArea + inheritanceCost;
+				return newArea - c.aabb.getSurfaceArea() + inheritanceCost;
+			};
+
+			float cost1 = descendCost(child1);
+			float cost2 = descendCost(child2);
+
+			if (cost < cost1 && cost < cost2)
+				break;
+
+			index = cost1 < cost2 ? child1 : child2;
+		}
+
+		int32_t sibling = index;
+
+		// Create a new parent
+		int32_t oldParent = m_Nodes[sibling].parent;
+		int32_t newParent = allocateNode();
+		m_Nodes[newParent].parent = oldParent;
+		m_Nodes[newParent].aabb = AABB::merge(leafAABB, m_Nodes[sibling].aabb);
+		m_Nodes[newParent].height = m_Nodes[sibling].height + 1;
+		m_Nodes[newParent].child1 = sibling;
+		m_Nodes[newParent].child2 = leaf;
+		m_Nodes[sibling].parent = newParent;
+		m_Nodes[leaf].parent = newParent;
+
+		if (oldParent != NullNode) {
+			if (m_Nodes[oldParent].child1 == sibling)
+				m_Nodes[oldParent].child1 = newParent;
+			else
+				m_Nodes[oldParent].child2 = newParent;
+		} else {
+			m_Root = newParent;
+		}
+
+		// Walk back up the tree fixing heights and AABBs
+		index = m_Nodes[leaf].parent;
+		while (index != NullNode) {
+			index = balance(index);
+
+			Node& node = m_Nodes[index];
+			const Node& child1 = m_Nodes[node.child1];
+			const Node& child2 = m_Nodes[node.child2];
+
+			node.height = 1 + std::max(child1.height, child2.height);
+			node.aabb = AABB::merge(child1.aabb, child2.aabb);
+
+			index = node.parent;
+		}
+	}
+
+	void DynamicBVH::removeLeaf(int32_t leaf) {
+		if (leaf == m_Root) {
+			m_Root = NullNode;
+			return;
+		}
+
+		int32_t parent = m_Nodes[leaf].parent;
+		int32_t grandParent = m_Nodes[parent].parent;
+		int32_t sibling = m_Nodes[parent].child1 == leaf ? m_Nodes[parent].child2 : m_Nodes[parent].child1;
+
+		if (grandParent == NullNode) {
+			m_Root = sibling;
+			m_Nodes[sibling].parent = NullNode;
+			freeNode(parent);
+			return;
+		}
+
+		// Destroy the parent and connect the sibling to the grand parent
+		if (m_Nodes[grandParent].child1 == parent)
+			m_Nodes[grandParent].child1 = sibling;
+		else
+			m_Nodes[grandParent].child2 = sibling;
+		m_Nodes[sibling].parent = grandParent;
+		freeNode(parent);
+
+		int32_t index = grandParent;
+		while (index != NullNode) {
+			index = balance(index);
+
+			Node& node = m_Nodes[index];
+			const Node& child1 = m_Nodes[node.child1];
+			const Node& child2 = m_Nodes[node.child2];
+
+			node.aabb = AABB::merge(child1.aabb, child2.aabb);
+			node.height = 1 + std::max(child1.height, child2.height);
+
+			index = node.parent;
+		}
+	}
+
+	// Performs a left or right rotation if node A is imbalanced. Returns the new root of the subtree
+	int32_t DynamicBVH::balance(int32_t iA) {
+		Node& A = m_Nodes[iA];
+		if (A.isLeaf() || A.height < 2)
+			return iA;
+
+		int32_t iB = A.child1;
+		int32_t iC = A.child2;
+		Node& B = m_Nodes[iB];
+		Node& C = m_Nodes[iC];
+
+		int32_t balanceFactor = C.height - B.height;
+
+		// Rotate C up
+		auto rotateUp = [this, iA](int32_t iUp, int32_t iOther, bool upIsChild2) {
+			Node& A = m_Nodes[iA];
+			Node& up = m_Nodes[iUp];
+			Node& other = m_Nodes[iOther];
+
+			int32_t iF = up.child1;
+			int32_t iG = up.child2;
+			Node& F = m_Nodes[iF];
+			Node& G = m_Nodes[iG];
+
+			// Swap A and the node moving up
+			up.child1 = iA;
+			up.parent = A.parent;
+			A.parent = iUp;
+
+			if (up.parent != NullNode) {
+				if (m_Nodes[up.parent].child1 == iA)
+					m_Nodes[up.parent].child1 = iUp;
+				else
+					m_Nodes[up.parent].child2 = iUp;
+			} else {
+				m_Root = iUp;
+			}
+
+			// Keep the taller grand child above, give the other one to A
+			int32_t iKeep = F.height > G.height ? iF : iG;
+			int32_t iGive = F.height > G.height ? iG : iF;
+			up.child2 = iKeep;
+			if (upIsChild2)
+				A.child2 = iGive;
+			else
+				A.child1 = iGive;
+			m_Nodes[iGive].parent = iA;
+
+			A.aabb = AABB::merge(other.aabb, m_Nodes[iGive].aabb);
+			up.aabb = AABB::merge(A.aabb, m_Nodes[iKeep].aabb);
+
+			A.height = 1 + std::max(other.height, m_Nodes[iGive].height);
+			up.height = 1 + std::max(A.height, m_Nodes[iKeep].height);
+
+			return iUp;
+		};
+
+		if (balanceFactor > 1)
+			return rotateUp(iC, iB, true);
+
+		if (balanceFactor < -1)
+			return rotateUp(iB, iC, false);
+
+		return iA;
+	}
+
+	bool DynamicBVH::validate() const {
+		if (m_Root == NullNode)
+			return m_ProxyCount == 0;
+
+		if (m_Nodes[m_Root].parent != NullNode)
+			return false;
+
+		return validateStructure(m_Root) >= 0;
+	}
+
+	// Returns the height of the subtree, or -1 if something is wrong with it
+	int32_t DynamicBVH::validateStructure(int32_t index) const {
+		const Node& node = m_Nodes[index];
+		if (node.isLeaf())
+			return node.height == 0 ? 0 : -1;
+
+		const Node& child1 = m_Nodes[node.child1];
+		const Node& child2 = m_Nodes[node.child2];
+		if (child1.parent != index || child2.parent != index)
+			return -1;
+
+		if (!node.aabb.contains(child1.aabb) || !node.aabb.contains(child2.aabb))
+			return -1;
+
+		int32_t height1 = validateStructure(node.child1);
+		int32_t height2 = validateStructure(node.child2);
+		if (height1 < 0 || height2 < 0)
+			return -1;
+
+		int32_t height = 1 + std::max(height1, height2);
+		return height == node.height ? height : -1;
+	}
+}
@@ -0,0 +1,237 @@
+#pragma once
+
+#ifndef DYNAMIC_BVH_H
+#define DYNAMIC_BVH_H
+
+#include <cstdint>
+#include <vector>
+#include "Bounds.h"
+
+namespace Shado {
+
+	/**
+	 * Dynamic bounding volume hierarchy (AVL balanced, surface area heuristic on insert).
+	 * Leaves store "fat" AABBs so small movements don't touch the tree, moved proxies are
+	 * refitted by reinsertion. Proxy ids stay valid until destroyProxy is called.
+	 *
+	 * Query callbacks receive the proxy id and return false to stop the query early.
+	 */
+	class DynamicBVH {
+	public:
+		static constexpr int32_t NullNode = -1;
+
+		DynamicBVH(float margin = 0.1f);
+		~DynamicBVH() = default;
+
+		int32_t createProxy(const AABB& aabb, void* userData);
+		void destroyProxy(int32_t proxyId);
+
+		/**
+		 * Refits a proxy. Returns true if the proxy had to be reinserted.
+		 *
+		 * @param displacement expected movement until next update, used to enlarge the fat AABB
+		 */
+		bool moveProxy(int32_t proxyId, const AABB& aabb, const glm::vec3& displacement = { 0, 0, 0 });
+
+		void* getUserData(int32_t proxyId)			const { return m_Nodes[proxyId].userData; }
+		const AABB& getFatAABB(int32_t proxyId)		const { return m_Nodes[proxyId].aabb; }
+
+		template<typename Callback>
+		void queryRegion(const AABB& region, Callback callback) const;
+
+		template<typename Callback>
+		void queryPoint(const glm::vec3& point, Callback callback) const;
+
+		// Fully visible subtrees are reported without testing each leaf
+		template<typename Callback>
+		void queryFrustum(const Frustum& frustum, Callback callback) const;
+
+		/**
+		 * The callback is called for every proxy the ray's fat AABB hit, in no particular order, and returns
+		 * the new max distance of the ray: 0 stops the cast, ray.maxDistance (or the current one) keeps it going
+		 * and anything in between clips the ray (i.e. closest hit found so far).
+		 */
+		template<typename Callback>
+		void raycast(const Ray& ray, Callback callback) const;
+
+		void clear();
+
+		int32_t getHeight()		const { return m_Root == NullNode ? 0 : m_Nodes[m_Root].height; }
+		uint32_t getProxyCount() const { return m_ProxyCount; }
+		uint32_t getNodeCount()	const { return m_NodeCount; }
+
+		// Checks parent/child links and heights. Meant for debugging only
+		bool validate() const;
+
+	private:
+		struct Node {
+			AABB aabb;
+			void* userData = nullptr;
+
+			union {
+				int32_t parent;
+				int32_t next;	// When in the free list
+			};
+			int32_t child1 = NullNode;
+			int32_t child2 = NullNode;
+
+			int32_t height = -1;	// Leaf = 0, free node = -1
+
+			bool isLeaf() const { return child1 == NullNode; }
+		};
+
+		int32_t allocateNode();
+		void freeNode(int32_t node);
+
+		void insertLeaf(int32_t leaf);
+		void removeLeaf(int32_t leaf);
+		int32_t balance(int32_t index);
+
+		int32_t validateStructure(int32_t index) const;
+
+	private:
+		std::vector<Node> m_Nodes;
+		int32_t m_Root = NullNode;
+		int32_t m_FreeList = NullNode;
+		uint32_t m_NodeCount = 0;
+		uint32_t m_ProxyCount = 0;
+
+		float m_Margin;
+	};
+
+	// Small stack used by the traversals so queries never allocate for reasonable tree heights
+	class BVHTraversalStack {
+	public:
+		void push(int32_t value) {
+			if (m_Count == Capacity) {
+				m_Overflow.push_back(value);
+				return;
+			}
+			m_Stack[m_Count++] = value;
+		}
+
+		int32_t pop() {
+			if (!m_Overflow.empty()) {
+				int32_t value = m_Overflow.back();
+				m_Overflow.pop_back();
+				return value;
+			}
+			return m_Stack[--m_Count];
+		}
+
+		bool empty() const { return m_Count == 0 && m_Overflow.empty(); }
+
+	private:
+		static constexpr int Capacity = 256;
+		int32_t m_Stack[Capacity];
+		int m_Count = 0;
+		std::vector<int32_t> m_Overflow;
+	};
+
+	template<typename Callback>
+	void DynamicBVH::queryRegion(const AABB& region, Callback callback) const {
+		BVHTraversalStack stack;
+		stack.push(m_Root);
+
+		while (!stack.empty()) {
+			int32_t index = stack.pop();
+			if (index == NullNode)
+				continue;
+
+			const Node& node = m_Nodes[index];
+			if (!node.aabb.overlaps(region))
+				continue;
+
+			if (node.isLeaf()) {
+				if (!callback(index))
+					return;
+			} else {
+				stack.push(node.child1);
+				stack.push(node.child2);
+			}
+		}
+	}
+
+	template<typename Callback>
+	void DynamicBVH::queryPoint(const glm::vec3& point, Callback callback) const {
+		queryRegion(AABB(point, point), callback);
+	}
+
+	template<typename Callback>
+	void DynamicBVH::queryFrustum(const Frustum& frustum, Callback callback) const {
+		BVHTraversalStack stack;
+		stack.push(m_Root);
+
+		while (!stack.empty()) {
+			int32_t index = stack.pop();
+			if (index == NullNode)
+				continue;
+
+			const Node& node = m_Nodes[index];
+			FrustumTest result = frustum.test(node.aabb);
+			if (result == FrustumTest::Outside)
+				continue;
+
+			if (node.isLeaf()) {
+				if (!callback(index))
+					return;
+				continue;
+			}
+
+			if (result == FrustumTest::Inside) {
+				// Every leaf under this node is visible, no need to test them
+				BVHTraversalStack inside;
+				inside.push(index);
+				while (!inside.empty()) {
+					int32_t childIndex = inside.pop();
+					const Node& child = m_Nodes[childIndex];
+					if (child.isLeaf()) {
+						if (!callback(childIndex))
+							return;
+					} else {
+						inside.push(child.child1);
+						inside.push(child.child2);
+					}
+				}
+				continue;
+			}
+
+			stack.push(node.child1);
+			stack.push(node.child2);
+		}
+	}
+
+	template<typename Callback>
+	void DynamicBVH::raycast(const Ray& ray, Callback callback) const {
+		float maxDistance = ray.maxDistance;
+
+		BVHTraversalStack stack;
+		stack.push(m_Root);
+
+		while (!stack.empty()) {
+			int32_t index = stack.pop();
+			if (index == NullNode)
+				continue;
+
+			const Node& node = m_Nodes[index];
+			if (ray.intersect(node.aabb, maxDistance) < 0.0f)
+				continue;
+
+			if (node.isLeaf()) {
+				Ray clipped = ray;
+				clipped.maxDistance = maxDistance;
+
+				float value = callback(index, clipped);
+				if (value == 0.0f)
+					return;
+				if (value > 0.0f)
+					maxDistance = std::min(maxDistance, value);
+			} else {
+				stack.push(node.child1);
+				stack.push(node.child2);
+			}
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,65 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Shado {
+
+	static constexpr float Step = 0.05f;				// Scales are multiples of it
+	static constexpr float MaxStepUp = 0.1f;
+	static constexpr float Smoothing = 0.1f;			// Weight of a new sample in the average
+	static constexpr uint32_t CooldownFrames = 10;		// Longer than the timer latency
+
+	// Fractions of the target: aimed at, lowered above, raised below
+	static constexpr float Aim = 0.85f;
+	static constexpr float OverBudget = 0.95f;
+	static constexpr float Headroom = 0.7f;
+
+	DynamicResolutionController::DynamicResolutionController(float targetFrameTime, float minScale, float maxScale)
+		: m_TargetFrameTime(targetFrameTime), m_MinScale(minScale), m_MaxScale(maxScale), m_Scale(maxScale)
+	{
+	}
+
+	float DynamicResolutionController::update(float gpuTime) {
+		if (gpuTime <= 0.0f)
+			return m_Scale;
+
+		m_AverageTime = m_AverageTime > 0.0f ? m_AverageTime + (gpuTime - m_AverageTime) * Smoothing : gpuTime;
+
+		if (m_Cooldown > 0) {
+			m_Cooldown--;
+			return m_Scale;
+		}
+
+		if (m_AverageTime <= m_TargetFrameTime * OverBudget && m_AverageTime >= m_TargetFrameTime * Headroom)
+			return m_Scale;
+
+		float scale = m_Scale * std::sqrt(m_TargetFrameTime * Aim / m_AverageTime);
+		scale = std::min(scale, m_Scale + MaxStepUp);
+
+		// Rounded down, a raise never overshoots the aim
+		scale = std::floor(scale / Step + 1e-3f) * Step;
+		scale = std::clamp(scale, m_MinScale, m_MaxScale);
+
+		if (std::abs(scale - m_Scale) < Step * 0.5f)
+			return m_Scale;
+
+		// The average was measured at the old scale, carry it over instead of waiting for it to settle
+		m_AverageTime *= (scale * scale) / (m_Scale * m_Scale);
+		m_Scale = scale;
+		m_Cooldown = CooldownFrames;
+		return m_Scale;
+	}
+
+	void DynamicResolutionController::reset() {
+		m_Scale = m_MaxScale;
+		m_AverageTime = 0.0f;
+		m_Cooldown = 0;
+	}
+
+	void DynamicResolutionController::setScaleRange(float minScale, float maxScale) {
+		m_MinScale = minScale;
+		m_MaxScale = std::max(minScale, maxScale);
+		m_Scale = std::clamp(m_Scale, m_MinScale, m_MaxScale);
+	}
+}
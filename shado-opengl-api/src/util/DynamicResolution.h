@@ -0,0 +1,42 @@
+#pragma once
+
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#include <cstdint>
+
+namespace Shado {
+
+	/**
+	 * Picks a render scale to keep the GPU time of a frame under a target.
+	 *
+	 * The cost of a frame is taken as proportional to its pixel count, the scale to hit the target
+	 * is then scale * sqrt(target / time). It lowers as soon as the smoothed time is over budget and
+	 * rises by small steps once there is clear headroom. The scale is snapped to steps and held for
+	 * a few frames after each change: resizing reallocates the render target and the GPU times lag.
+	 */
+	class DynamicResolutionController {
+	public:
+		DynamicResolutionController(float targetFrameTime = 1000.0f / 60.0f, float minScale = 0.5f, float maxScale = 1.0f);
+
+		// GPU time of the last measured frame, in ms. Returns the scale to render at
+		float update(float gpuTime);
+		void reset();
+
+		void setTargetFrameTime(float ms) { m_TargetFrameTime = ms; }
+		void setScaleRange(float minScale, float maxScale);
+
+		float getTargetFrameTime() const { return m_TargetFrameTime; }
+		float getScale() const { return m_Scale; }
+
+	private:
+		float m_TargetFrameTime;
+		float m_MinScale, m_MaxScale;
+
+		float m_Scale;
+		float m_AverageTime = 0.0f;
+		uint32_t m_Cooldown = 0;
+	};
+}
+
+#endif
@@ -0,0 +1,127 @@
+#include "FrameLimiter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#ifdef SHADO_PLATFORM_WINDOWS
+#include <windows.h>
+#endif
+
+namespace Shado {
+
+	// =========================== FRAME LIMITER ===========================
+
+	FrameLimiter::FrameLimiter(float targetFPS) {
+#ifdef SHADO_PLATFORM_WINDOWS
+		// The default scheduler tick (~15.6 ms) makes Sleep useless for frame pacing
+		timeBeginPeriod(1);
+#endif
+		setTargetFPS(targetFPS);
+	}
+
+	FrameLimiter::~FrameLimiter() {
+#ifdef SHADO_PLATFORM_WINDOWS
+		timeEndPeriod(1);
+#endif
+	}
+
+	void FrameLimiter::setTargetFPS(float fps) {
+		m_TargetFPS = fps > 0.0f ? fps : 0.0f;
+		m_FrameDuration = m_TargetFPS > 0.0f
+			? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_TargetFPS))
+			: Clock::duration::zero();
+		m_NextFrame = Clock::now() + m_FrameDuration;
+	}
+
+	float FrameLimiter::wait() {
+		if (m_TargetFPS <= 0.0f)
+			return 0.0f;
+
+		const auto start = Clock::now();
+
+		if (start < m_NextFrame) {
+			sleepUntil(m_NextFrame);
+			m_NextFrame += m_FrameDuration;
+		} else {
+			// Late: aim a full frame from now, catching up would only make a burst of short frames
+			m_NextFrame = start + m_FrameDuration;
+		}
+
+		return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+	}
+
+	void FrameLimiter::sleepUntil(Clock::time_point deadline) {
+		using Seconds = std::chrono::duration<double>;
+
+		while (true) {
+			const double remaining = Seconds(deadline - Clock::now()).count();
+			const double deviation = std::sqrt(m_SleepM2 / m_SleepCount);
+			if (remaining <= m_SleepMean + deviation)
+				break;
+
+			const auto before = Clock::now();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			const double observed = Seconds(Clock::now() - before).count();
+
+			// Welford's online mean/variance, reset now and then so it follows the system's load
+			if (m_SleepCount >= 1000) {
+				m_SleepCount = 1;
+				m_SleepM2 = 0.0;
+			}
+			m_SleepCount++;
+			const double delta = observed - m_SleepMean;
+			m_SleepMean += delta / m_SleepCount;
+			m_SleepM2 += delta * (observed - m_SleepMean);
+		}
+
+		while (Clock::now() < deadline)
+			std::this_thread::yield();
+	}
+
+	// =========================== FRAME TIME HISTORY ===========================
+
+	FrameTimeHistory::FrameTimeHistory(uint32_t capacity)
+		: m_Capacity(capacity)
+	{
+		m_Samples.reserve(capacity);
+	}
+
+	void FrameTimeHistory::push(float frameTime) {
+		if (m_Samples.size() < m_Capacity) {
+			m_Samples.push_back(frameTime);
+			return;
+		}
+
+		m_Samples[m_Next] = frameTime;
+		m_Next = (m_Next + 1) % m_Capacity;
+	}
+
+	void FrameTimeHistory::clear() {
+		m_Samples.clear();
+		m_Next = 0;
+	}
+
+	FrameTimeHistory::Percentiles FrameTimeHistory::getPercentiles() const {
+		Percentiles result;
+		if (m_Samples.empty())
+			return result;
+
+		m_Scratch = m_Samples;
+		const size_t last = m_Scratch.size() - 1;
+		auto rank = [last](float percentile) { return (size_t)std::lround(percentile * last); };
+
+		// Each selection leaves the larger samples after it, the next one only searches those.
+		// It may move the previous pivot though, so read it first
+		auto p50 = m_Scratch.begin() + rank(0.50f);
+		auto p95 = m_Scratch.begin() + rank(0.95f);
+		auto p99 = m_Scratch.begin() + rank(0.99f);
+
+		std::nth_element(m_Scratch.begin(), p50, m_Scratch.end());
+		result.P50 = *p50;
+		std::nth_element(p50, p95, m_Scratch.end());
+		result.P95 = *p95;
+		std::nth_element(p95, p99, m_Scratch.end());
+		result.P99 = *p99;
+		return result;
+	}
+}
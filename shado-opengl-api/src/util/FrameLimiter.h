@@ -0,0 +1,76 @@
+#pragma once
+
+#ifndef FRAME_LIMITER_H
+#define FRAME_LIMITER_H
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace Shado {
+
+	/**
+	 * Caps the frame rate without burning a core.
+	 *
+	 * The OS sleep is only accurate to a millisecond or so, so the limiter sleeps in 1 ms slices while
+	 * the deadline is further than what a sleep usually overshoots by, then spins for the rest.
+	 * The overshoot estimate (mean + deviation of the past sleeps) adapts to the machine.
+	 */
+	class FrameLimiter {
+	public:
+		FrameLimiter(float targetFPS = 0.0f);
+		~FrameLimiter();
+
+		FrameLimiter(const FrameLimiter&) = delete;
+		FrameLimiter& operator=(const FrameLimiter&) = delete;
+
+		// 0 disables the limiter
+		void setTargetFPS(float fps);
+		float getTargetFPS() const { return m_TargetFPS; }
+
+		// Blocks until a target frame time has passed since the previous call. Returns the time waited, in ms
+		float wait();
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		void sleepUntil(Clock::time_point deadline);
+
+	private:
+		float m_TargetFPS = 0.0f;
+		Clock::duration m_FrameDuration = Clock::duration::zero();
+		Clock::time_point m_NextFrame;
+
+		// Running estimate of how long a 1 ms sleep actually takes, in seconds
+		double m_SleepMean = 0.002;
+		double m_SleepM2 = 0.0;
+		uint64_t m_SleepCount = 1;
+	};
+
+	// Frame times of the last frames, for percentiles
+	class FrameTimeHistory {
+	public:
+		FrameTimeHistory(uint32_t capacity = 512);
+
+		void push(float frameTime);
+		void clear();
+
+		uint32_t getCount() const { return (uint32_t)m_Samples.size(); }
+
+		struct Percentiles {
+			float P50 = 0.0f;
+			float P95 = 0.0f;
+			float P99 = 0.0f;
+		};
+		Percentiles getPercentiles() const;
+
+	private:
+		std::vector<float> m_Samples;
+		uint32_t m_Capacity;
+		uint32_t m_Next = 0;
+
+		mutable std::vector<float> m_Scratch;
+	};
+}
+
+#endif
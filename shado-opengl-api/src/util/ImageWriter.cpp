@@ -0,0 +1,117 @@
+#include "ImageWriter.h"
+
+#include <fstream>
+#include <vector>
+#include "Debug.h"
+
+namespace Shado {
+
+	static uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+		static uint32_t table[256] = {};
+		if (!table[1]) {
+			for (uint32_t i = 0; i < 256; i++) {
+				uint32_t c = i;
+				for (int k = 0; k < 8; k++)
+					c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+				table[i] = c;
+			}
+		}
+
+		crc = ~crc;
+		for (size_t i = 0; i < size; i++)
+			crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		return ~crc;
+	}
+
+	static void putU32(std::vector<uint8_t>& out, uint32_t value) {
+		out.push_back((uint8_t)(value >> 24));
+		out.push_back((uint8_t)(value >> 16));
+		out.push_back((uint8_t)(value >> 8));
+		out.push_back((uint8_t)value);
+	}
+
+	static void writeChunk(std::ofstream& file, const char type[4], const std::vector<uint8_t>& data) {
+		std::vector<uint8_t> chunk;
+		chunk.reserve(data.size() + 12);
+		putU32(chunk, (uint32_t)data.size());
+		chunk.insert(chunk.end(), type, type + 4);
+		chunk.insert(chunk.end(), data.begin(), data.end());
+		putU32(chunk, crc32(chunk.data() + 4, chunk.size() - 4));	// Type and data, not the length
+
+		file.write((const char*)chunk.data(), chunk.size());
+	}
+
+	bool writePNG(const std::string& path, uint32_t width, uint32_t height, uint32_t channels,
+		const uint8_t* pixels, bool flipVertically) {
+
+		SHADO_CORE_ASSERT(channels == 3 || channels == 4, "PNG must be RGB or RGBA");
+
+		std::ofstream file(path, std::ios::binary);
+		if (!file) {
+			SHADO_CORE_ERROR("Could not open {0} for writing", path);
+			return false;
+		}
+
+		static const uint8_t signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		file.write((const char*)signature, sizeof(signature));
+
+		std::vector<uint8_t> header;
+		putU32(header, width);
+		putU32(header, height);
+		header.push_back(8);							// Bit depth
+		header.push_back(channels == 4 ? 6 : 2);		// Color type
+		header.push_back(0);							// Compression
+		header.push_back(0);							// Filter
+		header.push_back(0);							// Interlace
+		writeChunk(file, "IHDR", header);
+
+		// Scanlines, each prefixed by its filter type (none)
+		const size_t rowSize = (size_t)width * channels;
+		std::vector<uint8_t> raw;
+		raw.reserve((rowSize + 1) * height);
+		for (uint32_t y = 0; y < height; y++) {
+			const uint8_t* row = pixels + rowSize * (flipVertically ? height - 1 - y : y);
+			raw.push_back(0);
+			raw.insert(raw.end(), row, row + rowSize);
+		}
+
+		// zlib stream made of stored deflate blocks
+		std::vector<uint8_t> data;
+		data.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+		data.push_back(0x78);
+		data.push_back(0x01);
+
+		size_t offset = 0;
+		do {
+			const size_t size = raw.size() - offset < 65535 ? raw.size() - offset : 65535;
+			const bool last = offset + size == raw.size();
+
+			data.push_back(last ? 1 : 0);
+			data.push_back((uint8_t)size);
+			data.push_back((uint8_t)(size >> 8));
+			data.push_back((uint8_t)~size);
+			data.push_back((uint8_t)(~size >> 8));
+			data.insert(data.end(), raw.begin() + offset, raw.begin() + offset + size);
+
+			offset += size;
+		} while (offset < raw.size());
+
+		// Adler-32, 5552 bytes is the most that can be summed before b could overflow
+		uint32_t a = 1, b = 0;
+		for (size_t i = 0; i < raw.size(); i += 5552) {
+			const size_t end = i + 5552 < raw.size() ? i + 5552 : raw.size();
+			for (size_t j = i; j < end; j++) {
+				a += raw[j];
+				b += a;
+			}
+			a %= 65521;
+			b %= 65521;
+		}
+		putU32(data, (b << 16) | a);
+
+		writeChunk(file, "IDAT", data);
+		writeChunk(file, "IEND", {});
+
+		return (bool)file;
+	}
+}
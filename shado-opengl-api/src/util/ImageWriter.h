@@ -0,0 +1,20 @@
+#pragma once
+
+#ifndef IMAGE_WRITER_H
+#define IMAGE_WRITER_H
+
+#include <cstdint>
+#include <string>
+
+namespace Shado {
+
+	/**
+	 * Writes 8 bit RGB (3 channels) or RGBA (4 channels) pixels as a PNG. The data is stored
+	 * without compression, this is meant for captures and tests, not assets.
+	 * GL reads rows bottom up, pass flipVertically to get the image the right way up
+	 */
+	bool writePNG(const std::string& path, uint32_t width, uint32_t height, uint32_t channels,
+		const uint8_t* pixels, bool flipVertically = false);
+}
+
+#endif
@@ -0,0 +1,67 @@
+#include "MappedFile.h"
+
+#ifdef SHADO_PLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Shado {
+
+	// The view keeps the file open, the handles are closed right after mapping it
+	MappedFile::MappedFile(const std::string& path) {
+#ifdef SHADO_PLATFORM_WINDOWS
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+			CloseHandle(file);
+			return;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);
+		if (!mapping)
+			return;
+
+		m_Data = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+		if (m_Data)
+			m_Size = (size_t)size.QuadPart;
+#else
+		int file = open(path.c_str(), O_RDONLY);
+		if (file < 0)
+			return;
+
+		struct stat info;
+		if (fstat(file, &info) != 0 || info.st_size == 0) {
+			close(file);
+			return;
+		}
+
+		void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		close(file);
+		if (data == MAP_FAILED)
+			return;
+
+		m_Data = (const uint8_t*)data;
+		m_Size = (size_t)info.st_size;
+#endif
+	}
+
+	MappedFile::~MappedFile() {
+		if (!m_Data)
+			return;
+
+#ifdef SHADO_PLATFORM_WINDOWS
+		UnmapViewOfFile(m_Data);
+#else
+		munmap((void*)m_Data, m_Size);
+#endif
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Shado {
+
+	/**
+	 * Read only view of a whole file mapped in memory. Nothing is read up front, the OS pages the file
+	 * in as it is touched and the data stays in its cache. An empty or missing file fails to open.
+	 */
+	class MappedFile {
+	public:
+		MappedFile(const std::string& path);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool isOpen() const { return m_Data != nullptr; }
+		explicit operator bool() const { return isOpen(); }
+
+		// Page aligned
+		const uint8_t* getData() const { return m_Data; }
+		size_t getSize() const { return m_Size; }
+
+	private:
+		const uint8_t* m_Data = nullptr;
+		size_t m_Size = 0;
+	};
+}
+
+#endif
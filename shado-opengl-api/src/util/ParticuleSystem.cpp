@@ -3,12 +3,18 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include "glm/gtx/compatibility.hpp"
 #include "Random.h"
+#include "../Debug.h"
 #include "../Renderer2D.h"
+#include "../JobSystem.h"
 
 namespace Shado {
 
-	ParticuleSystem::ParticuleSystem() {
-		m_ParticulePool.resize(1000);
+	// Particules updated per job, below that the pool is updated on the calling thread
+	static constexpr uint32_t UPDATE_BATCH_SIZE = 4096;
+
+	ParticuleSystem::ParticuleSystem(uint32_t maxParticules) {
+		SHADO_CORE_ASSERT(maxParticules > 0, "A particule system needs room for at least one particule");
+		m_ParticulePool.resize(maxParticules);
 	}
 
 	void ParticuleSystem::emit(const ParticuleProps& props) {
@@ -42,21 +48,23 @@ namespace Shado {
 
 	void ParticuleSystem::onUpdate(TimeStep ts) {
 
-		for (auto& particule : m_ParticulePool) {
-
-			if (!particule.Active)
-				continue;
+		JobSystem::ParallelFor((uint32_t)m_ParticulePool.size(), UPDATE_BATCH_SIZE, [this, ts](uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; i++) {
+				Particule& particule = m_ParticulePool[i];
 
-			if (particule.LifeRemaining <= 0.0f) {
-				particule.Active = false;
-				continue;
-			}
+				if (!particule.Active)
+					continue;
 
-			particule.LifeRemaining -= ts;
-			particule.position += particule.velocity * (float)ts;
-			particule.rotation.z += 0.01f * ts;
+				if (particule.LifeRemaining <= 0.0f) {
+					particule.Active = false;
+					continue;
+				}
 
-		}
+				particule.LifeRemaining -= ts;
+				particule.position += particule.velocity * (float)ts;
+				particule.rotation.z += 0.01f * ts;
+			}
+		});
 
 	}
 
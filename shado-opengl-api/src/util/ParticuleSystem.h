@@ -17,10 +17,11 @@ namespace Shado {
 	
 	class ParticuleSystem {
 	public:
-		ParticuleSystem();
+		ParticuleSystem(uint32_t maxParticules = 1000);
 
 		void emit(const ParticuleProps& props);
 
+		// Big pools are updated in parallel on the JobSystem
 		void onUpdate(TimeStep ts);
 		void onDraw();
 
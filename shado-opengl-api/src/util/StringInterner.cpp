@@ -0,0 +1,35 @@
+#include "StringInterner.h"
+
+#include "../Debug.h"
+
+namespace Shado {
+
+	InternedString StringInterner::intern(const std::string& string) {
+		auto [it, inserted] = m_Ids.try_emplace(string, None);
+		if (!inserted)
+			return it->second;
+
+		if (!m_FreeIds.empty()) {
+			it->second = m_FreeIds.back();
+			m_FreeIds.pop_back();
+			m_Strings[it->second] = &it->first;
+		} else {
+			it->second = (InternedString)m_Strings.size();
+			m_Strings.push_back(&it->first);
+		}
+		return it->second;
+	}
+
+	InternedString StringInterner::find(const std::string& string) const {
+		auto it = m_Ids.find(string);
+		return it != m_Ids.end() ? it->second : None;
+	}
+
+	void StringInterner::release(InternedString id) {
+		SHADO_CORE_ASSERT(id < m_Strings.size() && m_Strings[id], "String already released");
+
+		m_Ids.erase(m_Ids.find(*m_Strings[id]));
+		m_Strings[id] = nullptr;
+		m_FreeIds.push_back(id);
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#ifndef STRING_INTERNER_H
+#define STRING_INTERNER_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Shado {
+
+	using InternedString = uint32_t;
+
+	/**
+	 * Gives every distinct string a small id, so strings can be stored, hashed and compared as integers.
+	 * It doesn't count who holds an id: the owner releases a string once nothing refers to it anymore,
+	 * its id is then given to the next new string.
+	 */
+	class StringInterner {
+	public:
+		static constexpr InternedString None = 0xFFFFFFFF;
+
+		InternedString intern(const std::string& string);
+		// Doesn't add it, None if it was never interned or was released
+		InternedString find(const std::string& string) const;
+		void release(InternedString id);
+
+		// Valid until the string is released
+		const std::string& get(InternedString id) const { return *m_Strings[id]; }
+		uint32_t getCount() const { return (uint32_t)m_Ids.size(); }
+
+	private:
+		std::unordered_map<std::string, InternedString> m_Ids;
+		std::vector<const std::string*> m_Strings;		// Keys of m_Ids, the nodes don't move. Null once released
+		std::vector<InternedString> m_FreeIds;
+	};
+}
+
+#endif
@@ -0,0 +1,187 @@
+#include "TimerWheel.h"
+
+#include <algorithm>
+#include <cmath>
+#include "../Debug.h"
+
+namespace Shado {
+
+	TimerWheel::TimerWheel() {
+		std::fill(std::begin(m_Lists), std::end(m_Lists), None);
+	}
+
+	TimerHandle TimerWheel::schedule(std::function<void()> callback, uint64_t delayMs, uint64_t intervalMs) {
+		SHADO_CORE_ASSERT(callback, "A timer needs a callback");
+
+		uint32_t index;
+		if (!m_Free.empty()) {
+			index = m_Free.back();
+			m_Free.pop_back();
+		} else {
+			index = (uint32_t)m_Timers.size();
+			m_Timers.emplace_back();
+		}
+
+		Timer& timer = m_Timers[index];
+		timer.Callback = std::move(callback);
+		timer.Expiry = m_Now + std::max<uint64_t>(delayMs, 1);
+		timer.Interval = intervalMs;
+		timer.Active = true;
+		insert(index);
+
+		m_Count++;
+		return { index, timer.Generation };
+	}
+
+	bool TimerWheel::cancel(TimerHandle handle) {
+		if (!isActive(handle))
+			return false;
+
+		// Firing: it's released once its callback returns, the slot can't be reused before
+		if (m_Timers[handle.Index].List == None) {
+			m_Timers[handle.Index].Active = false;
+			return true;
+		}
+
+		unlink(handle.Index);
+		release(handle.Index);
+		return true;
+	}
+
+	bool TimerWheel::isActive(TimerHandle handle) const {
+		return handle.Index < m_Timers.size() && m_Timers[handle.Index].Generation == handle.Generation
+			&& m_Timers[handle.Index].Active;
+	}
+
+	void TimerWheel::advance(double milliseconds) {
+		m_Remainder += std::max(milliseconds, 0.0);
+		uint64_t ticks = (uint64_t)std::floor(m_Remainder);
+		m_Remainder -= (double)ticks;
+
+		while (ticks > 0) {
+			// Nothing to find in the slots, skip ahead
+			if (m_Count == 0) {
+				m_Now += ticks;
+				break;
+			}
+
+			m_Now++;
+			ticks--;
+			tick();
+		}
+	}
+
+	void TimerWheel::clear() {
+		for (uint32_t index = 0; index < m_Timers.size(); index++) {
+			Timer& timer = m_Timers[index];
+			if (!timer.Active)
+				continue;
+
+			if (timer.List == None) {
+				timer.Active = false;
+			} else {
+				unlink(index);
+				release(index);
+			}
+		}
+	}
+
+	void TimerWheel::tick() {
+		// On a level boundary the next slot of the level above is spread over the levels below,
+		// from the top down so a timer can fall through several levels on the same tick
+		uint32_t top = 0;
+		while (top + 1 < Levels && (m_Now & ((1ull << (SlotBits * (top + 1))) - 1)) == 0)
+			top++;
+		for (uint32_t level = top; level > 0; level--)
+			cascade(level);
+
+		// Moved aside first, the callbacks may schedule into the slot being processed
+		uint32_t& slot = m_Lists[m_Now & (SlotCount - 1)];
+		while (slot != None) {
+			uint32_t index = slot;
+			unlink(index);
+			link(index, FiringList);
+		}
+
+		while (m_Lists[FiringList] != None) {
+			const uint32_t index = m_Lists[FiringList];
+			unlink(index);
+
+			// The pool may grow during the callback, the timer is looked up again after it
+			std::function<void()> callback = std::move(m_Timers[index].Callback);
+			callback();
+
+			Timer& timer = m_Timers[index];
+			if (timer.Active && timer.Interval > 0) {
+				timer.Callback = std::move(callback);
+				timer.Expiry = std::max(timer.Expiry + timer.Interval, m_Now + 1);
+				insert(index);
+			} else {
+				release(index);
+			}
+		}
+	}
+
+	void TimerWheel::cascade(uint32_t level) {
+		const uint32_t list = level * SlotCount + (uint32_t)((m_Now >> (SlotBits * level)) & (SlotCount - 1));
+
+		uint32_t index = m_Lists[list];
+		m_Lists[list] = None;
+		while (index != None) {
+			const uint32_t next = m_Timers[index].Next;
+			m_Timers[index].List = None;
+			insert(index);
+			index = next;
+		}
+	}
+
+	void TimerWheel::insert(uint32_t index) {
+		const Timer& timer = m_Timers[index];
+
+		// The first level where the expiry is less than a full turn ahead. Comparing the slot numbers
+		// rather than the delay keeps a timer from landing in the slot that was just cascaded
+		for (uint32_t level = 0; level < Levels; level++) {
+			const uint32_t shift = SlotBits * level;
+			if ((timer.Expiry >> shift) - (m_Now >> shift) < SlotCount) {
+				link(index, level * SlotCount + (uint32_t)((timer.Expiry >> shift) & (SlotCount - 1)));
+				return;
+			}
+		}
+
+		// Further than the wheel reaches, parked in the last slot of the top level and placed again from there
+		const uint32_t shift = SlotBits * (Levels - 1);
+		link(index, (Levels - 1) * SlotCount + (uint32_t)(((m_Now >> shift) + SlotCount - 1) & (SlotCount - 1)));
+	}
+
+	void TimerWheel::link(uint32_t index, uint32_t list) {
+		Timer& timer = m_Timers[index];
+		timer.List = list;
+		timer.Prev = None;
+		timer.Next = m_Lists[list];
+		if (timer.Next != None)
+			m_Timers[timer.Next].Prev = index;
+		m_Lists[list] = index;
+	}
+
+	void TimerWheel::unlink(uint32_t index) {
+		Timer& timer = m_Timers[index];
+		if (timer.Prev != None)
+			m_Timers[timer.Prev].Next = timer.Next;
+		else
+			m_Lists[timer.List] = timer.Next;
+		if (timer.Next != None)
+			m_Timers[timer.Next].Prev = timer.Prev;
+
+		timer.Prev = timer.Next = None;
+		timer.List = None;
+	}
+
+	void TimerWheel::release(uint32_t index) {
+		Timer& timer = m_Timers[index];
+		timer.Callback = nullptr;
+		timer.Active = false;
+		timer.Generation++;
+		m_Free.push_back(index);
+		m_Count--;
+	}
+}
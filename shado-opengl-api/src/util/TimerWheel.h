@@ -0,0 +1,84 @@
+#pragma once
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace Shado {
+
+	struct TimerHandle {
+		uint32_t Index = 0xFFFFFFFF;
+		uint32_t Generation = 0;
+	};
+
+	/**
+	 * Hierarchical timing wheel with a 1 ms tick: 4 levels of 256 slots, each slot a list of timers.
+	 * Level 0 holds the timers due in the next 256 ms, level n those due in the next 256^(n+1) ms.
+	 * When level 0 wraps around, the next slot of level 1 is spread over level 0, and so on.
+	 * Scheduling and cancelling are O(1), advancing costs one slot per tick plus the timers due.
+	 *
+	 * Timers live in a pool and are linked through indices. A handle keeps the generation of its
+	 * timer, so cancelling a timer that already fired (and whose slot was reused) does nothing.
+	 *
+	 * Not thread safe: the Application's wheel is advanced on the main thread once per frame and
+	 * the callbacks run there, they can touch the scene, GL or Box2D.
+	 */
+	class TimerWheel {
+	public:
+		TimerWheel();
+
+		TimerWheel(const TimerWheel&) = delete;
+		TimerWheel& operator=(const TimerWheel&) = delete;
+
+		// Due in delayMs (at the earliest on the next tick), then every intervalMs if not 0
+		TimerHandle schedule(std::function<void()> callback, uint64_t delayMs, uint64_t intervalMs = 0);
+		// Also from the timer's own callback. False if the timer already fired or was cancelled
+		bool cancel(TimerHandle handle);
+		bool isActive(TimerHandle handle) const;
+
+		// Fires the timers due tick by tick. Fractions of a tick carry over to the next call
+		void advance(double milliseconds);
+		void clear();
+
+		uint64_t getTime() const { return m_Now; }
+		uint32_t getTimerCount() const { return m_Count; }
+
+	private:
+		static constexpr uint32_t Levels = 4;
+		static constexpr uint32_t SlotBits = 8;
+		static constexpr uint32_t SlotCount = 1 << SlotBits;
+		static constexpr uint32_t FiringList = Levels * SlotCount;	// Timers due on the tick being processed
+		static constexpr uint32_t None = 0xFFFFFFFF;
+
+		struct Timer {
+			std::function<void()> Callback;
+			uint64_t Expiry = 0;
+			uint64_t Interval = 0;
+			uint32_t Prev = None, Next = None;
+			uint32_t List = None;			// Slot holding it, None when free or firing
+			uint32_t Generation = 0;
+			bool Active = false;
+		};
+
+		void tick();
+		void cascade(uint32_t level);
+		void insert(uint32_t index);
+		void link(uint32_t index, uint32_t list);
+		void unlink(uint32_t index);
+		void release(uint32_t index);
+
+	private:
+		std::vector<Timer> m_Timers;
+		std::vector<uint32_t> m_Free;
+		uint32_t m_Lists[FiringList + 1];	// Heads
+
+		uint64_t m_Now = 0;
+		double m_Remainder = 0.0;
+		uint32_t m_Count = 0;
+	};
+}
+
+#endif
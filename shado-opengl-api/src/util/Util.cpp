@@ -1,5 +1,6 @@
 #include "Util.h"
 
+#include "../Application.h"
 #include "../Debug.h"
 
 
@@ -108,36 +109,27 @@ namespace Shado {
 	// =========================== OTHERS ==============================
 
 	IntervalObject setInterval(std::function<void()> task, unsigned long interval) {
+		SHADO_CORE_ASSERT(interval > 0, "An interval can't be 0 ms");
+		return IntervalObject(Application::get().getTimers().schedule(std::move(task), interval, interval));
+	}
 
-		bool* flag = new bool(true);
-
-		// TODO: Make it a shared Pointer
-		std::thread* thread = new std::thread([=]() {
-			while (*flag) {
-				std::this_thread::sleep_for(std::chrono::milliseconds(interval));
-				task();
-			}
-			});
-		thread->detach();
-
-		IntervalObject obj(thread, flag);
+	void IntervalObject::terminate() {
+		Application::get().getTimers().cancel(handle);
+	}
 
-		return obj;
+	bool IntervalObject::isActive() const {
+		return Application::get().getTimers().isActive(handle);
 	}
 
 	TimeoutObject setTimeout(std::function<void()> task, unsigned long startAfterMS) {
+		return TimeoutObject(Application::get().getTimers().schedule(std::move(task), startAfterMS));
+	}
 
-		bool* flag = new bool(true);
-
-		std::thread thread([=]() {
-			std::this_thread::sleep_for(std::chrono::milliseconds(startAfterMS));
-			if (*flag)
-				task();
-			});
-		thread.detach();
-
-		TimeoutObject obj(&thread, flag);
+	void TimeoutObject::cancel() {
+		Application::get().getTimers().cancel(handle);
+	}
 
-		return obj;
-	}	
+	bool TimeoutObject::isActive() const {
+		return Application::get().getTimers().isActive(handle);
+	}
 }
@@ -5,11 +5,14 @@
 #include <functional>
 #include <string>
 #include <thread>
+#ifdef SHADO_PLATFORM_WINDOWS
 #include <windows.h>
+#endif
 #include "glm/vec3.hpp"
 #include "glm/vec4.hpp"
 #include <locale>
 #include <filesystem>
+#include "TimerWheel.h"
 
 #define FILE_PATH std::filesystem::current_path().u8string()
 
@@ -71,38 +74,34 @@ namespace Shado {
 		double m_ms;
 	};
 
+	// setInterval and setTimeout go through the Application's TimerWheel: the task runs on the main
+	// thread, between frames. Stopping a timer that already ended does nothing
 	struct IntervalObject {
 
-		IntervalObject(std::thread* t, bool* flag)
-			: id(rand() % UINT64_MAX), thread(t), executing(flag)
+		IntervalObject(TimerHandle handle)
+			: handle(handle)
 		{}
 
-		void terminate() {
-			*executing = false;
-		}
+		void terminate();
+		bool isActive() const;
 
 	private:
-		const uint64_t id;
-		std::thread* thread;
-		bool* executing;
+		TimerHandle handle;
 	};
 
 	IntervalObject setInterval(std::function<void()> task, unsigned long intervalMS);
 
 	struct TimeoutObject {
 
-		TimeoutObject(std::thread* t, bool* flag)
-			: id(rand() % UINT64_MAX), thread(t), executing(flag)
+		TimeoutObject(TimerHandle handle)
+			: handle(handle)
 		{}
 
-		void cancel() {
-			*executing = false;
-		}
+		void cancel();
+		bool isActive() const;
 
 	private:
-		const uint64_t id;
-		std::thread* thread;
-		bool* executing;
+		TimerHandle handle;
 	};
 	TimeoutObject setTimeout(std::function<void()> task, unsigned long startAfterMS);
 }